@@ -2,6 +2,7 @@
 
 #include "SQLParser.h"
 #include "common/exception.hpp"
+#include "index/index_key.hpp"
 #include "meta/schema.hpp"
 #include "query/binder/binder.hpp"
 #include "query/binder/statement/create_statement.hpp"
@@ -53,6 +54,18 @@ void DB::ExecuteQuery([[maybe_unused]] Transaction &txn, const std::string &quer
 void DB::HandleCreateStatement([[maybe_unused]] Transaction &txn, const CreateStatement &stmt) {
 	std::unique_lock<std::shared_mutex> l(catalog_lock_);
 	const auto schema = Schema {stmt.columns_};
+	// the key of a composite primary key sorts by its columns in the order they are listed
+	std::vector<Column> key_cols;
+	for (const auto &primary_key : stmt.primary_key_) {
+		const auto key_col_it =
+		    std::ranges::find_if(schema.GetColumns(), [&](const Column &col) { return col.GetName() == primary_key; });
+		assert(key_col_it != schema.GetColumns().end() && "Broken invariant pk col not found");
+		key_cols.push_back(*key_col_it);
+	}
+	// a key too wide for the index throws here, before there is a table left without its primary key index
+	if (!key_cols.empty()) {
+		IndexKeyLayout::CheckKeyWidth(key_cols);
+	}
 	const auto &table_oid_opt = catalog_->CreateTable(stmt.table_name_, schema);
 	if (!table_oid_opt.has_value()) {
 		const auto &table_meta = catalog_->GetTableByName(stmt.table_name_);
@@ -60,14 +73,9 @@ void DB::HandleCreateStatement([[maybe_unused]] Transaction &txn, const CreateSt
 		    fmt::format("Failed to create table: table already exists with schema: {}", table_meta.schema_));
 	}
 	const auto &table_name = stmt.table_name_;
-	if (!stmt.primary_key_.empty()) {
-		assert(stmt.primary_key_.size() == 1 && "Only support one primary key");
-		const auto &primary_key = stmt.primary_key_.at(0);
-		const auto key_col_it =
-		    std::ranges::find_if(schema.GetColumns(), [&](const Column &col) { return col.GetName() == primary_key; });
-		assert(key_col_it != schema.GetColumns().end() && "Broken invariant pk col not found");
-		const auto index_oid =
-		    catalog_->CreateIndex(table_name + "_pk", table_name, *key_col_it, true, IndexType::BPlusTreeIndex, *bpm_);
+	if (!key_cols.empty()) {
+		const auto index_oid = catalog_->CreateIndex(table_name + "_pk", table_name, std::move(key_cols), true,
+		                                             IndexType::BPlusTreeIndex, *bpm_);
 		if (!index_oid.has_value()) {
 			throw RuntimeException("Failed to create primary key index");
 		}
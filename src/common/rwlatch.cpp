@@ -0,0 +1,127 @@
+#include "common/rwlatch.hpp"
+
+#include "common/config.hpp"
+
+#include <chrono>
+#include <thread>
+
+namespace db {
+namespace {
+// spinning only pays off if the holder can run at the same time
+uint32_t SpinLimit() {
+	static const uint32_t spin_limit = std::thread::hardware_concurrency() > 1 ? LATCH_SPIN_LIMIT : 0;
+	return spin_limit;
+}
+
+void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__)
+	asm volatile("yield");
+#endif
+}
+
+uint64_t NanosSince(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+} // namespace
+
+void ReaderWriterLatch::Wait(uint32_t state, uint32_t &spins) {
+	if (spins < SpinLimit()) {
+		spins++;
+		CpuRelax();
+		return;
+	}
+	// the state changed in the meantime, the caller has to look at it again before parking
+	if ((state & PARKED) == 0 &&
+	    !state_.compare_exchange_strong(state, state | PARKED, std::memory_order_relaxed)) {
+		return;
+	}
+	state_.wait(state | PARKED, std::memory_order_relaxed);
+}
+
+void ReaderWriterLatch::RecordWait(uint64_t nanos) {
+	wait_count_.fetch_add(1, std::memory_order_relaxed);
+	wait_nanos_.fetch_add(nanos, std::memory_order_relaxed);
+}
+
+void ReaderWriterLatch::RLockSlow() {
+	auto start = std::chrono::steady_clock::now();
+	bool waited = false;
+	uint32_t spins = 0;
+	uint32_t state = state_.load(std::memory_order_relaxed);
+	while (true) {
+		if ((state & READER_BLOCKING) == 0) {
+			// a failed exchange means another reader got in first, which does not count as waiting
+			if (state_.compare_exchange_weak(state, state + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+				break;
+			}
+			continue;
+		}
+		waited = true;
+		Wait(state, spins);
+		state = state_.load(std::memory_order_relaxed);
+	}
+	if (waited) {
+		RecordWait(NanosSince(start));
+	}
+}
+
+void ReaderWriterLatch::WLockSlow() {
+	auto start = std::chrono::steady_clock::now();
+	uint32_t spins = 0;
+	uint32_t state = state_.load(std::memory_order_relaxed);
+	while (true) {
+		if ((state & ~(WRITER_WAITING | PARKED)) == 0) {
+			// other waiting writers set WRITER_WAITING again the next time they look at the state
+			if (state_.compare_exchange_weak(state, WRITER | (state & PARKED), std::memory_order_acquire,
+			                                 std::memory_order_relaxed)) {
+				break;
+			}
+			continue;
+		}
+		if ((state & WRITER_WAITING) == 0) {
+			if (!state_.compare_exchange_weak(state, state | WRITER_WAITING, std::memory_order_relaxed)) {
+				continue;
+			}
+			state |= WRITER_WAITING;
+		}
+		Wait(state, spins);
+		state = state_.load(std::memory_order_relaxed);
+	}
+	RecordWait(NanosSince(start));
+}
+
+bool ReaderWriterLatch::Upgrade() {
+	uint32_t state = state_.load(std::memory_order_relaxed);
+	do {
+		// two holders waiting for each other to leave would never finish
+		if ((state & UPGRADING) != 0) {
+			return false;
+		}
+	} while (!state_.compare_exchange_weak(state, state | UPGRADING, std::memory_order_relaxed));
+
+	auto start = std::chrono::steady_clock::now();
+	bool waited = false;
+	uint32_t spins = 0;
+	state = state_.load(std::memory_order_relaxed);
+	while (true) {
+		if ((state & READER_MASK) == 1) {
+			// we are the last reader, trade the shared hold and the upgrade flag for the exclusive one
+			if (state_.compare_exchange_weak(state, WRITER | (state & (WRITER_WAITING | PARKED)),
+			                                 std::memory_order_acquire, std::memory_order_relaxed)) {
+				break;
+			}
+			continue;
+		}
+		waited = true;
+		Wait(state, spins);
+		state = state_.load(std::memory_order_relaxed);
+	}
+	if (waited) {
+		RecordWait(NanosSince(start));
+	}
+	BeginWrite();
+	return true;
+}
+} // namespace db
@@ -95,6 +95,25 @@ void Value::SerializeTo(data_ptr_t storage) const {
 	}
 }
 
+std::strong_ordering Value::Compare(const Value &other) const {
+	if (type_id_ != other.type_id_) {
+		throw RuntimeException("Cannot compare values of different types");
+	}
+	switch (type_id_) {
+	case TypeId::BOOLEAN:
+		return std::get<int8_t>(value_) <=> std::get<int8_t>(other.value_);
+	case TypeId::INTEGER:
+		return std::get<int32_t>(value_) <=> std::get<int32_t>(other.value_);
+	case TypeId::TIMESTAMP:
+		return std::get<uint64_t>(value_) <=> std::get<uint64_t>(other.value_);
+	case TypeId::VARCHAR:
+		return std::get<std::string>(value_) <=> std::get<std::string>(other.value_);
+	case TypeId::INVALID:
+		throw RuntimeException("Invalid type");
+	}
+	std::unreachable();
+}
+
 auto Value::ToString() const -> std::string {
 	switch (type_id_) {
 	case TypeId::BOOLEAN:
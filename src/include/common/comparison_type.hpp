@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <utility>
+namespace db {
+enum class ComparisonType { Equal, NotEqual, LessThan, LessThanOrEqual, GreaterThan, GreaterThanOrEqual };
+class ComparisonTypeHelper {
+public:
+	static std::string ToString(ComparisonType type) {
+		switch (type) {
+		case ComparisonType::Equal:
+			return "=";
+		case ComparisonType::NotEqual:
+			return "!=";
+		case ComparisonType::LessThan:
+			return "<";
+		case ComparisonType::LessThanOrEqual:
+			return "<=";
+		case ComparisonType::GreaterThan:
+			return ">";
+		case ComparisonType::GreaterThanOrEqual:
+			return ">=";
+		}
+		std::unreachable();
+	}
+	// the comparison with its operands swapped, a < b is b > a
+	static ComparisonType Flip(ComparisonType type) {
+		switch (type) {
+		case ComparisonType::Equal:
+		case ComparisonType::NotEqual:
+			return type;
+		case ComparisonType::LessThan:
+			return ComparisonType::GreaterThan;
+		case ComparisonType::LessThanOrEqual:
+			return ComparisonType::GreaterThanOrEqual;
+		case ComparisonType::GreaterThan:
+			return ComparisonType::LessThan;
+		case ComparisonType::GreaterThanOrEqual:
+			return ComparisonType::LessThanOrEqual;
+		}
+		std::unreachable();
+	}
+};
+
+} // namespace db
@@ -10,8 +10,36 @@ static constexpr page_id_t INVALID_PAGE_ID = -1; // invalid page id
 static constexpr table_oid_t INVALID_TABLE_OID = -1;
 static constexpr uint32_t PAGE_SIZE = 4096; // size of a data page in byte
 const std::string DEFAULT_DB_NAME = "gavindb";
-static constexpr uint32_t DEFAULT_POOL_SIZE = 10;
-static constexpr uint32_t INDEX_KEY_SIZE = 8;
+static constexpr uint32_t DEFAULT_POOL_SIZE = 1024; // frames of the buffer pool of a DB unless configured
+static constexpr uint32_t LRUK_REPLACER_K = 2; // k used by the lru-k replacer
+static constexpr uint32_t BUFFER_POOL_SHARD_COUNT = 16; // number of latch partitions of the buffer pool
+// a shard needs enough frames to hold every page an operation pins at once, e.g. a b+tree split path
+static constexpr uint32_t BUFFER_POOL_MIN_FRAMES_PER_SHARD = 64;
+static constexpr uint32_t BACKGROUND_WRITER_INTERVAL_MS = 50; // pause between two rounds of the background writer
+static constexpr uint32_t BACKGROUND_WRITER_MAX_PAGES = 64;   // pages written per shard and round
+static constexpr uint32_t READ_AHEAD_WINDOW = 8; // pages prefetched ahead of a sequential scan, 0 disables read-ahead
+static constexpr uint32_t BUFFER_RING_SIZE = 32;  // frames a bulk scan recycles instead of going through the replacer
+static constexpr uint32_t BUFFER_RING_MAX_POOL_FRACTION = 8; // a ring never takes more than 1/8 of the pool
+static constexpr uint32_t IO_URING_QUEUE_DEPTH = 64; // requests DiskManager keeps in flight at once
+static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024; // frame arenas of a multiple of this try huge pages
+static constexpr uint32_t LATCH_SPIN_LIMIT = 128; // spins on a held latch before the thread parks
+static constexpr uint32_t FSM_CATEGORY_SIZE = PAGE_SIZE / 256; // free bytes the free-space map rounds down to
+static constexpr uint32_t TABLE_HEAP_MAX_BUSY_PAGES = 4; // latched pages an insert skips before extending the heap
+// share of the tuples of a heap page that must be deleted for a vacuum to compact the page
+static constexpr double VACUUM_DELETED_RATIO = 0.2;
+// tuples larger than this have their largest varchar values moved to overflow pages until they are not
+static constexpr uint32_t TUPLE_OVERFLOW_THRESHOLD = PAGE_SIZE / 4;
+static constexpr uint32_t VARCHAR_OVERFLOW_FLAG = 1U << 31; // set in the length of a varchar kept in overflow pages
+// varchar bytes a PAX page sets aside per tuple and varchar column when it decides how many tuples it holds
+static constexpr uint32_t PAX_VARCHAR_SPACE = 32;
+static constexpr uint32_t BULK_INSERT_BATCH_SIZE = 1024; // tuples an insert hands to the table heap at once
+static constexpr uint32_t INDEX_MAX_KEY_SIZE = PAGE_SIZE / 8; // widest key of an index, so that b+tree nodes fan out
+// optimistic b+tree lookups that ran into a writer before a lookup falls back to latching
+static constexpr uint32_t BTREE_OPTIMISTIC_READ_ATTEMPTS = 4;
+// frames optimistic b+tree lookups remember their pages to be in, per index
+static constexpr uint32_t BTREE_FRAME_HINT_COUNT = 1024;
+// share of a b+tree node a bulk load fills, the rest is left for later inserts so they do not split every node
+static constexpr double BTREE_BULK_LOAD_FILL_FACTOR = 0.9;
 static constexpr uint32_t VARCHAR_DEFAULT_LENGTH = 128; // default length for varchar when constructing the column
 static constexpr table_oid_t SYSTEM_CATALOG_ID = -1;
 static constexpr timestamp_t INVALID_TS = -1;
@@ -14,9 +14,12 @@ namespace db {
 
 class DB {
 public:
-	explicit DB([[maybe_unused]] const std::string &db_file_name)
+	// the buffer pool starts with pool_size frames and can be resized up to max_pool_size frames at runtime
+	explicit DB([[maybe_unused]] const std::string &db_file_name, frame_id_t pool_size = DEFAULT_POOL_SIZE,
+	            frame_id_t max_pool_size = 0)
 	    : catalog_(std::make_unique<Catalog>()), disk_manager_(std::make_shared<DiskManager>(*catalog_)),
-	      bpm_(std::make_unique<BufferPool>(DEFAULT_POOL_SIZE, *disk_manager_)),
+	      bpm_(std::make_unique<BufferPool>(pool_size, *disk_manager_, ReplacerType::LRU_K, LRUK_REPLACER_K,
+	                                        BUFFER_POOL_SHARD_COUNT, true, max_pool_size)),
 	      execution_engine_(std::make_unique<ExecutionEngine>()), txn_manager_(std::make_unique<TransactionManager>()) {
 		      // DeletePathIfExists(db::FilePathManager::GetInstance().GetDatabaseRootPath());
 	      };
@@ -25,6 +28,9 @@ public:
 
 	void HandleCreateStatement(Transaction &txn, const CreateStatement &stmt);
 	void ExecuteQuery([[maybe_unused]] Transaction &txn, const std::string &query);
+	void ResizeBufferPool(frame_id_t pool_size) {
+		bpm_->Resize(pool_size);
+	}
 
 private:
 	void SetUpInternalSystemCatalogTable();
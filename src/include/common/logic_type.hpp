@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+#include <utility>
+namespace db {
+enum class LogicType { And, Or };
+class LogicTypeHelper {
+public:
+	static std::string ToString(LogicType type) {
+		switch (type) {
+		case LogicType::And:
+			return "AND";
+		case LogicType::Or:
+			return "OR";
+		}
+		std::unreachable();
+	}
+};
+
+} // namespace db
@@ -1,25 +1,128 @@
 #pragma once
 
-#include <shared_mutex>
+#include <atomic>
+#include <cstdint>
+#include <optional>
 
 namespace db {
-class ReaderWriterLatch {
+/**
+ * ReaderWriterLatch is a compact shared/exclusive latch built on a single state word. An uncontended acquisition is one
+ * compare and swap, a contended one spins for a short while and then parks the thread on the state word until the
+ * holder releases it. Waiting writers hold back new readers so that a stream of readers cannot starve them.
+ *
+ * A shared holder can upgrade to exclusive without releasing the latch, which only one of the holders may attempt at a
+ * time. The latch counts how often and for how long threads had to wait for it, which only costs on the slow path.
+ *
+ * The version counter supports optimistic readers, which take no latch at all: they snapshot the version, read, and
+ * validate the version afterwards. Writers make the version odd while they hold the latch.
+ */
+class alignas(32) ReaderWriterLatch {
 public:
 	void WLock() {
-		mutex_.lock();
+		uint32_t expected = 0;
+		if (!state_.compare_exchange_strong(expected, WRITER, std::memory_order_acquire)) {
+			WLockSlow();
+		}
+		BeginWrite();
+	}
+	// take the latch exclusive only if nobody holds or waits for it, never waits
+	[[nodiscard]] bool TryWLock() {
+		uint32_t expected = 0;
+		if (!state_.compare_exchange_strong(expected, WRITER, std::memory_order_acquire)) {
+			return false;
+		}
+		BeginWrite();
+		return true;
 	}
 	void WUnlock() {
-		mutex_.unlock();
+		version_.fetch_add(1, std::memory_order_release);
+		if ((state_.fetch_and(~(WRITER | PARKED), std::memory_order_release) & PARKED) != 0) {
+			state_.notify_all();
+		}
 	}
 	void RLock() {
-		mutex_.lock_shared();
+		uint32_t state = state_.load(std::memory_order_relaxed);
+		if ((state & READER_BLOCKING) != 0 ||
+		    !state_.compare_exchange_strong(state, state + 1, std::memory_order_acquire)) {
+			RLockSlow();
+		}
 	}
 	void RUnlock() {
-		mutex_.unlock_shared();
+		uint32_t state = state_.fetch_sub(1, std::memory_order_release);
+		// the last reader lets a waiting writer in, the second to last a waiting upgrader
+		if ((state & PARKED) != 0 && (state & READER_MASK) <= 2) {
+			state_.fetch_and(~PARKED, std::memory_order_relaxed);
+			state_.notify_all();
+		}
+	}
+	// turn a shared hold into an exclusive one once every other reader left. false if another holder is already
+	// upgrading, the caller then still holds the latch shared and has to release it to let the other upgrade finish
+	[[nodiscard]] bool Upgrade();
+
+	// start an optimistic read, which takes no latch and writes nothing. empty while a writer holds the latch
+	[[nodiscard]] std::optional<uint64_t> ReadVersion() const {
+		auto version = version_.load(std::memory_order_acquire);
+		if ((version & 1) != 0) {
+			return std::nullopt;
+		}
+		return version;
+	}
+	// whether no writer latched the data since ReadVersion returned version, only then is what was read consistent
+	[[nodiscard]] bool ValidateVersion(uint64_t version) const {
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return version_.load(std::memory_order_relaxed) == version;
+	}
+	// bracket a write by someone who keeps the other writers out by other means than the latch, which optimistic
+	// readers then see like a writer holding the latch
+	void BeginUnlatchedWrite() {
+		BeginWrite();
+	}
+	void EndUnlatchedWrite() {
+		version_.fetch_add(1, std::memory_order_release);
+	}
+
+	// acquisitions that could not take the latch right away
+	[[nodiscard]] uint32_t GetWaitCount() const {
+		return wait_count_.load(std::memory_order_relaxed);
+	}
+	// total time spent waiting for the latch
+	[[nodiscard]] uint64_t GetWaitNanos() const {
+		return wait_nanos_.load(std::memory_order_relaxed);
+	}
+	void ResetStats() {
+		wait_count_.store(0, std::memory_order_relaxed);
+		wait_nanos_.store(0, std::memory_order_relaxed);
 	}
 
 private:
-	std::shared_mutex mutex_;
+	static constexpr uint32_t WRITER = 1U << 31;
+	// a holder is upgrading, new readers must wait so that the readers left drain
+	static constexpr uint32_t UPGRADING = 1U << 30;
+	// a writer is waiting, new readers must wait so that the readers left drain
+	static constexpr uint32_t WRITER_WAITING = 1U << 29;
+	// some thread is parked on the state word, whoever releases the latch has to wake it up
+	static constexpr uint32_t PARKED = 1U << 28;
+	static constexpr uint32_t READER_MASK = PARKED - 1;
+	static constexpr uint32_t READER_BLOCKING = WRITER | UPGRADING | WRITER_WAITING;
+
+	void BeginWrite() {
+		version_.fetch_add(1, std::memory_order_relaxed);
+		// the writes to the protected data must not become visible before the version turns odd
+		std::atomic_thread_fence(std::memory_order_release);
+	}
+	void WLockSlow();
+	void RLockSlow();
+	// one step of waiting for the latch: a spin while the spin budget lasts, then parking until the state differs
+	// from state
+	void Wait(uint32_t state, uint32_t &spins);
+	void RecordWait(uint64_t nanos);
+
+	std::atomic<uint32_t> state_ {0};
+	std::atomic<uint32_t> wait_count_ {0};
+	// bumped when a writer takes and when it releases the latch
+	std::atomic<uint64_t> version_ {0};
+	std::atomic<uint64_t> wait_nanos_ {0};
 };
+static_assert(sizeof(ReaderWriterLatch) == 32, "a latch must never straddle two cache lines");
 
 } // namespace db
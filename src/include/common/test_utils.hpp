@@ -1,7 +1,25 @@
+#pragma once
+
+#include "storage/page_allocator.hpp"
+#include "storage/table/table_meta.hpp"
+
 #include <array>
 #include <random>
 #include <string>
 namespace db {
+// hands out fresh pages at the end of a table's data file without going through a table heap or index
+class TestPageAllocator : public PageAllocator {
+public:
+	explicit TestPageAllocator(TableMeta &table_meta) : table_meta_(table_meta) {
+	}
+	PageId AllocatePage() override {
+		return {table_meta_.table_oid_, table_meta_.IncrementTableDataPageId()};
+	}
+
+private:
+	TableMeta &table_meta_;
+};
+
 [[nodiscard]] inline std::string GenerateRandomString(int min_size, int max_size) {
 	// Seed with a real random value, if available
 	std::random_device rand_device;
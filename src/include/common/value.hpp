@@ -5,11 +5,11 @@
 #include "common/exception.hpp"
 #include "common/logger.hpp"
 #include "common/type.hpp"
-#include "index/index_typdef.hpp"
 #include "storage/serializer/deserializer.hpp"
 #include "storage/serializer/serializer.hpp"
 
 #include <cassert>
+#include <compare>
 #include <cstdint>
 #include <cstring>
 #include <utility>
@@ -20,7 +20,7 @@ template <typename T>
 bool ValueIsCorrectType(TypeId type) {
 	switch (type) {
 	case TypeId::BOOLEAN:
-		return typeid(T) == typeid(uint8_t);
+		return typeid(T) == typeid(int8_t);
 	case TypeId::INTEGER:
 		return typeid(T) == typeid(int32_t);
 	case TypeId::TIMESTAMP:
@@ -62,6 +62,8 @@ public:
 
 	void SerializeTo(data_ptr_t storage) const;
 	[[nodiscard]] std::string ToString() const;
+	// order against a value of the same type
+	[[nodiscard]] std::strong_ordering Compare(const Value &other) const;
 
 	void Serialize(Serializer &serializer) const;
 	static Value Deserialize(Deserializer &deserializer);
@@ -87,12 +89,12 @@ public:
 			return {type_id, val};
 		}
 		case TypeId::TIMESTAMP: {
-			uint64_t val = *reinterpret_cast<const uint32_t *>(storage);
+			uint64_t val = *reinterpret_cast<const uint64_t *>(storage);
 			return {type_id, val};
 		}
 		case TypeId::VARCHAR: {
 			uint32_t var_len = *reinterpret_cast<const uint32_t *>(storage);
-			assert(var_len < PAGE_SIZE && "Invalid varchar length");
+			assert(!(var_len & VARCHAR_OVERFLOW_FLAG) && "overflowed varchar must be read from its overflow pages");
 			return {type_id, std::string(reinterpret_cast<const char *>(storage) + sizeof(uint32_t), var_len)};
 		}
 		case TypeId::INVALID: {
@@ -102,34 +104,6 @@ public:
 		std::unreachable();
 	}
 
-	[[nodiscard]] IndexKeyType ConvertToIndexKeyType() const {
-		IndexKeyType ret = {0};
-		switch (type_id_) {
-		case TypeId::BOOLEAN: {
-			memcpy(&ret, &value_, sizeof(int8_t));
-			return ret;
-		}
-		case TypeId::INTEGER: {
-			memcpy(&ret, &value_, sizeof(int32_t));
-			return ret;
-		}
-		case TypeId::TIMESTAMP: {
-			memcpy(&ret, &value_, sizeof(uint32_t));
-			return ret;
-		}
-		case TypeId::VARCHAR: {
-			memcpy(&ret, &value_, sizeof(IndexKeyType) - 1);
-			size_t var_len = std::get<std::string>(value_).size();
-			ret[std::min(var_len, sizeof(IndexKeyType) - 1)] = '\0';
-			return ret;
-		}
-		case TypeId::INVALID: {
-			throw RuntimeException("Invalid type");
-		}
-		}
-		std::unreachable();
-	}
-
 	template <typename T>
 	[[nodiscard]] T GetAs() const {
 		return std::get<T>(value_);
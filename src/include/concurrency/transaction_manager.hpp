@@ -3,6 +3,12 @@
 #include "common/exception.hpp"
 #include "concurrency/transaction.hpp"
 #include "concurrency/watermark.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
 namespace db {
 class TransactionManager {
 public:
@@ -11,7 +11,14 @@
 #include "storage/page/btree_leaf_page.hpp"
 #include "storage/page/page_guard.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 namespace db {
 
 // Define the trait to identify leaf and internal pages
@@ -29,8 +36,71 @@ struct IsInternalPage<BtreeInternalPage> : std::true_type {};
 template <typename T>
 concept IsBtreeNode = std::is_same_v<T, BtreeLeafPage> || std::is_same_v<T, BtreeInternalPage>;
 
+class BTreeIndex;
+
+/**
+ * BTreeIndexIterator walks the keys of a BTreeIndex in key order along the chain of leaves. It keeps the leaf it is on
+ * pinned and read latched, and latches the next leaf before it lets go of the current one, so that no split slips in
+ * between. Leaves only link forward: stepping back past the first key of a leaf descends from the root again, to the
+ * leaf holding the keys before it.
+ *
+ * As the iterator holds a latch, the thread using it must not write to the index until it is destroyed or at the end.
+ */
+class BTreeIndexIterator {
+public:
+	// the end
+	BTreeIndexIterator() = default;
+	BTreeIndexIterator(BTreeIndex &index, Page &leaf, idx_t slot) : index_(&index), leaf_(&leaf), slot_(slot) {
+	}
+	BTreeIndexIterator(const BTreeIndexIterator &) = delete;
+	BTreeIndexIterator &operator=(const BTreeIndexIterator &) = delete;
+	BTreeIndexIterator(BTreeIndexIterator &&other) noexcept
+	    : index_(other.index_), leaf_(std::exchange(other.leaf_, nullptr)), slot_(other.slot_) {
+	}
+	BTreeIndexIterator &operator=(BTreeIndexIterator &&other) noexcept {
+		if (this != &other) {
+			Release();
+			index_ = other.index_;
+			leaf_ = std::exchange(other.leaf_, nullptr);
+			slot_ = other.slot_;
+		}
+		return *this;
+	}
+	~BTreeIndexIterator() {
+		Release();
+	}
+
+	[[nodiscard]] bool IsEnd() const {
+		return leaf_ == nullptr;
+	}
+	// the key in place on the leaf, valid until the iterator moves
+	[[nodiscard]] IndexKeyView GetKey() const {
+		return leaf_->As<BtreeLeafPage>().KeyAt(slot_);
+	}
+	[[nodiscard]] IndexValueType GetValue() const {
+		return leaf_->As<BtreeLeafPage>().ValueAt(slot_);
+	}
+
+	BTreeIndexIterator &operator++();
+	BTreeIndexIterator &operator--();
+
+private:
+	friend class BTreeIndex;
+	// move on along the chain while the slot is past the last key of the leaf
+	void SkipExhaustedLeaves();
+	void Release();
+
+	BTreeIndex *index_ {nullptr};
+	Page *leaf_ {nullptr};
+	idx_t slot_ {0};
+};
+
 class BTreeIndex : public Index {
 	enum class Operation { SEARCH, INSERT, DELETE };
+	// how an optimistic lookup ended, a lookup that met a page out of the pool latches its way down instead of trying
+	// again, another try would miss the page just the same
+	enum class OptimisticRead { DONE, RESTART, MISS };
+	friend class BTreeIndexIterator;
 
 public:
 	BTreeIndex(IndexMeta &index_meta, TableMeta &table_meta, BufferPool &bpm)
@@ -52,18 +122,184 @@ public:
 			LOG_DEBUG("header page id already exist and is not invalid: {}", index_meta_.header_page_id_);
 		}
 		assert(index_meta_.header_page_id_ >= 0);
-		assert(comparator_ != nullptr);
+	}
+
+	// optimistic lookups that had to be restarted because a writer modified a page they read
+	[[nodiscard]] uint64_t GetOptimisticRestartCount() const {
+		return optimistic_restart_count_;
+	}
+	// lookups that gave up on optimistic reads and latched their way down the tree
+	[[nodiscard]] uint64_t GetPessimisticLookupCount() const {
+		return pessimistic_lookup_count_;
+	}
+	// point lookups read the tree without latches first, turning that off leaves them all to latching, to compare
+	void SetOptimisticLookups(bool enabled) {
+		optimistic_lookups_ = enabled;
+	}
+
+	// an iterator on the first key not less than the key, or on the first key of the index without one
+	BTreeIndexIterator Begin(std::optional<IndexKeyView> key = std::nullopt) {
+		auto *leaf = FindLeafForRead(key, false);
+		if (leaf == nullptr) {
+			return {};
+		}
+		auto slot = key.has_value() ? leaf->As<BtreeLeafPage>().FindKeyIndex(*key) : 0;
+		BTreeIndexIterator it {*this, *leaf, slot};
+		it.SkipExhaustedLeaves();
+		return it;
+	}
+
+	// an iterator on the last key not greater than the key, or on the last key of the index without one, to scan
+	// backward from
+	BTreeIndexIterator RBegin(std::optional<IndexKeyView> key = std::nullopt) {
+		auto *leaf = FindLeafForRead(key, !key.has_value());
+		if (leaf == nullptr) {
+			return {};
+		}
+		const auto &leaf_node = leaf->As<BtreeLeafPage>();
+		auto slot = key.has_value() ? leaf_node.FindKeyIndex(*key) : leaf_node.GetSize();
+		// step over the key itself
+		if (key.has_value() && slot < leaf_node.GetSize() && comparator_(leaf_node.KeyAt(slot), *key) == 0) {
+			slot++;
+		}
+		if (slot > 0) {
+			return {*this, *leaf, slot - 1};
+		}
+		// the keys of the leaf are all greater, or the tree is a single empty leaf
+		leaf->RUnlatch();
+		bpm_.UnpinPage(leaf->GetPageId(), false);
+		return key.has_value() ? SeekBefore(*key) : BTreeIndexIterator {};
 	}
 
 protected:
-	bool InternalScanKey(const IndexKeyType key, std::vector<IndexValueType> &values) override {
+	bool InternalScanKey(IndexKeyView key, std::vector<IndexValueType> &values) override {
+		std::optional<IndexValueType> value;
+		bool found = false;
+		for (uint32_t attempt = 0; optimistic_lookups_ && attempt < BTREE_OPTIMISTIC_READ_ATTEMPTS && !found; attempt++) {
+			auto result = OptimisticScanKey(key, value);
+			found = result == OptimisticRead::DONE;
+			if (result == OptimisticRead::MISS) {
+				break;
+			}
+			if (!found) {
+				optimistic_restart_count_++;
+				// let the writer in the way finish instead of spinning into it again
+				std::this_thread::yield();
+			}
+		}
+		if (!found) {
+			pessimistic_lookup_count_++;
+			value = PessimisticScanKey(key);
+		}
+		if (!value.has_value()) {
+			return false;
+		}
+		values.push_back(value.value());
+		return true;
+	}
 
+	// descend from the header to the leaf without pinning or latching anything, validating every page read against
+	// its version before acting on it. the version of a child is taken before its parent is validated again, so a child
+	// split away from under the lookup is noticed. restart if a writer got in the way and the lookup must be retried. a
+	// page out of the pool is not read in, the page id may name a page a merge just deleted
+	OptimisticRead OptimisticScanKey(IndexKeyView key, std::optional<IndexValueType> &value) {
+		Page *page;
+		uint64_t version;
+		auto result = PeekPage(index_meta_.header_page_id_, page, version);
+		if (result != OptimisticRead::DONE) {
+			return result;
+		}
+		auto child_page_id = page->As<BtreeHeaderPage>().GetRootPageId();
+		while (true) {
+			// a page id read from a page modified in the meantime may not even exist
+			if (!page->ValidateVersion(version)) {
+				return OptimisticRead::RESTART;
+			}
+			if (child_page_id == INVALID_PAGE_ID) {
+				value = std::nullopt;
+				return OptimisticRead::DONE;
+			}
+			Page *child_page;
+			uint64_t child_version;
+			result = PeekPage(child_page_id, child_page, child_version);
+			if (result != OptimisticRead::DONE) {
+				return result;
+			}
+			if (!page->ValidateVersion(version)) {
+				return OptimisticRead::RESTART;
+			}
+			page = child_page;
+			version = child_version;
+
+			const auto &node = page->As<BtreePage>();
+			if (!IsSearchable(node)) {
+				return OptimisticRead::RESTART;
+			}
+			if (node.IsLeafPage()) {
+				value = page->As<BtreeLeafPage>().Lookup(key);
+				return page->ValidateVersion(version) ? OptimisticRead::DONE : OptimisticRead::RESTART;
+			}
+			child_page_id = page->As<BtreeInternalPage>().Lookup(key);
+		}
+	}
+
+	// find the frame holding the page and take its version, through the frame the page was last found in. nothing is
+	// written unless that frame holds another page by now, then the buffer pool is asked once and the hint updated. the
+	// frame may be given to another page at any time, validating the version after reading it proves it was not
+	OptimisticRead PeekPage(page_id_t page_number, Page *&page, uint64_t &version) {
+		const PageId page_id {table_meta_.table_oid_, page_number};
+		auto &hint = frame_hints_[static_cast<uint32_t>(page_number) % BTREE_FRAME_HINT_COUNT];
+		page = hint.load(std::memory_order_relaxed);
+		for (int attempt = 0; attempt < 2; attempt++) {
+			if (page != nullptr) {
+				auto page_version = page->ReadVersion();
+				bool is_page = page->GetPageId() == page_id;
+				if (page_version.has_value() && is_page) {
+					version = *page_version;
+					return OptimisticRead::DONE;
+				}
+				if (is_page) {
+					// a writer has the page latched
+					return OptimisticRead::RESTART;
+				}
+			}
+			page = bpm_.FetchPageIfResident(page_id);
+			if (page == nullptr) {
+				return OptimisticRead::MISS;
+			}
+			bpm_.UnpinPage(page_id, false);
+			hint.store(page, std::memory_order_relaxed);
+		}
+		return OptimisticRead::RESTART;
+	}
+
+	// whether a node read without a latch can be searched without running off its page. a frame given to another page
+	// in the meantime may hold anything, which only the version validation after the search rules out
+	[[nodiscard]] bool IsSearchable(const BtreePage &node) const {
+		const auto key_size = key_layout_.GetKeySize();
+		if (node.GetKeySize() != key_size) {
+			return false;
+		}
+		if (node.GetPageType() == IndexPageType::LEAF_PAGE) {
+			return node.GetSize() <= BtreeLeafPage::GetMaxSizeFor(key_size);
+		}
+		return node.GetPageType() == IndexPageType::INTERNAL_PAGE && node.GetSize() > 0 &&
+		       node.GetSize() <= BtreeInternalPage::GetMaxSizeFor(key_size);
+	}
+
+	std::optional<IndexValueType> PessimisticScanKey(IndexKeyView key) {
 		auto &header_raw_page = bpm_.FetchPage({table_meta_.table_oid_, index_meta_.header_page_id_});
 		header_raw_page.RLatch();
+		if (header_raw_page.As<BtreeHeaderPage>().TreeIsEmpty()) {
+			header_raw_page.RUnlatch();
+			bpm_.UnpinPage(header_raw_page.GetPageId(), false);
+			return std::nullopt;
+		}
 		// TODO lol
 		Transaction transaction {0, IsolationLevel::READ_COMMITTED};
 
 		auto &leaf_raw_page = SearchLeafPage(key, Operation::SEARCH, transaction, header_raw_page);
+		bpm_.UnpinPage(header_raw_page.GetPageId(), false);
 
 		LOG_TRACE("Traversed to leaf page found with page id: {}", leaf_raw_page.GetPageId().page_number_);
 
@@ -72,23 +308,80 @@ protected:
 		// remove later
 		LOG_TRACE("leaf: %s", leaf_page.ToString().c_str());
 
-		auto value = leaf_page.Lookup(key, comparator_);
+		auto value = leaf_page.Lookup(key);
 
 		leaf_raw_page.RUnlatch();
 		bpm_.UnpinPage(leaf_raw_page.GetPageId(), false);
-
-		if (!value.has_value()) {
-			return false;
-		}
-		values.push_back(value.value());
-		return true;
+		return value;
 	}
 	// if tree is empty, create empty leaf node (also the root)
 	// else find the leaf node that should contain the key value
 	// if key has less than n. key values, insert
 	// if has n. keys, split the leaf
 	// create node L'
-	bool InternalInsertRecord(Transaction &txn, const IndexKeyType key, const IndexValueType value) override {
+	void InternalScanRange(const std::optional<IndexKeyBound> &low, const std::optional<IndexKeyBound> &high,
+	                       bool reverse, std::vector<IndexValueType> &values) override {
+		const auto &from = reverse ? high : low;
+		const auto &to = reverse ? low : high;
+		// how far past the bound the key is in the direction of the scan
+		auto past = [this, reverse](IndexKeyView key, IndexKeyView bound) {
+			return reverse ? comparator_(bound, key) : comparator_(key, bound);
+		};
+		auto it = reverse ? RBegin(from.transform([](const auto &bound) { return IndexKeyView(bound.first); }))
+		                  : Begin(from.transform([](const auto &bound) { return IndexKeyView(bound.first); }));
+		auto step = [reverse](BTreeIndexIterator &it) { reverse ? --it : ++it; };
+		if (from.has_value() && !from->second && !it.IsEnd() && comparator_(it.GetKey(), from->first) == 0) {
+			step(it);
+		}
+		for (; !it.IsEnd(); step(it)) {
+			if (to.has_value()) {
+				auto distance = past(it.GetKey(), to->first);
+				if (distance > 0 || (distance == 0 && !to->second)) {
+					break;
+				}
+			}
+			values.push_back(it.GetValue());
+		}
+	}
+
+	// build the tree bottom up. the entries are appended to the leaves in key order and each node goes up to its parent
+	// as soon as it has its share, so every page is written once and no page is read. the shares are worked out ahead
+	// for every level, so that the nodes of a level are filled evenly and none falls below its minimum size
+	void InternalBulkLoad(const std::vector<std::pair<IndexKeyType, IndexValueType>> &entries,
+	                      double fill_factor) override {
+		auto header_guard = bpm_.FetchPageWrite({table_meta_.table_oid_, index_meta_.header_page_id_});
+		auto &header_page = header_guard.AsMut<BtreeHeaderPage>();
+		if (!header_page.TreeIsEmpty()) {
+			throw RuntimeException("Bulk load into an index that is not empty");
+		}
+		if (entries.empty()) {
+			return;
+		}
+		const auto leaf_max_size = BtreeLeafPage::GetMaxSizeFor(key_layout_.GetKeySize());
+		const auto internal_max_size = BtreeInternalPage::GetMaxSizeFor(key_layout_.GetKeySize());
+		std::vector<BulkLoadLevel> levels;
+		idx_t entry_count = entries.size();
+		while (levels.empty() || levels.back().node_count_ > 1) {
+			const bool is_leaf = levels.empty();
+			// a leaf splits as soon as it is full, an internal page only once it would overflow
+			const idx_t max_size = is_leaf ? leaf_max_size - 1 : internal_max_size;
+			const idx_t min_size = is_leaf ? leaf_max_size / 2 : (internal_max_size + 1) / 2;
+			const auto per_node = std::clamp(static_cast<idx_t>(fill_factor * max_size), min_size, max_size);
+			// as many nodes as the fill factor asks for, but not so many that they would fall below the minimum
+			const auto node_count =
+			    std::max<idx_t>(1, std::min((entry_count + per_node - 1) / per_node, entry_count / min_size));
+			levels.push_back({entry_count, node_count});
+			entry_count = node_count;
+		}
+		LOG_DEBUG("Bulk loading {} keys into {} leaves and {} levels", entries.size(), levels.front().node_count_,
+		          levels.size());
+		for (const auto &[key, value] : entries) {
+			BulkLoadAppend<BtreeLeafPage>(levels, 0, {key, value}, header_page);
+		}
+		assert(!header_page.TreeIsEmpty() && "root of the bulk load was not reached");
+	}
+
+	bool InternalInsertRecord(Transaction &txn, IndexKeyView key, const IndexValueType value) override {
 		// latch the root page
 		auto &header_raw_page = bpm_.FetchPage({table_meta_.table_oid_, index_meta_.header_page_id_});
 		header_raw_page.WLatch();
@@ -107,7 +400,7 @@ protected:
 		return InsertIntoLeaf(key, value, txn, header_raw_page);
 	}
 
-	bool InsertIntoLeaf(const IndexKeyType &key, const IndexValueType &value, Transaction &transaction,
+	bool InsertIntoLeaf(IndexKeyView key, const IndexValueType &value, Transaction &transaction,
 	                    Page &header_page) {
 		auto &leaf_page = SearchLeafPage(key, Operation::INSERT, transaction, header_page);
 		auto &leaf_node = leaf_page.AsMut<BtreeLeafPage>();
@@ -115,7 +408,7 @@ protected:
 		          static_cast<int>(leaf_node.GetMaxSize()));
 
 		auto size = leaf_node.GetSize();
-		leaf_node.Insert(key, value, comparator_);
+		leaf_node.Insert(key, value);
 		auto new_size = leaf_node.GetSize();
 
 		// need to split and push to parent
@@ -128,7 +421,7 @@ protected:
 			sibling_leaf_node.SetNextPageId(leaf_node.GetNextPageId());
 			leaf_node.SetNextPageId(sibling_leaf_node.GetPageId());
 
-			const auto &risen_key = sibling_leaf_node.KeyAt(0);
+			const auto risen_key = sibling_leaf_node.KeyAt(0);
 			LOG_TRACE("Insert leaf node {} into internal parent {} with risen key %s", leaf_node.GetPageId(),
 			          leaf_node.GetParentPageId(), IndexKeyTypeToString(risen_key).c_str());
 			InsertIntoParent(leaf_node, sibling_leaf_node, risen_key, transaction, header_page);
@@ -149,7 +442,7 @@ protected:
 
 		return new_size != size;
 	}
-	bool InternalDeleteRecord(Transaction &txn, const IndexKeyType key) override {
+	bool InternalDeleteRecord(Transaction &txn, IndexKeyView key) override {
 		auto &header_raw_page = bpm_.FetchPage({table_meta_.table_oid_, index_meta_.header_page_id_});
 		header_raw_page.WLatch();
 		LOG_TRACE("Adding header page id {} into page set (header)", header_raw_page.GetPageId().page_number_);
@@ -164,13 +457,136 @@ protected:
 
 		auto &leaf_page = SearchLeafPage(key, Operation::DELETE, txn, header_raw_page);
 		auto &leaf_node = leaf_page.AsMut<BtreeLeafPage>();
+		if (!leaf_node.Remove(key)) {
+			ReleaseParentWriteLatches(txn);
+			leaf_page.WUnlatch();
+			bpm_.UnpinPage(leaf_page.GetPageId(), false);
+			return false;
+		}
+		// a root leaf may become empty and stays as the empty tree, other nodes stay at least half full
+		if (!leaf_node.IsRootPage() && leaf_node.GetSize() < leaf_node.GetMinSize()) {
+			HandleUnderflow(leaf_page, txn);
+			return true;
+		}
+		ReleaseParentWriteLatches(txn);
+		leaf_page.WUnlatch();
+		bpm_.UnpinPage(leaf_page.GetPageId(), true);
+		return true;
+	}
 
-		(void)leaf_node;
+	// the node fell below its minimum size: borrow an entry from a sibling, or merge the two if they fit in one page,
+	// going up as long as merges leave parents below their minimum. the node is write latched and so is its parent, the
+	// last page of the page set, which is only left with unsafe ancestors. the latches of the node and the page set are
+	// released
+	void HandleUnderflow(Page &node_page, Transaction &transaction) {
+		const auto table_oid = table_meta_.table_oid_;
+		auto &page_set = *transaction.GetPageSet();
+		assert(!page_set.empty() && "parent of the node is not latched");
+		auto &parent_page = page_set.back().get();
+		page_set.pop_back();
+		auto &parent = parent_page.AsMut<BtreeInternalPage>();
+		auto node_index = parent.ValueIndex(node_page.As<BtreePage>().GetPageId());
+		assert(node_index < parent.GetSize() && "node is not a child of its parent");
+
+		// pair the node with its left sibling unless it is the first child. siblings are latched from left to right
+		// like iterators go along the leaves, the parent latch keeps writers off the node in between
+		const bool node_is_left = node_index == 0;
+		auto &sibling_page = bpm_.FetchPage({table_oid, parent.ValueAt(node_is_left ? 1 : node_index - 1)});
+		if (!node_is_left) {
+			node_page.WUnlatch();
+		}
+		sibling_page.WLatch();
+		if (!node_is_left) {
+			node_page.WLatch();
+		}
+		auto &left_page = node_is_left ? node_page : sibling_page;
+		auto &right_page = node_is_left ? sibling_page : node_page;
+		const idx_t separator_index = node_is_left ? 1 : node_index;
+
+		bool merged;
+		if (node_page.As<BtreePage>().IsLeafPage()) {
+			merged = MergeOrRedistribute(left_page.AsMut<BtreeLeafPage>(), right_page.AsMut<BtreeLeafPage>(), parent,
+			                             separator_index, node_is_left);
+		} else {
+			merged = MergeOrRedistribute(left_page.AsMut<BtreeInternalPage>(),
+			                             right_page.AsMut<BtreeInternalPage>(), parent, separator_index,
+			                             node_is_left);
+		}
 
-		return true;
+		// a root left with a single child hands the tree to the child
+		const bool collapse_root = merged && parent.IsRootPage() && parent.GetSize() == 1;
+		if (collapse_root) {
+			LOG_TRACE("Collapsing root {} into {}", parent.GetPageId(), left_page.GetPageId().page_number_);
+			page_set.front().get().AsMut<BtreeHeaderPage>().SetRootPageId(left_page.GetPageId().page_number_);
+			left_page.AsMut<BtreePage>().SetParentPageId(INVALID_PAGE_ID);
+		}
+		left_page.WUnlatch();
+		bpm_.UnpinPage(left_page.GetPageId(), true);
+		if (merged) {
+			ReleaseDeletedPage(right_page);
+		} else {
+			right_page.WUnlatch();
+			bpm_.UnpinPage(right_page.GetPageId(), true);
+		}
+
+		if (collapse_root) {
+			ReleaseHeaderPageAndMarkDirty(transaction);
+			assert(page_set.empty() && "pages above the root are latched");
+			ReleaseDeletedPage(parent_page);
+			return;
+		}
+		if (merged && !parent.IsRootPage() && parent.GetSize() < parent.GetMinSize()) {
+			HandleUnderflow(parent_page, transaction);
+			return;
+		}
+		parent_page.WUnlatch();
+		bpm_.UnpinPage(parent_page.GetPageId(), true);
+		ReleaseParentWriteLatches(transaction);
+	}
+
+	// balance two siblings, one of which fell below its minimum size, and fix up the key separating them in the
+	// parent. true if they were merged into the left one, whose entry the parent keeps
+	template <IsBtreeNode N>
+	bool MergeOrRedistribute(N &left, N &right, BtreeInternalPage &parent, idx_t separator_index, bool node_is_left) {
+		const auto table_oid = table_meta_.table_oid_;
+		// a leaf splits as soon as it is full, an internal page only once it would overflow
+		const auto merged_max_size = IsLeafPage<N>::value ? left.GetMaxSize() - 1 : left.GetMaxSize();
+		if (left.GetSize() + right.GetSize() <= merged_max_size) {
+			LOG_TRACE("Merging node {} into {}", right.GetPageId(), left.GetPageId());
+			if constexpr (IsLeafPage<N>::value) {
+				right.MoveAllTo(left);
+			} else {
+				right.MoveAllTo(left, parent.KeyAt(separator_index), bpm_, table_oid);
+			}
+			parent.Remove(separator_index);
+			return true;
+		}
+		LOG_TRACE("Moving an entry from node {} to {}", node_is_left ? right.GetPageId() : left.GetPageId(),
+		          node_is_left ? left.GetPageId() : right.GetPageId());
+		if constexpr (IsLeafPage<N>::value) {
+			node_is_left ? right.MoveFirstToEndOf(left) : left.MoveLastToFrontOf(right);
+		} else {
+			const auto middle_key = parent.KeyAt(separator_index);
+			node_is_left ? right.MoveFirstToEndOf(left, middle_key, bpm_, table_oid)
+			             : left.MoveLastToFrontOf(right, middle_key, bpm_, table_oid);
+		}
+		parent.SetKeyAt(separator_index, right.KeyAt(0));
+		return false;
+	}
+
+	// unlatch and unpin a page taken out of the tree and drop it from the buffer pool. the page is not written back,
+	// a lookup that still has it pinned keeps it in the pool until it notices the page changed
+	void ReleaseDeletedPage(Page &page) {
+		auto page_id = page.GetPageId();
+		page.WUnlatch();
+		bpm_.UnpinPage(page_id, false);
+		// only a lookup pinning the page for the moment it reads it can keep it in the pool
+		if (!bpm_.DeletePage(page_id)) {
+			LOG_WARN("deleted b+tree page {} is still pinned and stays in the buffer pool", page_id.ToString());
+		}
 	}
 
-	void InsertIntoParent(BtreePage &original_node, BtreePage &sibling_new_node, IndexKeyType key,
+	void InsertIntoParent(BtreePage &original_node, BtreePage &sibling_new_node, IndexKeyView key,
 	                      Transaction &transaction, Page &header_page) {
 		LOG_TRACE("Nodes {} and {} want to insert into their parent with key %s", original_node.GetPageId(),
 		          sibling_new_node.GetPageId(), IndexKeyTypeToString(key).c_str());
@@ -179,7 +595,7 @@ protected:
 			auto new_page_id = PageId {table_meta_.table_oid_};
 			auto &new_internal_node = bpm_.NewPageGuarded(*this, new_page_id).UpgradeWrite().AsMut<BtreeInternalPage>();
 			LOG_TRACE("Split node is root, create new root with page id {}", new_page_id.page_number_);
-			new_internal_node.Init(new_page_id.page_number_, INVALID_PAGE_ID);
+			new_internal_node.Init(new_page_id.page_number_, INVALID_PAGE_ID, key_layout_.GetKeySize());
 			new_internal_node.PopulateNewRoot(original_node.GetPageId(), key, sibling_new_node.GetPageId());
 
 			LOG_TRACE("Setting parent page id of original node {} and new sibling node {} to new root {}",
@@ -218,21 +634,21 @@ protected:
 		// currently the internal page size == internal max size which means that we have to allocate a new buffer space
 		// inorder to prevent overflowing the current page
 		LOG_TRACE("Internal parent {} is full, spliting parent", parent_page_id);
-		auto buffer = std::vector<data_t>(INTERNAL_PAGE_HEADER_SIZE +
-		                                  sizeof(InternalNode) * (parent_internal_node.GetSize() + 1));
+		auto buffer = std::vector<data_t>(parent_internal_node.GetOccupiedSize(parent_internal_node.GetSize() + 1));
 
 		std::memcpy(buffer.data(), parent_page.GetData(),
-		            INTERNAL_PAGE_HEADER_SIZE + sizeof(InternalNode) * (parent_internal_node.GetSize()));
+		            parent_internal_node.GetOccupiedSize(parent_internal_node.GetSize()));
 		auto &copy_parent_node = reinterpret_cast<BtreeInternalPage &>(*buffer.data());
 		copy_parent_node.InsertNodeAfter(original_node.GetPageId(), key, sibling_new_node.GetPageId());
 
 		auto &parent_new_sibling_node = Split(copy_parent_node);
 		LOG_TRACE("new sibling %s", parent_new_sibling_node.ToString().c_str());
-		IndexKeyType new_key = parent_new_sibling_node.KeyAt(0);
+		// the new sibling stays pinned until the key went up
+		auto new_key = parent_new_sibling_node.KeyAt(0);
 		LOG_TRACE("new key %s", IndexKeyTypeToString(new_key).c_str());
 		// by copying this (which include the header data), the size of the parent_internal_node will be updated
 		std::memcpy(parent_page.GetData(), buffer.data(),
-		            INTERNAL_PAGE_HEADER_SIZE + sizeof(InternalNode) * copy_parent_node.GetMinSize());
+		            copy_parent_node.GetOccupiedSize(copy_parent_node.GetMinSize()));
 		// parent_internal_node.SetSize(copy_parent_node.GetMinSize());
 
 		LOG_TRACE("new parent %s", parent_internal_node.ToString().c_str());
@@ -254,7 +670,7 @@ protected:
 		new_node.SetPageType(node.GetPageType());
 		LOG_TRACE("Init the split sibling node with page id {} and parent id {}", new_page_id.page_number_,
 		          node.GetParentPageId());
-		new_node.Init(new_page_id.page_number_, node.GetParentPageId());
+		new_node.Init(new_page_id.page_number_, node.GetParentPageId(), node.GetKeySize());
 
 		if constexpr (IsLeafPage<N>::value) {
 			LOG_TRACE("Splitting leaf node {}", node.GetPageId());
@@ -269,7 +685,7 @@ protected:
 		return new_node;
 	}
 
-	Page &SearchLeafPage(const IndexKeyType &key, Operation operation, Transaction &transaction, Page &header_page) {
+	Page &SearchLeafPage(IndexKeyView key, Operation operation, Transaction &transaction, Page &header_page) {
 		// auto root_page_id = PageId {table_meta_.table_oid_, GetRootPageId()};
 
 		const auto &header_node = header_page.As<BtreeHeaderPage>();
@@ -280,9 +696,10 @@ protected:
 		assert(page != nullptr);
 		// get latch on first node
 		if (operation == Operation::SEARCH) {
-			// unlatch the parent which is root
-			header_page.RUnlatch();
+			// latch the root before unlatching the header, otherwise the root could be split in between and the key
+			// moved out of it
 			page->RLatch();
+			header_page.RUnlatch();
 		} else {
 			// for insert and delete
 			page->WLatch();
@@ -301,7 +718,7 @@ protected:
 			          static_cast<int>(internal_page.GetSize()), static_cast<int>(internal_page.GetParentPageId()),
 			          static_cast<int>(internal_page.GetMaxSize()), internal_page.ToString().c_str());
 
-			auto child_page_id = internal_page.Lookup(key, comparator_);
+			auto child_page_id = internal_page.Lookup(key);
 			assert(child_page_id > 0);
 			LOG_TRACE("Search go to child: {}", child_page_id);
 			// move new page to node_pg should trigger the parent page to be released
@@ -345,9 +762,9 @@ protected:
 
 	[[nodiscard]] static bool IsSafeNode(const BtreePage &node, Operation operation) {
 		assert(operation != Operation::SEARCH);
-		// . because adding one more will not reach the threshold for splitting for leaf
+		// a leaf splits as soon as it is full, so it is only safe if adding one more does not fill it
 		if (operation == Operation::INSERT) {
-			if (node.IsLeafPage() && node.GetSize() < node.GetMaxSize()) {
+			if (node.IsLeafPage() && node.GetSize() + 1 < node.GetMaxSize()) {
 				return true;
 			}
 			// if internal node have room for one more key value, then it is safe
@@ -392,17 +809,171 @@ protected:
 	}
 
 private:
+	// read latch the way down to the leaf the key belongs to, or with before to the leaf holding the keys less than
+	// it. without a key to the first leaf, or with before to the last one. nullptr if the tree is empty
+	Page *FindLeafForRead(std::optional<IndexKeyView> key, bool before) {
+		auto &header_raw_page = bpm_.FetchPage({table_meta_.table_oid_, index_meta_.header_page_id_});
+		header_raw_page.RLatch();
+		auto root_page_id = header_raw_page.As<BtreeHeaderPage>().GetRootPageId();
+		if (root_page_id == INVALID_PAGE_ID) {
+			header_raw_page.RUnlatch();
+			bpm_.UnpinPage(header_raw_page.GetPageId(), false);
+			return nullptr;
+		}
+		auto *page = &bpm_.FetchPage({table_meta_.table_oid_, root_page_id});
+		page->RLatch();
+		header_raw_page.RUnlatch();
+		bpm_.UnpinPage(header_raw_page.GetPageId(), false);
+		while (!page->As<BtreePage>().IsLeafPage()) {
+			const auto &internal_page = page->As<BtreeInternalPage>();
+			page_id_t child_page_id;
+			if (key.has_value()) {
+				child_page_id = before ? internal_page.LookupBefore(*key) : internal_page.Lookup(*key);
+			} else {
+				child_page_id = internal_page.ValueAt(before ? internal_page.GetSize() - 1 : 0);
+			}
+			auto *child_page = &bpm_.FetchPage({table_meta_.table_oid_, child_page_id});
+			child_page->RLatch();
+			page->RUnlatch();
+			bpm_.UnpinPage(page->GetPageId(), false);
+			page = child_page;
+		}
+		return page;
+	}
+
+	// an iterator on the last key less than the key
+	BTreeIndexIterator SeekBefore(IndexKeyView key) {
+		auto *leaf = FindLeafForRead(key, true);
+		if (leaf == nullptr) {
+			return {};
+		}
+		auto slot = leaf->As<BtreeLeafPage>().FindKeyIndex(key);
+		if (slot == 0) {
+			// the leaf holds the smallest keys of the index, none of them is less
+			leaf->RUnlatch();
+			bpm_.UnpinPage(leaf->GetPageId(), false);
+			return {};
+		}
+		return {*this, *leaf, slot - 1};
+	}
+
+	// a level of the tree being bulk loaded: the entries its nodes share, and the node being filled
+	struct BulkLoadLevel {
+		idx_t entry_count_;
+		idx_t node_count_;
+		idx_t node_idx_ {0};
+		std::optional<BasicPageGuard> node_ {};
+	};
+
+	// append the entry to the node being filled on the level, starting it if needed. a node that got its share goes up
+	// to the next level, or with the last level becomes the root. the next leaf is started right away to link to it
+	template <IsBtreeNode N>
+	void BulkLoadAppend(std::vector<BulkLoadLevel> &levels, size_t level_idx,
+	                    std::conditional_t<IsLeafPage<N>::value, LeafNode, InternalNode> entry,
+	                    BtreeHeaderPage &header_page) {
+		auto &level = levels[level_idx];
+		if (!level.node_.has_value()) {
+			StartBulkLoadNode<N>(level);
+		}
+		auto &node = level.node_->template AsMut<N>();
+		if constexpr (IsLeafPage<N>::value) {
+			node.Append(entry);
+		} else {
+			// the child is still pinned, so taking it over as parent does not read it back
+			node.Append(entry, bpm_, table_meta_.table_oid_);
+		}
+		const auto share = level.entry_count_ / level.node_count_ +
+		                   (level.node_idx_ < level.entry_count_ % level.node_count_ ? 1 : 0);
+		if (node.GetSize() < share) {
+			return;
+		}
+
+		auto full_node = std::move(*level.node_);
+		level.node_.reset();
+		level.node_idx_++;
+		if constexpr (IsLeafPage<N>::value) {
+			if (level.node_idx_ < level.node_count_) {
+				StartBulkLoadNode<N>(level);
+				node.SetNextPageId(level.node_->PageId());
+			}
+		}
+		if (level_idx + 1 == levels.size()) {
+			assert(level.node_idx_ == level.node_count_ && "root level has more than one node");
+			header_page.SetRootPageId(full_node.PageId());
+			return;
+		}
+		BulkLoadAppend<BtreeInternalPage>(levels, level_idx + 1, {node.KeyAt(0), full_node.PageId()}, header_page);
+	}
+
+	template <IsBtreeNode N>
+	void StartBulkLoadNode(BulkLoadLevel &level) {
+		auto page_id = PageId {table_meta_.table_oid_};
+		level.node_.emplace(bpm_.NewPageGuarded(*this, page_id));
+		level.node_->template AsMut<N>().Init(page_id.page_number_, INVALID_PAGE_ID, key_layout_.GetKeySize());
+	}
+
 	// pass in the header page to satisfy the assumption that we have the write lock to the header page
-	void CreateNewRoot(const IndexKeyType &key, const IndexValueType &value, BtreeHeaderPage &header_page) {
+	void CreateNewRoot(IndexKeyView key, const IndexValueType &value, BtreeHeaderPage &header_page) {
 		auto root_page_id = PageId {table_meta_.table_oid_};
 		auto &leaf_page = bpm_.NewPageGuarded(*this, root_page_id).UpgradeWrite().AsMut<BtreeLeafPage>();
-		leaf_page.Init(root_page_id.page_number_, INVALID_PAGE_ID);
+		leaf_page.Init(root_page_id.page_number_, INVALID_PAGE_ID, key_layout_.GetKeySize());
 		assert(root_page_id.page_number_ > 0);
 		LOG_TRACE("Root page id set to: {}", root_page_id.page_number_);
 		header_page.SetRootPageId(root_page_id.page_number_);
-		leaf_page.Insert(key, value, comparator_);
+		leaf_page.Insert(key, value);
 	}
 
 	BufferPool &bpm_;
+	// the frame each page was last found in by an optimistic lookup, pages share a slot by their number
+	std::unique_ptr<std::atomic<Page *>[]> frame_hints_ {
+	    std::make_unique<std::atomic<Page *>[]>(BTREE_FRAME_HINT_COUNT)};
+	bool optimistic_lookups_ {true};
+	std::atomic<uint64_t> optimistic_restart_count_ {0};
+	std::atomic<uint64_t> pessimistic_lookup_count_ {0};
 };
+
+inline BTreeIndexIterator &BTreeIndexIterator::operator++() {
+	assert(!IsEnd() && "iterate past the end");
+	slot_++;
+	SkipExhaustedLeaves();
+	return *this;
+}
+
+inline BTreeIndexIterator &BTreeIndexIterator::operator--() {
+	assert(!IsEnd() && "iterate past the end");
+	if (slot_ > 0) {
+		slot_--;
+		return *this;
+	}
+	// the leaf before is not linked to, look it up by the first key of this one, copied as the leaf is let go
+	IndexKeyType key(GetKey().begin(), GetKey().end());
+	Release();
+	*this = index_->SeekBefore(key);
+	return *this;
+}
+
+inline void BTreeIndexIterator::SkipExhaustedLeaves() {
+	while (leaf_ != nullptr && slot_ >= leaf_->As<BtreeLeafPage>().GetSize()) {
+		auto next_page_id = leaf_->As<BtreeLeafPage>().GetNextPageId();
+		if (next_page_id == INVALID_PAGE_ID) {
+			Release();
+			return;
+		}
+		// latch crabbing along the chain, the next leaf is latched before this one is released
+		auto *next_leaf = &index_->bpm_.FetchPage({index_->table_meta_.table_oid_, next_page_id});
+		next_leaf->RLatch();
+		Release();
+		leaf_ = next_leaf;
+		slot_ = 0;
+	}
+}
+
+inline void BTreeIndexIterator::Release() {
+	if (leaf_ == nullptr) {
+		return;
+	}
+	leaf_->RUnlatch();
+	index_->bpm_.UnpinPage(leaf_->GetPageId(), false);
+	leaf_ = nullptr;
+}
 } // namespace db
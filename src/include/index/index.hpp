@@ -1,16 +1,22 @@
 #pragma once
 
+#include "common/config.hpp"
 #include "common/logger.hpp"
 #include "common/rid.hpp"
 #include "common/typedef.hpp"
 #include "common/value.hpp"
 #include "concurrency/transaction.hpp"
+#include "index/index_key.hpp"
+#include "index/index_typdef.hpp"
 #include "meta/column.hpp"
 #include "storage/serializer/serializer.hpp"
 #include "storage/table/table_meta.hpp"
 #include "storage/table/tuple.hpp"
 
-#include <sstream>
+#include <algorithm>
+#include <optional>
+#include <utility>
+#include <vector>
 
 namespace db {
 
@@ -25,16 +31,22 @@ enum class IndexType { BPlusTreeIndex, HashTableIndex };
 struct IndexMeta {
 public:
 	IndexMeta() = default;
+	IndexMeta(std::string name, table_oid_t table_id, std::vector<Column> key_cols,
+	          IndexConstraintType index_constraint_type, IndexType index_type)
+	    : name_(std::move(name)), table_id_(table_id), key_cols_(std::move(key_cols)),
+	      index_constraint_type_(index_constraint_type), index_type_(index_type) {
+	}
 	IndexMeta(std::string name, table_oid_t table_id, Column key_col, IndexConstraintType index_constraint_type,
 	          IndexType index_type)
-	    : name_(std::move(name)), table_id_(table_id), key_col_(std::move(key_col)),
-	      index_constraint_type_(index_constraint_type), index_type_(index_type) {
+	    : IndexMeta(std::move(name), table_id, std::vector<Column> {std::move(key_col)}, index_constraint_type,
+	                index_type) {
 	}
 
 	std::string name_;
 	table_oid_t table_id_;
 	index_oid_t index_id_;
-	Column key_col_;
+	// the columns of the key in the order they sort by
+	std::vector<Column> key_cols_;
 	IndexConstraintType index_constraint_type_;
 	page_id_t header_page_id_ {INVALID_PAGE_ID};
 	IndexType index_type_;
@@ -42,46 +54,38 @@ public:
 	void Serialize(Serializer &serializer) const {
 		serializer.WriteProperty(100, "index_name", name_);
 		serializer.WriteProperty(101, "table_id", table_id_);
-		serializer.WriteProperty(102, "key_col", key_col_);
+		serializer.WriteProperty(102, "key_col", key_cols_.front());
 		serializer.WriteProperty(103, "index_id", index_id_);
 		serializer.WriteProperty(104, "index_constraint_type", index_constraint_type_);
 		serializer.WriteProperty(105, "header_page_id", header_page_id_);
 		serializer.WriteProperty(106, "index_type", index_type_);
+		serializer.WriteProperty(107, "key_cols", key_cols_);
 	}
 
 	[[nodiscard]] static std::unique_ptr<IndexMeta> Deserialize(Deserializer &deserializer) {
 		auto meta = std::make_unique<IndexMeta>();
 		deserializer.ReadProperty(100, "table_name", meta->name_);
 		deserializer.ReadProperty(101, "table_id", meta->table_id_);
-		deserializer.ReadProperty(102, "key_col", meta->key_col_);
+		auto key_col = deserializer.ReadProperty<Column>(102, "key_col");
 		deserializer.ReadProperty(103, "index_id", meta->index_id_);
 		deserializer.ReadProperty(104, "index_constraint_type", meta->index_constraint_type_);
 		deserializer.ReadProperty(105, "header_page_id", meta->header_page_id_);
 		deserializer.ReadProperty(106, "index_type", meta->index_type_);
+		// indexes written before composite keys have their one column only
+		deserializer.ReadPropertyWithDefault(107, "key_cols", meta->key_cols_, std::vector<Column> {key_col});
 		return meta;
 	}
 };
 
-// return 0 if a == b, 1 if a > b, -1 if a < b
-using Comparator = std::function<int(const IndexKeyType &, const IndexKeyType &)>;
-
-static int32_t ConvertArrayToInt32(const IndexKeyType &arr) {
-	int32_t result = 0;
-	// Assuming little-endian
-	result |= arr[0];
-	result |= arr[1] << 8;
-	result |= arr[2] << 16;
-	result |= arr[3] << 24;
-	return result;
-}
-
-static std::string IndexKeyTypeToString(const IndexKeyType &key) {
-	std::ostringstream oss;
-	oss << "Key[";
-	oss << ConvertArrayToInt32(key);
-	oss << "]";
-	return oss.str();
-}
+// the keys between two bounds, each given by values of the leading key columns. a bound without values leaves the
+// range open on its side, one with fewer values than key columns takes in or leaves out all keys starting with them
+struct IndexRange {
+	std::vector<Value> low_;
+	std::vector<Value> high_;
+	bool low_inclusive_ {true};
+	bool high_inclusive_ {true};
+};
+
 class Index : public PageAllocator {
 
 public:
@@ -89,27 +93,71 @@ public:
 	Index(const Index &) = delete;
 	Index &operator=(const Index &) = delete;
 	Index(IndexMeta &index_meta, TableMeta &table_meta)
-	    : index_meta_(index_meta), table_meta_(table_meta), comparator_(GetComparator(index_meta.key_col_.GetType())) {
+	    : index_meta_(index_meta), table_meta_(table_meta), key_layout_(index_meta.key_cols_) {
 	}
 
 	PageId AllocatePage() override {
 		auto new_page = table_meta_.IncrementTableDataPageId();
 		return {table_meta_.table_oid_, new_page};
 	}
+	// throws if a varchar of the key is longer than its column
 	bool InsertRecord(Transaction &txn, const Tuple &tuple, const RID rid) {
 		auto key = ConvertTupleToKey(tuple);
-		LOG_TRACE("Inserting key: %s", IndexKeyTypeToString(key).c_str());
-		return InternalInsertRecord(txn, key, rid);
+		if (!key.has_value()) {
+			throw RuntimeException("Index key value is longer than its column");
+		}
+		LOG_TRACE("Inserting key: %s", IndexKeyTypeToString(*key).c_str());
+		return InternalInsertRecord(txn, *key, rid);
 	}
 	bool DeleteRecord(Transaction &txn, const Tuple &tuple) {
 		auto key = ConvertTupleToKey(tuple);
-		return InternalDeleteRecord(txn, key);
+		return key.has_value() && InternalDeleteRecord(txn, *key);
 	}
 
 	bool ScanKey(const Tuple &tuple, std::vector<RID> &rids) {
 		auto key = ConvertTupleToKey(tuple);
-		LOG_TRACE("Scanning key: %s", IndexKeyTypeToString(key).c_str());
-		return InternalScanKey(key, rids);
+		if (!key.has_value()) {
+			return false;
+		}
+		LOG_TRACE("Scanning key: %s", IndexKeyTypeToString(*key).c_str());
+		return InternalScanKey(*key, rids);
+	}
+
+	// the rids of the keys in the range in key order, or in reverse key order
+	void ScanRange(const IndexRange &range, std::vector<RID> &rids, bool reverse = false) {
+		std::optional<IndexKeyBound> low;
+		std::optional<IndexKeyBound> high;
+		if (!range.low_.empty()) {
+			low = key_layout_.EncodeBound(range.low_, range.low_inclusive_, true);
+		}
+		if (!range.high_.empty()) {
+			high = key_layout_.EncodeBound(range.high_, range.high_inclusive_, false);
+		}
+		InternalScanRange(low, high, reverse, rids);
+	}
+
+	// fill the empty index with the entries at once, in place of inserting them one by one. the entries may come in any
+	// order and are sorted first. throws if two entries have the same key, nothing is loaded then: a unique index must
+	// not take them and any other cannot keep both, as an index holds a key only once
+	void BulkLoad(std::vector<std::pair<IndexKeyType, RID>> entries, double fill_factor = BTREE_BULK_LOAD_FILL_FACTOR) {
+		std::ranges::stable_sort(entries,
+		                         [this](const auto &a, const auto &b) { return comparator_(a.first, b.first) < 0; });
+		auto duplicate = std::ranges::adjacent_find(
+		    entries, [this](const auto &a, const auto &b) { return comparator_(a.first, b.first) == 0; });
+		if (duplicate != entries.end()) {
+			const auto rids = fmt::format("{} and {}", duplicate->second.ToString(), (duplicate + 1)->second.ToString());
+			if (index_meta_.index_constraint_type_ == IndexConstraintType::PRIMARY ||
+			    index_meta_.index_constraint_type_ == IndexConstraintType::UNIQUE) {
+				throw RuntimeException(fmt::format("Rows {} violate the unique key of index {}", rids, index_meta_.name_));
+			}
+			throw RuntimeException(
+			    fmt::format("Rows {} have the same key, which index {} cannot hold twice", rids, index_meta_.name_));
+		}
+		InternalBulkLoad(entries, fill_factor);
+	}
+
+	[[nodiscard]] const IndexKeyLayout &GetKeyLayout() const {
+		return key_layout_;
 	}
 
 	~Index() override = default;
@@ -117,41 +165,27 @@ public:
 	// debug
 
 protected:
-	virtual bool InternalInsertRecord(Transaction &txn, IndexKeyType key, RID rid) = 0;
-	virtual bool InternalDeleteRecord(Transaction &txn, IndexKeyType key) = 0;
-	virtual bool InternalScanKey(IndexKeyType key, std::vector<RID> &rids) = 0;
+	virtual bool InternalInsertRecord(Transaction &txn, IndexKeyView key, RID rid) = 0;
+	virtual bool InternalDeleteRecord(Transaction &txn, IndexKeyView key) = 0;
+	virtual bool InternalScanKey(IndexKeyView key, std::vector<RID> &rids) = 0;
+	// the entries are sorted by key and the keys are unique
+	virtual void InternalBulkLoad(const std::vector<std::pair<IndexKeyType, RID>> &entries, double fill_factor) = 0;
+	virtual void InternalScanRange(const std::optional<IndexKeyBound> &low, const std::optional<IndexKeyBound> &high,
+	                               bool reverse, std::vector<RID> &rids) = 0;
 	IndexMeta &index_meta_;
 	TableMeta &table_meta_;
-	// comparator used to determine the order of keys
-	Comparator comparator_;
+	IndexKeyLayout key_layout_;
+	// orders keys outside of searches, which specialize it on the key size
+	KeyComparator<> comparator_;
 
 private:
-	static Comparator GetComparator(TypeId type_id) {
-		switch (type_id) {
-		case TypeId::BOOLEAN:
-			return Compare<uint8_t>;
-		case TypeId::INTEGER:
-			return Compare<int32_t>;
-		case TypeId::TIMESTAMP:
-			return Compare<uint64_t>;
-		case TypeId::VARCHAR:
-			return Compare<std::string>;
-		default:
-			throw std::invalid_argument("Unsupported type for indexing");
+	[[nodiscard]] std::optional<IndexKeyType> ConvertTupleToKey(const Tuple &tuple) const {
+		std::vector<Value> values;
+		values.reserve(index_meta_.key_cols_.size());
+		for (const auto &col : index_meta_.key_cols_) {
+			values.push_back(tuple.GetValue(col));
 		}
-	}
-
-	template <typename T>
-	static int Compare(const IndexKeyType &a, const IndexKeyType &b) {
-		T lhs = *reinterpret_cast<const T *>(a.data());
-		T rhs = *reinterpret_cast<const T *>(b.data());
-		return (lhs < rhs) ? -1 : (lhs > rhs) ? 1 : 0;
-	}
-
-	[[nodiscard]] IndexKeyType ConvertTupleToKey(const Tuple &tuple) const {
-		auto value = tuple.GetValue(index_meta_.key_col_);
-		LOG_TRACE("converted to key: {}", value.ToString());
-		return value.ConvertToIndexKeyType();
+		return key_layout_.Encode(values);
 	}
 };
 
@@ -0,0 +1,203 @@
+#pragma once
+
+#include "common/config.hpp"
+#include "common/exception.hpp"
+#include "common/value.hpp"
+#include "index/index_typdef.hpp"
+#include "meta/column.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace db {
+
+// a key bounding a range scan and whether the key itself is part of the range
+using IndexKeyBound = std::pair<IndexKeyType, bool>;
+
+// the key in hex, for debugging
+inline std::string IndexKeyTypeToString(IndexKeyView key) {
+	static constexpr char DIGITS[] = "0123456789abcdef";
+	std::string result = "Key[";
+	for (auto byte : key) {
+		result += DIGITS[byte >> 4];
+		result += DIGITS[byte & 0xF];
+	}
+	result += "]";
+	return result;
+}
+
+/**
+ * KeyComparator orders the encoded keys of an index, returning 0 if a == b, 1 if a > b and -1 if a < b. Keys compare
+ * byte by byte, and with the key size known at compile time the memcmp compiles down to a few inline integer compares.
+ * With a key size of 0 the size of the keys compared is taken.
+ */
+template <uint32_t KeySize = 0>
+struct KeyComparator {
+	int operator()(IndexKeyView a, IndexKeyView b) const {
+		assert(a.size() == b.size() && (KeySize == 0 || a.size() == KeySize) && "keys of different indexes");
+		const auto result = std::memcmp(a.data(), b.data(), KeySize == 0 ? a.size() : KeySize);
+		return (result < 0) ? -1 : (result > 0) ? 1 : 0;
+	}
+};
+
+// call f with the comparator of keys of the size, specialized for the sizes of the most common keys. meant to be done
+// once per search rather than per comparison
+template <typename F>
+decltype(auto) DispatchKeyComparator(uint32_t key_size, F &&f) {
+	switch (key_size) {
+	// an INTEGER
+	case 4:
+		return f(KeyComparator<4> {});
+	// a TIMESTAMP or two INTEGERs
+	case 8:
+		return f(KeyComparator<8> {});
+	default:
+		return f(KeyComparator<> {});
+	}
+}
+
+/**
+ * IndexKeyLayout is how the values of the key columns of an index are encoded into a key. Every column takes a fixed
+ * width and is encoded so that comparing two keys byte by byte orders them like their values, column by column:
+ * integers are written big-endian with the sign bit flipped, varchars are zero padded to the length of their column
+ * and followed by their length. All keys of an index are thus as wide as the widths of its columns together, and no
+ * two values that fit their columns share a key.
+ */
+class IndexKeyLayout {
+public:
+	explicit IndexKeyLayout(std::vector<Column> key_cols)
+	    : key_cols_(std::move(key_cols)), key_size_(CheckKeyWidth(key_cols_)) {
+	}
+
+	// the width of the key of the columns, throws if an index cannot have them as its key
+	static uint32_t CheckKeyWidth(const std::vector<Column> &key_cols) {
+		if (key_cols.empty()) {
+			throw RuntimeException("Index without key columns");
+		}
+		uint32_t key_size = 0;
+		for (const auto &col : key_cols) {
+			key_size += GetColumnWidth(col);
+		}
+		if (key_size > INDEX_MAX_KEY_SIZE) {
+			throw RuntimeException(
+			    fmt::format("Index key of {} bytes is wider than {} bytes", key_size, INDEX_MAX_KEY_SIZE));
+		}
+		return key_size;
+	}
+
+	[[nodiscard]] uint32_t GetKeySize() const {
+		return key_size_;
+	}
+	[[nodiscard]] const std::vector<Column> &GetKeyColumns() const {
+		return key_cols_;
+	}
+
+	// the key of the values of all key columns. nullopt if a varchar is longer than its column, as no key can hold it
+	[[nodiscard]] std::optional<IndexKeyType> Encode(const std::vector<Value> &values) const {
+		assert(values.size() == key_cols_.size() && "values do not match the key columns");
+		IndexKeyType key(key_size_);
+		if (EncodePrefix(values, key) < values.size()) {
+			return std::nullopt;
+		}
+		return key;
+	}
+
+	// a bound of a range scan from the values of the leading key columns. the columns left out are filled so that
+	// the bound takes in, or leaves out, all keys starting with the values
+	[[nodiscard]] IndexKeyBound EncodeBound(const std::vector<Value> &values, bool inclusive, bool is_low) const {
+		assert(values.size() <= key_cols_.size() && "more values than key columns");
+		IndexKeyType key(key_size_);
+		const auto encoded = EncodePrefix(values, key);
+		const auto offset = GetColumnOffset(encoded);
+		if (encoded < values.size()) {
+			// the value is longer than its column and orders after every key starting with its prefix, which the
+			// filled column holds. the length no varchar of the column can have puts the bound past them
+			std::fill(key.begin() + offset + GetColumnWidth(key_cols_[encoded]) - VARCHAR_KEY_LENGTH_SIZE, key.end(),
+			          0xFF);
+			return {std::move(key), !is_low};
+		}
+		const bool fill_low = is_low == inclusive;
+		std::fill(key.begin() + offset, key.end(), fill_low ? 0x00 : 0xFF);
+		return {std::move(key), inclusive};
+	}
+
+	// the width of the column in a key
+	[[nodiscard]] static uint32_t GetColumnWidth(const Column &col) {
+		if (col.GetType() == TypeId::VARCHAR) {
+			return col.GetStorageSize() + VARCHAR_KEY_LENGTH_SIZE;
+		}
+		return col.GetStorageSize();
+	}
+
+private:
+	static constexpr uint32_t VARCHAR_KEY_LENGTH_SIZE = sizeof(uint16_t);
+	static_assert(INDEX_MAX_KEY_SIZE < UINT16_MAX, "varchar key length does not fit");
+
+	// encode the values into the key from its start, up to a varchar too long for its column. the number encoded
+	[[nodiscard]] size_t EncodePrefix(const std::vector<Value> &values, IndexKeyType &key) const {
+		auto *out = key.data();
+		for (size_t i = 0; i < values.size(); i++) {
+			const auto &col = key_cols_[i];
+			const auto &value = values[i];
+			if (value.GetTypeId() != col.GetType()) {
+				throw RuntimeException(fmt::format("Key value of type {} for column {} of type {}",
+				                                   Type::TypeIdToString(value.GetTypeId()), col.GetName(),
+				                                   Type::TypeIdToString(col.GetType())));
+			}
+			switch (col.GetType()) {
+			case TypeId::BOOLEAN:
+				out = EncodeBigEndian(static_cast<uint8_t>(value.GetAs<int8_t>() ^ INT8_MIN), out);
+				break;
+			case TypeId::INTEGER:
+				out = EncodeBigEndian(static_cast<uint32_t>(value.GetAs<int32_t>() ^ INT32_MIN), out);
+				break;
+			case TypeId::TIMESTAMP:
+				out = EncodeBigEndian(value.GetAs<uint64_t>(), out);
+				break;
+			case TypeId::VARCHAR: {
+				const auto &str = value.GetAs<std::string>();
+				const auto length = col.GetStorageSize();
+				std::memcpy(out, str.data(), std::min<size_t>(str.size(), length));
+				if (str.size() > length) {
+					return i;
+				}
+				// the zero padding is already there
+				out = EncodeBigEndian(static_cast<uint16_t>(str.size()), out + length);
+				break;
+			}
+			case TypeId::INVALID:
+				throw RuntimeException("Invalid type");
+			}
+		}
+		return values.size();
+	}
+
+	[[nodiscard]] uint32_t GetColumnOffset(size_t column_count) const {
+		uint32_t offset = 0;
+		for (size_t i = 0; i < column_count; i++) {
+			offset += GetColumnWidth(key_cols_[i]);
+		}
+		return offset;
+	}
+
+	template <typename T>
+	static data_t *EncodeBigEndian(T value, data_t *out) {
+		if constexpr (std::endian::native == std::endian::little) {
+			value = std::byteswap(value);
+		}
+		std::memcpy(out, &value, sizeof(T));
+		return out + sizeof(T);
+	}
+
+	std::vector<Column> key_cols_;
+	uint32_t key_size_ {0};
+};
+
+} // namespace db
@@ -1,10 +1,14 @@
 #pragma once
 #include "common/rid.hpp"
 
-#include <array>
+#include <span>
+#include <vector>
 namespace db {
 
-using IndexKeyType = std::array<data_t, INDEX_KEY_SIZE>;
+// an encoded index key, see IndexKeyLayout. all keys of an index are as wide
+using IndexKeyType = std::vector<data_t>;
+// an encoded index key read in place, e.g. on a b+tree page
+using IndexKeyView = std::span<const data_t>;
 using IndexValueType = RID;
 using InternalValueType = page_id_t;
 
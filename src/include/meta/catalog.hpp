@@ -34,9 +34,10 @@ public:
 		EnsureTableFilesExist();
 	}
 
-	std::optional<table_oid_t> CreateTable(const std::string &table_name, const Schema &schema);
+	std::optional<table_oid_t> CreateTable(const std::string &table_name, const Schema &schema,
+	                                       PageLayout layout = PageLayout::Row);
 	std::optional<index_oid_t> CreateIndex(const std::string &index_name, const std::string &table_name,
-	                                       const Column &key_col, bool is_primary_key, IndexType index_type,
+	                                       std::vector<Column> key_cols, bool is_primary_key, IndexType index_type,
 	                                       BufferPool &bpm);
 
 	[[nodiscard]] TableMeta &GetTableByName(const std::string &table_name) const {
@@ -50,6 +51,13 @@ public:
 		return GetTableByName(GetTableName(table_oid));
 	}
 
+	[[nodiscard]] IndexMeta &GetIndex(const index_oid_t index_oid) const {
+		if (indexes_.find(index_oid) == indexes_.end()) {
+			throw Exception("Index not found when getting index info");
+		}
+		return *indexes_.at(index_oid);
+	}
+
 	[[nodiscard]] std::string &GetTableName(const table_oid_t table_oid) const {
 		if (tables_.find(table_oid) == tables_.end()) {
 			throw Exception("Table not found when getting table name");
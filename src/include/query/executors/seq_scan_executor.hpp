@@ -4,6 +4,9 @@
 #include "query/plans/seq_scan_plan.hpp"
 #include "storage/table/table_heap.hpp"
 #include "storage/table/table_iterator.hpp"
+
+#include <span>
+#include <vector>
 namespace db {
 
 /** The SeqScanExecutor executor executes a sequential table scan. */
@@ -13,7 +16,7 @@ public:
 	    : AbstractExecutor(exec_context), plan_(std::move(plan)),
 	      table_heap_(
 	          TableHeap(exec_context.GetBufferPoolManager(), exec_context.GetCatalog().GetTable(plan_->table_oid_))),
-	      table_iter_(table_heap_.MakeIterator()) {
+	      table_iter_(table_heap_.MakeIterator(true, CollectZoneRanges(plan_->filter_predicate_.get()))) {
 	}
 
 	bool Next(Tuple &tuple, RID &rid) override;
@@ -23,9 +26,16 @@ public:
 	}
 
 private:
+	// the ranges of the comparisons of fixed-size columns with constants that the filter predicate is a conjunction of,
+	// the zone map skips the pages that cannot hold a tuple in them
+	static std::vector<ZoneRange> CollectZoneRanges(const AbstractExpression *predicate);
+
 	std::unique_ptr<SeqScanPlanNode> plan_;
 	// TODO(gavinwang): add table heap pool
 	TableHeap table_heap_;
 	TableIterator table_iter_;
+	// the tuples of the page the scan is on and the next one to hand out
+	std::span<const TupleView> batch_;
+	size_t batch_position_ {0};
 };
 } // namespace db
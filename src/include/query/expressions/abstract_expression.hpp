@@ -51,12 +51,12 @@ public:
 		return ret_type_;
 	}
 
-	[[nodiscard]] virtual Value Evaluate(const Tuple &tuple, const Schema &schema) const = 0;
+	[[nodiscard]] virtual Value Evaluate(const TupleView &tuple, const Schema &schema) const = 0;
 
 	[[nodiscard]] virtual Value GetConstValue() const = 0;
 
-	[[nodiscard]] virtual Value EvaluateJoin(const Tuple &left_tuple, const Schema &left_schema, const Tuple &right_tuple,
-	                           const Schema &right_schema) const = 0;
+	[[nodiscard]] virtual Value EvaluateJoin(const TupleView &left_tuple, const Schema &left_schema,
+	                                         const TupleView &right_tuple, const Schema &right_schema) const = 0;
 
 	[[nodiscard]] virtual std::string ToString() const = 0;
 
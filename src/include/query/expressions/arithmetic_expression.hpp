@@ -17,14 +17,14 @@ public:
 		}
 	}
 
-	[[nodiscard]] Value Evaluate(const Tuple &tuple, const Schema &schema) const override {
+	[[nodiscard]] Value Evaluate(const TupleView &tuple, const Schema &schema) const override {
 		Value lhs = GetChildAt(0)->Evaluate(tuple, schema);
 		Value rhs = GetChildAt(1)->Evaluate(tuple, schema);
 		return PerformComputation(std::move(lhs), std::move(rhs));
 	}
 
-	[[nodiscard]] Value EvaluateJoin(const Tuple &left_tuple, const Schema &left_schema, const Tuple &right_tuple,
-	                                 const Schema &right_schema) const override {
+	[[nodiscard]] Value EvaluateJoin(const TupleView &left_tuple, const Schema &left_schema,
+	                                 const TupleView &right_tuple, const Schema &right_schema) const override {
 		Value lhs = GetChildAt(0)->EvaluateJoin(left_tuple, left_schema, right_tuple, right_schema);
 		Value rhs = GetChildAt(1)->EvaluateJoin(left_tuple, left_schema, right_tuple, right_schema);
 		return PerformComputation(std::move(lhs), std::move(rhs));
@@ -13,7 +13,7 @@ public:
 	    : AbstractExpression(ret_type), tuple_pos_ {tuple_pos}, col_idx_ {col_idx} {
 	}
 
-	[[nodiscard]] Value Evaluate(const Tuple &tuple, const Schema &schema) const override {
+	[[nodiscard]] Value Evaluate(const TupleView &tuple, const Schema &schema) const override {
 		return tuple.GetValue(schema, col_idx_);
 	}
 
@@ -21,12 +21,16 @@ public:
 		throw RuntimeException("Column Value Expression cannot return a constant value");
 	}
 
-	[[nodiscard]] Value EvaluateJoin(const Tuple &left_tuple, const Schema &left_schema, const Tuple &right_tuple,
-	                   const Schema &right_schema) const override {
+	[[nodiscard]] Value EvaluateJoin(const TupleView &left_tuple, const Schema &left_schema,
+	                                 const TupleView &right_tuple, const Schema &right_schema) const override {
 		return tuple_pos_ == TuplePosition::LEFT ? left_tuple.GetValue(left_schema, col_idx_)
 		                                          : right_tuple.GetValue(right_schema, col_idx_);
 	}
 
+	[[nodiscard]] column_t GetColIdx() const {
+		return col_idx_;
+	}
+
 	[[nodiscard]] std::string ToString() const  override {
 		return fmt::format("#{}", col_idx_);
 	}
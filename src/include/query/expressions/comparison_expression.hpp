@@ -0,0 +1,75 @@
+#pragma once
+
+#include "common/comparison_type.hpp"
+#include "common/exception.hpp"
+#include "common/value.hpp"
+#include "fmt/core.h"
+#include "query/expressions/abstract_expression.hpp"
+#include "storage/table/tuple.hpp"
+namespace db {
+
+class ComparisonExpression : public AbstractExpression {
+public:
+	ComparisonExpression(AbstractExpressionRef left, AbstractExpressionRef right, ComparisonType compare_type)
+	    : AbstractExpression {TypeId::BOOLEAN, std::move(left), std::move(right)}, compare_type_ {compare_type} {
+		if (GetChildAt(0)->GetReturnType() != GetChildAt(1)->GetReturnType()) {
+			throw NotImplementedException("Comparison of different types is not implemented");
+		}
+	}
+
+	[[nodiscard]] Value Evaluate(const TupleView &tuple, const Schema &schema) const override {
+		Value lhs = GetChildAt(0)->Evaluate(tuple, schema);
+		Value rhs = GetChildAt(1)->Evaluate(tuple, schema);
+		return PerformComparison(lhs, rhs);
+	}
+
+	[[nodiscard]] Value EvaluateJoin(const TupleView &left_tuple, const Schema &left_schema,
+	                                 const TupleView &right_tuple, const Schema &right_schema) const override {
+		Value lhs = GetChildAt(0)->EvaluateJoin(left_tuple, left_schema, right_tuple, right_schema);
+		Value rhs = GetChildAt(1)->EvaluateJoin(left_tuple, left_schema, right_tuple, right_schema);
+		return PerformComparison(lhs, rhs);
+	}
+
+	[[nodiscard]] Value GetConstValue() const override {
+		throw RuntimeException("Comparison Expression cannot return a constant value");
+	}
+
+	[[nodiscard]] std::string ToString() const override {
+		return fmt::format("{} {} {}", GetChildAt(0)->ToString(), ComparisonTypeHelper::ToString(compare_type_),
+		                   GetChildAt(1)->ToString());
+	}
+
+	[[nodiscard]] ComparisonType GetComparisonType() const {
+		return compare_type_;
+	}
+
+private:
+	Value PerformComparison(const Value &lhs, const Value &rhs) const {
+		auto order = lhs.Compare(rhs);
+		bool result = false;
+		switch (compare_type_) {
+		case ComparisonType::Equal:
+			result = order == 0;
+			break;
+		case ComparisonType::NotEqual:
+			result = order != 0;
+			break;
+		case ComparisonType::LessThan:
+			result = order < 0;
+			break;
+		case ComparisonType::LessThanOrEqual:
+			result = order <= 0;
+			break;
+		case ComparisonType::GreaterThan:
+			result = order > 0;
+			break;
+		case ComparisonType::GreaterThanOrEqual:
+			result = order >= 0;
+			break;
+		}
+		return {TypeId::BOOLEAN, static_cast<int8_t>(result)};
+	}
+	ComparisonType compare_type_;
+};
+
+} // namespace db
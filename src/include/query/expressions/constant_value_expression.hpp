@@ -10,7 +10,8 @@ public:
 	explicit ConstantValueExpression(const Value &val) : AbstractExpression(val.GetTypeId()), val_(val) {
 	}
 
-	[[nodiscard]] Value Evaluate([[maybe_unused]] const Tuple &tuple, [[maybe_unused]] const Schema &schema) const override {
+	[[nodiscard]] Value Evaluate([[maybe_unused]] const TupleView &tuple,
+	                             [[maybe_unused]] const Schema &schema) const override {
 		return val_;
 	}
 
@@ -18,8 +19,8 @@ public:
 		return val_;
 	}
 
-	[[nodiscard]] Value EvaluateJoin([[maybe_unused]] const Tuple &left_tuple, [[maybe_unused]] const Schema &left_schema,
-	                   [[maybe_unused]] const Tuple &right_tuple,
+	[[nodiscard]] Value EvaluateJoin([[maybe_unused]] const TupleView &left_tuple,
+	                   [[maybe_unused]] const Schema &left_schema, [[maybe_unused]] const TupleView &right_tuple,
 	                   [[maybe_unused]] const Schema &right_schema) const override {
 		return val_;
 	}
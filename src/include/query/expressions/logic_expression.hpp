@@ -0,0 +1,55 @@
+#pragma once
+
+#include "common/exception.hpp"
+#include "common/logic_type.hpp"
+#include "common/value.hpp"
+#include "fmt/core.h"
+#include "query/expressions/abstract_expression.hpp"
+#include "storage/table/tuple.hpp"
+namespace db {
+
+class LogicExpression : public AbstractExpression {
+public:
+	LogicExpression(AbstractExpressionRef left, AbstractExpressionRef right, LogicType logic_type)
+	    : AbstractExpression {TypeId::BOOLEAN, std::move(left), std::move(right)}, logic_type_ {logic_type} {
+		if (GetChildAt(0)->GetReturnType() != TypeId::BOOLEAN || GetChildAt(1)->GetReturnType() != TypeId::BOOLEAN) {
+			throw NotImplementedException("Logic expressions only take booleans");
+		}
+	}
+
+	[[nodiscard]] Value Evaluate(const TupleView &tuple, const Schema &schema) const override {
+		bool lhs = GetChildAt(0)->Evaluate(tuple, schema).GetAs<int8_t>() != 0;
+		// the right side is only evaluated when it decides the result
+		if (lhs == (logic_type_ == LogicType::Or)) {
+			return {TypeId::BOOLEAN, static_cast<int8_t>(lhs)};
+		}
+		return GetChildAt(1)->Evaluate(tuple, schema);
+	}
+
+	[[nodiscard]] Value EvaluateJoin(const TupleView &left_tuple, const Schema &left_schema,
+	                                 const TupleView &right_tuple, const Schema &right_schema) const override {
+		bool lhs = GetChildAt(0)->EvaluateJoin(left_tuple, left_schema, right_tuple, right_schema).GetAs<int8_t>() != 0;
+		if (lhs == (logic_type_ == LogicType::Or)) {
+			return {TypeId::BOOLEAN, static_cast<int8_t>(lhs)};
+		}
+		return GetChildAt(1)->EvaluateJoin(left_tuple, left_schema, right_tuple, right_schema);
+	}
+
+	[[nodiscard]] Value GetConstValue() const override {
+		throw RuntimeException("Logic Expression cannot return a constant value");
+	}
+
+	[[nodiscard]] std::string ToString() const override {
+		return fmt::format("({} {} {})", GetChildAt(0)->ToString(), LogicTypeHelper::ToString(logic_type_),
+		                   GetChildAt(1)->ToString());
+	}
+
+	[[nodiscard]] LogicType GetLogicType() const {
+		return logic_type_;
+	}
+
+private:
+	LogicType logic_type_;
+};
+
+} // namespace db
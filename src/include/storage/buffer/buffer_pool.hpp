@@ -2,41 +2,214 @@
 
 #include "common/page_id.hpp"
 #include "common/typedef.hpp"
+#include "storage/buffer/buffer_ring.hpp"
+#include "storage/buffer/frame_arena.hpp"
 #include "storage/buffer/replacer.hpp"
 #include "storage/disk_manager.hpp"
 #include "storage/page/page.hpp"
 #include "storage/page/page_guard.hpp"
 #include "storage/page_allocator.hpp"
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <list>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 namespace db {
+struct BufferPoolStats {
+	uint64_t hit_count_ {0};
+	uint64_t miss_count_ {0};
+	// evictions that had to write the victim back before the frame could be reused
+	uint64_t dirty_eviction_count_ {0};
+	// pages written out by the background writer
+	uint64_t background_write_count_ {0};
+	// pages read by read-ahead
+	uint64_t prefetch_count_ {0};
+	// prefetched pages that were requested before being evicted
+	uint64_t prefetch_hit_count_ {0};
+	// prefetched pages that were evicted or deleted without ever being requested
+	uint64_t prefetch_wasted_count_ {0};
+};
+
+// how long threads waited for the latch of a resident page since it was loaded into its frame
+struct PageLatchStats {
+	PageId page_id_;
+	uint32_t wait_count_ {0};
+	uint64_t wait_nanos_ {0};
+};
+
+// one partition of the buffer pool, a page can only live in a frame owned by the shard its page id hashes to so that
+// operations on pages of different shards never contend on the same latch
+struct BufferPoolShard {
+	std::mutex latch_;
+	std::unique_ptr<Replacer> replacer_;
+	std::list<frame_id_t> free_list_;
+	std::unordered_map<PageId, frame_id_t, PageIdHash> page_table_;
+	// evicted dirty pages whose write back is still in flight
+	std::unordered_set<PageId, PageIdHash> writeback_pages_;
+	// frames whose page differs from its copy on disk, so flushing never has to walk clean frames
+	std::unordered_set<frame_id_t> dirty_frames_;
+	// frames given up by a shrinking pool that still hold a page, they are never handed out again
+	std::unordered_set<frame_id_t> retiring_frames_;
+	// signaled whenever a read into a frame or a write back finishes
+	std::condition_variable io_cv_;
+	// kept per shard so that counting does not bounce a shared cache line between threads
+	uint64_t hit_count_ {0};
+	uint64_t miss_count_ {0};
+	uint64_t dirty_eviction_count_ {0};
+	uint64_t background_write_count_ {0};
+	uint64_t prefetch_count_ {0};
+	uint64_t prefetch_hit_count_ {0};
+	uint64_t prefetch_wasted_count_ {0};
+};
+
 class BufferPool {
+	friend class BufferRing;
+
 public:
-	BufferPool(frame_id_t pool_size, DiskManager &disk_manager);
+	BufferPool(frame_id_t pool_size, DiskManager &disk_manager, ReplacerType replacer_type = ReplacerType::LRU_K,
+	           size_t replacer_k = LRUK_REPLACER_K, size_t shard_count = BUFFER_POOL_SHARD_COUNT,
+	           bool enable_background_writer = true, frame_id_t max_pool_size = 0);
+	~BufferPool();
 	BufferPool(const BufferPool &) = delete;
 	BufferPool &operator=(const BufferPool &) = delete;
 	bool FlushPage(PageId page_id);
 	void FlushAllPages();
-	BasicPageGuard FetchPageBasic(PageId page_id);
-	ReadPageGuard FetchPageRead(PageId page_id);
+	BasicPageGuard FetchPageBasic(PageId page_id, BufferRing *ring = nullptr);
+	// a page missed on through a ring is read into one of the ring's frames instead of evicting through the replacer
+	ReadPageGuard FetchPageRead(PageId page_id, BufferRing *ring = nullptr);
 	WritePageGuard FetchPageWrite(PageId page_id);
+	// empty instead of waiting when the page is latched by someone else
+	std::optional<WritePageGuard> TryFetchPageWrite(PageId page_id);
 	BasicPageGuard NewPageGuarded(PageAllocator &page_allocator, PageId &page_id);
 	bool UnpinPage(PageId page_id, bool is_dirty);
 	Page &NewPage(PageAllocator &page_allocator, PageId &page_id);
-	Page &FetchPage(PageId page_id);
+	Page &FetchPage(PageId page_id, BufferRing *ring = nullptr);
+	// pin the page only if it is in the pool, nullptr instead of reading it from disk. for readers that follow a page
+	// id without a latch, which may lead to a page deleted in the meantime and never written out
+	Page *FetchPageIfResident(PageId page_id);
 	bool DeletePage(PageId page_id);
+	[[nodiscard]] BufferPoolStats GetStats();
+	[[nodiscard]] size_t GetShardCount() const {
+		return shards_.size();
+	}
+	[[nodiscard]] frame_id_t GetPoolSize() const {
+		return pool_size_;
+	}
+	[[nodiscard]] frame_id_t GetMaxPoolSize() const {
+		return max_pool_size_;
+	}
+	// grow or shrink the pool to pool_size frames while it is in use, up to the max pool size given at construction.
+	// shrinking writes out and evicts the pages of the frames given up and waits for those still pinned
+	void Resize(frame_id_t pool_size);
+	[[nodiscard]] size_t GetDirtyPageCount();
+	// the resident pages whose latches were waited for the longest, at most limit of them, most contended first
+	[[nodiscard]] std::vector<PageLatchStats> GetLatchContention(size_t limit);
+	// whether the page currently occupies a frame, without counting as an access
+	[[nodiscard]] bool IsResident(PageId page_id);
+	// the pins currently held on the page, 0 if it is not resident
+	[[nodiscard]] uint16_t GetPinCount(PageId page_id);
+	// number of pages prefetched ahead of a sequential scan, 0 turns read-ahead off
+	void SetReadAheadWindow(size_t window) {
+		read_ahead_window_ = window;
+	}
 
 private:
-	bool AllocateFrame(frame_id_t &frame_id);
+	// caller must hold the shard latch, takes the oldest frame of the ring if there is one to recycle and allocates a
+	// frame otherwise
+	bool TakeFrame(BufferPoolShard &shard, BufferRing *ring, frame_id_t &frame_id, std::optional<PageId> &dirty_victim);
+	// caller must hold the shard latch, a dirty victim is only registered for write back and has to be written out by
+	// the caller through WriteBackVictim after dropping the latch
+	bool AllocateFrame(BufferPoolShard &shard, frame_id_t &frame_id, std::optional<PageId> &dirty_victim);
+	void WriteBackVictim(BufferPoolShard &shard, PageId victim_page_id, Page &page);
+	// caller must hold the shard latch, puts an unmapped frame back on the free list unless the frame is retiring
+	void FreeFrame(BufferPoolShard &shard, frame_id_t frame_id);
+	// give up the retiring frames of a shard that are not in use anymore, returns the pages that must be flushed
+	// before their frames can be given up
+	std::vector<PageId> RetireFrames(BufferPoolShard &shard);
+	// release a frame whose io failed and wake up the waiters
+	void AbortIo(BufferPoolShard &shard, frame_id_t frame_id);
+	void FinishIo(BufferPoolShard &shard, Page &page);
+	// the following ring helpers must be called with the shard latch held
+	// pop the oldest frame of the ring in this shard once the ring is full, it is returned unmapped if nobody else uses
+	// it, otherwise it is handed to the replacer
+	std::optional<frame_id_t> RecycleRingFrame(BufferPoolShard &shard, BufferRing &ring);
+	// whether the ring is full and the frame it would recycle next is still pinned
+	bool IsRingFrontPinned(BufferPoolShard &shard, BufferRing &ring);
+	void AdoptRingFrame(BufferPoolShard &shard, BufferRing &ring, frame_id_t frame_id);
+	void DisownRingFrame(BufferPoolShard &shard, frame_id_t frame_id);
+	// give every frame still owned by the ring back to the replacer
+	void ReleaseRing(BufferRing &ring);
+	size_t GetShardIndex(const BufferPoolShard &shard) const {
+		return &shard - shards_.data();
+	}
+	BufferPoolShard &GetShard(PageId page_id) {
+		return shards_[PageIdHash {}(page_id) % shards_.size()];
+	}
+	// caller must hold the shard latch
+	void SetDirty(BufferPoolShard &shard, frame_id_t frame_id, bool is_dirty);
+	// page ids of the dirty pages of a shard, optionally only the unpinned ones, at most limit of them
+	std::vector<PageId> CollectDirtyPages(BufferPoolShard &shard, bool unpinned_only, size_t limit);
+	// body of the background writer, periodically writes out unpinned dirty pages so that eviction finds clean victims
+	void RunPageWriter();
+	// called on a miss or on the first request of a prefetched page, queues the pages following a sequential access.
+	// pages read ahead of a ring scan are read into the ring
+	void ReadAhead(PageId page_id, BufferRing *ring);
+	struct PrefetchRequest {
+		PageId page_id_;
+		BufferRing *ring_;
+	};
+	// read the pages into unpinned frames as one batch, skipping those already resident or past the end of their file
+	void Prefetch(const std::vector<PrefetchRequest> &requests);
+	// set up the frame a page is prefetched into, empty if the page does not need to be read
+	std::optional<frame_id_t> ReservePrefetchFrame(PageId page_id, BufferRing *ring);
+	void FinishPrefetch(BufferPoolShard &shard, frame_id_t frame_id);
+	void RunPrefetcher();
+	// pin the page and clear its dirty flag before it is written out, empty if the page is not resident. a second
+	// flush of the page waits until EndFlush so that writes of the same page never overtake each other
+	std::optional<frame_id_t> BeginFlush(BufferPoolShard &shard, PageId page_id);
+	void EndFlush(BufferPoolShard &shard, frame_id_t frame_id, bool flushed);
+	static std::unique_ptr<Replacer> MakeReplacer(ReplacerType replacer_type, size_t replacer_k);
 
-	const frame_id_t pool_size_;
-	std::unique_ptr<Replacer> replacer_;
+	std::atomic<frame_id_t> pool_size_;
+	// frames and page metadata are reserved up front for this many frames
+	const frame_id_t max_pool_size_;
+	// serializes resizes
+	std::mutex resize_latch_;
 	DiskManager &disk_manager_;
-	std::list<frame_id_t> free_list_;
-	std::unordered_map<PageId, frame_id_t, PageIdHash> page_table_;
+	// must outlive pages_, which point into it
+	FrameArena arena_;
 	std::vector<Page> pages_;
-	std::mutex latch_;
+	std::vector<BufferPoolShard> shards_;
+	// FlushAllPages writes copies of the pages from here, one flush at a time
+	std::mutex flush_latch_;
+	FrameArena flush_buffers_;
+
+	std::mutex writer_latch_;
+	std::condition_variable writer_cv_;
+	bool stop_writer_ {false};
+	std::thread page_writer_;
+
+	// where the last sequential run of a table stands
+	struct ReadAheadState {
+		page_id_t last_page_number_ {INVALID_PAGE_ID};
+		// first page not yet queued for prefetching
+		page_id_t window_end_ {INVALID_PAGE_ID};
+	};
+	std::atomic<size_t> read_ahead_window_ {READ_AHEAD_WINDOW};
+	std::mutex prefetch_latch_;
+	std::condition_variable prefetch_cv_;
+	std::unordered_map<table_oid_t, ReadAheadState> read_ahead_states_;
+	std::deque<PrefetchRequest> prefetch_queue_;
+	// the batch being prefetched, a ring is only released once no prefetch uses it anymore
+	std::vector<PrefetchRequest> prefetching_;
+	bool stop_prefetcher_ {false};
+	std::thread prefetcher_;
 };
 } // namespace db
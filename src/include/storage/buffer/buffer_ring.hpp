@@ -0,0 +1,45 @@
+#pragma once
+
+#include "common/config.hpp"
+#include "common/page_id.hpp"
+#include "common/typedef.hpp"
+
+#include <deque>
+#include <utility>
+#include <vector>
+
+namespace db {
+class BufferPool;
+
+/**
+ * BufferRing is a buffer access strategy for bulk reads such as a full table scan. Pages a scan misses on are read into
+ * a small set of frames owned by the ring, which are recycled in round robin order instead of evicting pages through
+ * the main replacer. A scan over a table much larger than the pool therefore only occupies the frames of its ring and
+ * leaves the working set of the other queries alone.
+ *
+ * Ring frames are kept out of the replacer while the ring owns them and are handed back to it when the ring is
+ * destroyed. A ring is meant to be used by a single scan, every access to it is serialized by the shard latches.
+ */
+class BufferRing {
+	friend class BufferPool;
+
+public:
+	explicit BufferRing(BufferPool &bpm, size_t ring_size = BUFFER_RING_SIZE);
+	BufferRing(const BufferRing &) = delete;
+	BufferRing &operator=(const BufferRing &) = delete;
+	BufferRing(BufferRing &&) = delete;
+	BufferRing &operator=(BufferRing &&) = delete;
+	~BufferRing();
+
+	[[nodiscard]] size_t GetFramesPerShard() const {
+		return frames_per_shard_;
+	}
+
+private:
+	BufferPool &bpm_;
+	size_t frames_per_shard_;
+	// per shard, the frames handed to the ring with the page they were loaded with, oldest first. an entry whose frame no
+	// longer holds that page or is not owned by the ring anymore is stale and skipped
+	std::vector<std::deque<std::pair<frame_id_t, PageId>>> frames_;
+};
+} // namespace db
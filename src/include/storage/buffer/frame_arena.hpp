@@ -0,0 +1,43 @@
+#pragma once
+
+#include "common/config.hpp"
+#include "common/typedef.hpp"
+
+#include <cstddef>
+
+namespace db {
+/**
+ * FrameArena is one contiguous, PAGE_SIZE aligned allocation holding the data of every frame of a buffer pool. The
+ * alignment is what O_DIRECT requires of io buffers, so frames can be read into and written from without a bounce
+ * buffer.
+ *
+ * Large arenas are backed by huge pages when the system has some reserved, otherwise transparent huge pages are
+ * requested, which cuts the TLB misses of walking a big pool. The memory starts zeroed and is only backed once it is
+ * touched, so an arena can reserve room for more frames than are in use.
+ */
+class FrameArena {
+public:
+	explicit FrameArena(size_t frame_count);
+	FrameArena(const FrameArena &) = delete;
+	FrameArena &operator=(const FrameArena &) = delete;
+	~FrameArena();
+
+	[[nodiscard]] char *GetFrame(size_t index) const {
+		return data_ + index * PAGE_SIZE;
+	}
+	[[nodiscard]] size_t GetFrameCount() const {
+		return frame_count_;
+	}
+	[[nodiscard]] bool IsHugePageBacked() const {
+		return huge_pages_;
+	}
+	// hand the memory of unused frames back to the system, they read as zeros when touched again
+	void Release(size_t first, size_t count);
+
+private:
+	size_t frame_count_;
+	size_t size_;
+	char *data_ {nullptr};
+	bool huge_pages_ {false};
+};
+} // namespace db
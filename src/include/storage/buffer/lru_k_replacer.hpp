@@ -0,0 +1,59 @@
+#pragma once
+
+#include "common/config.hpp"
+#include "common/logger.hpp"
+#include "storage/buffer/replacer.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <set>
+#include <unordered_map>
+#include <utility>
+
+namespace db {
+/**
+ * LRUKReplacer evicts the evictable frame with the largest backward k-distance, i.e. the largest gap between now and
+ * its k-th most recent access. Frames with fewer than k recorded accesses have an infinite distance and are evicted
+ * first, oldest first access first, which keeps one-off scan pages from pushing out frequently used ones.
+ *
+ * Evictable frames are kept ordered by their eviction key so Evict is O(log n). Not thread safe, the buffer pool
+ * serializes all calls under its own latch.
+ */
+class LRUKReplacer : public Replacer {
+public:
+	explicit LRUKReplacer(size_t k);
+	~LRUKReplacer() override = default;
+	auto Evict(frame_id_t &frame_id) -> bool override;
+	// record an access and mark the frame non-evictable
+	void Pin(frame_id_t frame_id) override;
+	void Unpin(frame_id_t frame_id) override;
+	void Hold(frame_id_t frame_id) override;
+	void Remove(frame_id_t frame_id) override;
+	void Print() override {
+		for (const auto &[frame_id, node] : node_store_) {
+			LOG_TRACE("frame_id: {} is_evictable: {} history_size: {}", frame_id, node.is_evictable_,
+			          node.history_.size());
+		}
+	}
+
+private:
+	// (has k accesses, timestamp) ordered so that frames with infinite k-distance come first, and within each group
+	// the smaller timestamp (the earliest first access or the oldest k-th access) is evicted first
+	using EvictKey = std::pair<bool, uint64_t>;
+
+	struct LRUKNode {
+		// the last k access timestamps, oldest at the front
+		std::deque<uint64_t> history_;
+		bool is_evictable_ {false};
+	};
+
+	[[nodiscard]] EvictKey GetEvictKey(const LRUKNode &node) const {
+		return {node.history_.size() >= k_, node.history_.front()};
+	}
+
+	const size_t k_;
+	uint64_t current_timestamp_ {0};
+	std::unordered_map<frame_id_t, LRUKNode> node_store_;
+	std::set<std::pair<EvictKey, frame_id_t>> evictable_;
+};
+} // namespace db
@@ -15,6 +15,8 @@ public:
 	auto Evict(frame_id_t &frame_id) -> bool override;
 	void Pin(frame_id_t frame_id) override;
 	void Unpin(frame_id_t frame_id) override;
+	void Hold(frame_id_t frame_id) override;
+	void Remove(frame_id_t frame_id) override;
 	void Print() override {
 		for (const auto &iter : frame_store_) {
 			LOG_TRACE("frame_id: {} is_pinned: {}\n", iter.first, iter.second ? "false" : "true");
@@ -2,6 +2,8 @@
 
 #include "common/typedef.hpp"
 namespace db {
+enum class ReplacerType { RANDOM_BOGO, LRU_K };
+
 class Replacer {
 public:
 	explicit Replacer() = default;
@@ -13,6 +15,10 @@ public:
 	virtual auto Evict(frame_id_t &frame_id) -> bool = 0;
 	virtual void Pin(frame_id_t frame_id) = 0;
 	virtual void Unpin(frame_id_t frame_id) = 0;
+	// make the frame non-evictable without counting it as an access, e.g. while it is being flushed
+	virtual void Hold(frame_id_t frame_id) = 0;
+	// forget the frame entirely, used when its page is deleted and the frame goes back to the free list
+	virtual void Remove(frame_id_t frame_id) = 0;
 	virtual void Print() = 0;
 };
 } // namespace db
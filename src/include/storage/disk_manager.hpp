@@ -2,28 +2,97 @@
 
 #include "common/page_id.hpp"
 #include "common/typedef.hpp"
+#include "storage/io_uring.hpp"
 
+#include <atomic>
+#include <filesystem>
 #include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <unordered_map>
+#include <vector>
 
 namespace db {
 class Catalog; // forward declaration
 
+// how DiskManager accesses the table data files
+enum class DiskManagerBackend {
+	// like PREAD, but batches are submitted to io_uring and run concurrently, falls back to PREAD without io_uring
+	IO_URING,
+	// positional pread/pwrite on a file descriptor, reads of the same file run concurrently
+	PREAD,
+	// one std::fstream per file, every access seeks the shared stream position under the file latch
+	FSTREAM
+};
+
+// one page read or write of a batch
+struct DiskRequest {
+	bool is_write_ {false};
+	PageId page_id_;
+	char *data_ {nullptr};
+	// called with whether the request succeeded once it finished, on the thread that submitted the batch
+	std::function<void(bool)> callback_;
+};
+
 class DiskManager {
 public:
-	explicit DiskManager(Catalog &catalog) : cm_(catalog) {};
+	// direct_io opens the table data files with O_DIRECT so pages bypass the kernel page cache and are only cached by
+	// the buffer pool, it is ignored by the fstream backend
+	explicit DiskManager(Catalog &catalog, DiskManagerBackend backend = DiskManagerBackend::IO_URING,
+	                     bool direct_io = false);
 	DiskManager(const DiskManager &) = delete;
 	DiskManager &operator=(const DiskManager &) = delete;
 	;
 	void ShutDown();
 	void WritePage(PageId page_id, const char *page_data);
 	void ReadPage(PageId page_id, char *page_data);
+	// number of whole pages currently in the table data file
+	page_id_t GetPageCount(table_oid_t table_id);
+	// keeps all requests of the batch in flight at once when io_uring is available, calling each callback as its
+	// request completes, and returns after the last one
+	void SubmitBatch(std::vector<DiskRequest> &requests);
+	[[nodiscard]] bool IsIoUringActive();
 	~DiskManager();
 
 private:
-	void AddTableDataIfNotExist(table_oid_t table_id);
+	struct TableDataFile {
+		std::filesystem::path path_;
+		int fd_ {-1};
+		// the fstream backend has a single stream position, so every access is serialized
+		std::mutex stream_latch_;
+		std::fstream stream_;
+		// cached so that reads do not stat the file, only ever grows
+		std::atomic<int64_t> size_ {0};
+		// opened with O_DIRECT, io buffers must then be aligned to PAGE_SIZE
+		bool direct_ {false};
+	};
+
+	// open the data file of the table on first use, the returned file stays valid until ShutDown
+	TableDataFile &GetTableDataFile(table_oid_t table_id);
+	void OpenTableDataFile(TableDataFile &file);
+	static void GrowFileSize(TableDataFile &file, int64_t end);
+	static void CheckReadable(TableDataFile &file, int64_t offset);
+	// the file ended before the page, the rest of it reads as zeros
+	void FinishShortRead(PageId page_id, char *page_data, size_t read);
+	// a ring for a batch to run on, which nobody else uses until it is released. null if io_uring cannot be used
+	std::unique_ptr<IoUring> AcquireRing();
+	void ReleaseRing(std::unique_ptr<IoUring> ring);
+	void CompleteRequest(DiskRequest &request, int32_t res);
+	// run the requests from first on one after the other, without io_uring
+	void SubmitSynchronously(std::vector<DiskRequest> &requests, size_t first);
 	Catalog &cm_;
-	std::unordered_map<table_oid_t, std::fstream> table_data_files_;
+	const DiskManagerBackend backend_;
+	const bool direct_io_;
+	// only guards the file map, the io itself runs without it
+	std::shared_mutex latch_;
+	std::unordered_map<table_oid_t, std::unique_ptr<TableDataFile>> table_data_files_;
 	std::unordered_map<table_oid_t, std::fstream> table_meta_files_;
+	// every batch runs on a ring of its own, so concurrent batches do not wait for each other's completions. rings are
+	// kept for the next batches, the latch only guards the idle ones
+	std::mutex uring_latch_;
+	std::vector<std::unique_ptr<IoUring>> idle_rings_;
+	bool uring_unavailable_ {false};
 };
 } // namespace db
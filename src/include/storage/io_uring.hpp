@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <linux/io_uring.h>
+
+namespace db {
+/**
+ * IoUring is a minimal io_uring instance driven through the raw syscalls, only offering what DiskManager needs: queueing
+ * positional reads and writes, submitting them in one syscall and reaping their completions.
+ *
+ * The constructor throws an IOException when the kernel does not support io_uring, forbids it or lacks its plain read
+ * and write operations, callers are expected to fall back to synchronous io. Not thread safe.
+ */
+class IoUring {
+public:
+	explicit IoUring(unsigned entries);
+	IoUring(const IoUring &) = delete;
+	IoUring &operator=(const IoUring &) = delete;
+	~IoUring();
+
+	// queue a read or a write of len bytes at offset, returns false if the submission queue is full
+	bool PrepareReadWrite(bool is_write, int fd, void *buf, unsigned len, uint64_t offset, uint64_t user_data);
+	// submit everything queued and block until at least min_complete completions are available
+	void Submit(unsigned min_complete);
+	// pop the next completion, res is the number of bytes transferred or a negated errno
+	bool PopCompletion(uint64_t &user_data, int32_t &res);
+
+	[[nodiscard]] unsigned GetEntries() const {
+		return entries_;
+	}
+
+private:
+	void Release();
+
+	int ring_fd_ {-1};
+	unsigned entries_ {0};
+	// sqes queued with PrepareReadWrite and not yet passed to the kernel
+	unsigned to_submit_ {0};
+
+	void *sq_ring_ {nullptr};
+	size_t sq_ring_size_ {0};
+	void *cq_ring_ {nullptr};
+	size_t cq_ring_size_ {0};
+	io_uring_sqe *sqes_ {nullptr};
+	size_t sqes_size_ {0};
+
+	unsigned *sq_head_ {nullptr};
+	unsigned *sq_tail_ {nullptr};
+	unsigned *sq_mask_ {nullptr};
+	unsigned *sq_array_ {nullptr};
+	unsigned *cq_head_ {nullptr};
+	unsigned *cq_tail_ {nullptr};
+	unsigned *cq_mask_ {nullptr};
+	io_uring_cqe *cqes_ {nullptr};
+};
+} // namespace db
@@ -8,14 +8,15 @@
 #include "storage/page/btree_page.hpp"
 
 #include <algorithm>
-#include <array>
+#include <cstring>
 
 namespace db {
 static constexpr int INTERNAL_PAGE_HEADER_SIZE = 32;
-using InternalNode = std::pair<IndexKeyType, InternalValueType>;
-// static constexpr int INTERNAL_MAX_NODE_SIZE = 10;
-static constexpr int INTERNAL_MAX_NODE_SIZE = (PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / sizeof(InternalNode);
+// a separator key and the child it leads to, as handed to an internal page
+using InternalNode = std::pair<IndexKeyView, InternalValueType>;
 
+// each entry of an internal page is its key, as wide as all keys of the index, followed by the page id of the child.
+// the key of the first entry is not used
 class BtreeInternalPage : public BtreePage {
 
 public:
@@ -26,61 +27,72 @@ public:
 	BtreeInternalPage &operator=(BtreeInternalPage &&other) = delete;
 	~BtreeInternalPage() = delete;
 
-	void Init(page_id_t page_id, page_id_t parent_id) {
+	void Init(page_id_t page_id, page_id_t parent_id, uint32_t key_size) {
 		SetPageType(IndexPageType::INTERNAL_PAGE);
 		SetPageId(page_id);
 		SetSize(0);
-		SetMaxSize(INTERNAL_MAX_NODE_SIZE);
+		SetKeySize(key_size);
+		SetMaxSize(static_cast<int>(GetMaxSizeFor(key_size)));
 		SetParentPageId(parent_id);
-		LOG_TRACE("Setting internal page size to 0 and max size to %d", static_cast<int>(INTERNAL_MAX_NODE_SIZE));
+		LOG_TRACE("Setting internal page size to 0 and max size to %d", static_cast<int>(GetMaxSize()));
 	}
 
-	[[nodiscard]] IndexKeyType KeyAt(idx_t index) const {
-		return node_array_[index].first;
+	// the entries an internal page with keys of the size has room for
+	[[nodiscard]] static idx_t GetMaxSizeFor(uint32_t key_size) {
+		return (PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / (key_size + sizeof(InternalValueType));
 	}
 
-	void SetKeyAt(idx_t index, const IndexKeyType &key) {
-		node_array_[index].first = key;
+	// the bytes a page with the number of entries takes, to copy it into a buffer with room for one more
+	[[nodiscard]] idx_t GetOccupiedSize(idx_t size) const {
+		return INTERNAL_PAGE_HEADER_SIZE + size * GetEntrySize();
+	}
+
+	// the key in place on the page
+	[[nodiscard]] IndexKeyView KeyAt(idx_t index) const {
+		return {EntryAt(index), GetKeySize()};
+	}
+
+	void SetKeyAt(idx_t index, IndexKeyView key) {
+		assert(key.size() == GetKeySize() && "key of another index");
+		std::memmove(EntryAt(index), key.data(), GetKeySize());
 	}
 
 	[[nodiscard]] idx_t ValueIndex(const InternalValueType &value) const {
-		const auto *it = std::find_if(node_array_, node_array_ + GetSize(),
-		                              [&value](const auto &pair) { return pair.second == value; });
-		return std::distance(node_array_, it);
+		for (idx_t i = 0; i < GetSize(); i++) {
+			if (ValueAt(i) == value) {
+				return i;
+			}
+		}
+		return GetSize();
 	}
 
 	[[nodiscard]] InternalValueType ValueAt(idx_t index) const {
-		return node_array_[index].second;
+		InternalValueType value;
+		std::memcpy(&value, EntryAt(index) + GetKeySize(), sizeof(InternalValueType));
+		return value;
 	}
 
-	void SetValueAt(int index, const InternalValueType &value) {
-		node_array_[index].second = value;
+	void SetValueAt(idx_t index, const InternalValueType &value) {
+		std::memcpy(EntryAt(index) + GetKeySize(), &value, sizeof(InternalValueType));
 	}
 
-	[[nodiscard]] InternalValueType Lookup(const IndexKeyType &key, const Comparator &comparator) const {
+	[[nodiscard]] InternalValueType Lookup(IndexKeyView key) const {
 
 		LOG_TRACE("Internal page id %d with size %d, parent id %d, max size %d content %s",
 		          static_cast<int>(GetPageId()), static_cast<int>(GetSize()), static_cast<int>(GetParentPageId()),
 		          static_cast<int>(GetMaxSize()), ToString().c_str());
 		LOG_TRACE("Lookup key %s and page is %s", IndexKeyTypeToString(key).c_str(), ToString().c_str());
-		// ignore the first key
-		// lwoer bound returns first it where comp(*it, key) is false
-		const auto *target =
-		    std::lower_bound(node_array_ + 1, node_array_ + GetSize(), key,
-		                     [&comparator](const auto &pair, auto key) { return comparator(pair.first, key) < 0; });
-		// if target is last then lookup key is larger than all keys
-		if (target == node_array_ + GetSize()) {
-			return ValueAt(GetSize() - 1);
-			// if target is the same as the search key go to that value due our internal
-			// node convention
-		}
-		if (comparator(key, target->first) == 0) {
-			return target->second;
-		}
-		return std::prev(target)->second;
+		// the key of each entry but the first is the smallest in its child, so the key belongs to the last child whose
+		// key is not greater
+		return ValueAt(FindKeyIndex(key, true) - 1);
+	}
+
+	// the child holding the keys less than the key, for a scan going backward from it
+	[[nodiscard]] InternalValueType LookupBefore(IndexKeyView key) const {
+		return ValueAt(FindKeyIndex(key, false) - 1);
 	}
 
-	void PopulateNewRoot(const InternalValueType &old_value, const IndexKeyType &new_key,
+	void PopulateNewRoot(const InternalValueType &old_value, IndexKeyView new_key,
 	                     const InternalValueType &new_value) {
 		LOG_TRACE("Populating new root with key %s and value %d", IndexKeyTypeToString(new_key).c_str(), new_value);
 		SetValueAt(0, old_value);
@@ -106,31 +118,64 @@ public:
 		return result;
 	}
 
-	idx_t InsertNodeAfter(const InternalValueType &old_value, const IndexKeyType &new_key,
+	idx_t InsertNodeAfter(const InternalValueType &old_value, IndexKeyView new_key,
 	                      const InternalValueType &new_value) {
 
 		// assert old value is in the node
 		assert(ValueIndex(old_value) < GetSize());
 		auto new_value_idx = ValueIndex(old_value) + 1;
-		std::move_backward(node_array_ + new_value_idx, node_array_ + GetSize(), node_array_ + GetSize() + 1);
-		// LOG_TRACE("Inserting key %s with value %d after key %s with value %d", IndexKeyTypeToString(new_key).c_str(),
-		//          new_value, IndexKeyTypeToString(KeyAt(new_value_idx - 1)).c_str(), old_value);
-		node_array_[new_value_idx].first = new_key;
-		node_array_[new_value_idx].second = new_value;
+		std::memmove(EntryAt(new_value_idx + 1), EntryAt(new_value_idx), (GetSize() - new_value_idx) * GetEntrySize());
+		SetKeyAt(new_value_idx, new_key);
+		SetValueAt(new_value_idx, new_value);
 		IncreaseSize(1);
 
 		return GetSize();
 	}
 
+	void Remove(idx_t index) {
+		std::memmove(EntryAt(index), EntryAt(index + 1), (GetSize() - index - 1) * GetEntrySize());
+		SetSize(GetSize() - 1);
+	}
+
+	// append all entries to the recipient, the left sibling. the middle key, which separates the two in the parent,
+	// goes down to the first entry
+	void MoveAllTo(BtreeInternalPage &recipient, IndexKeyView middle_key, BufferPool &bpm, table_oid_t table_oid) {
+		SetKeyAt(0, middle_key);
+		recipient.CopyNFrom(EntryAt(0), GetSize(), bpm, table_oid);
+		SetSize(0);
+	}
+
+	// move the first entry to the end of the recipient, the left sibling, under the middle key. the key of the new
+	// first entry is the one to separate the two in the parent
+	void MoveFirstToEndOf(BtreeInternalPage &recipient, IndexKeyView middle_key, BufferPool &bpm,
+	                      table_oid_t table_oid) {
+		SetKeyAt(0, middle_key);
+		recipient.CopyNFrom(EntryAt(0), 1, bpm, table_oid);
+		Remove(0);
+	}
+
+	// move the last entry to the front of the recipient, the right sibling, whose old first entry goes under the middle
+	// key. the key of the moved entry is the one to separate the two in the parent
+	void MoveLastToFrontOf(BtreeInternalPage &recipient, IndexKeyView middle_key, BufferPool &bpm,
+	                       table_oid_t table_oid) {
+		recipient.SetKeyAt(0, middle_key);
+		std::memmove(recipient.EntryAt(1), recipient.EntryAt(0), recipient.GetSize() * GetEntrySize());
+		std::memcpy(recipient.EntryAt(0), EntryAt(GetSize() - 1), GetEntrySize());
+		recipient.IncreaseSize(1);
+		SetSize(GetSize() - 1);
+		bpm.FetchPageBasic({table_oid, recipient.ValueAt(0)}).AsMut<BtreePage>().SetParentPageId(recipient.GetPageId());
+	}
+
 	void MoveHalfTo(BtreeInternalPage &recipient, BufferPool &bpm, table_oid_t table_oid) {
 		idx_t start_split_indx = GetMinSize();
 		idx_t original_size = GetSize();
 		SetSize(start_split_indx);
-		recipient.CopyNFrom(node_array_ + start_split_indx, original_size - start_split_indx, bpm, table_oid);
+		recipient.CopyNFrom(EntryAt(start_split_indx), original_size - start_split_indx, bpm, table_oid);
 	}
 
-	void CopyNFrom(InternalNode *items, idx_t size, BufferPool &bpm, table_oid_t table_oid) {
-		std::copy(items, items + size, node_array_ + GetSize());
+	// append entries laid out like those of the page
+	void CopyNFrom(const data_t *entries, idx_t size, BufferPool &bpm, table_oid_t table_oid) {
+		std::memcpy(EntryAt(GetSize()), entries, size * GetEntrySize());
 
 		// because the recipient got the child originally referred by the owner the recipient have to be set the parent
 		// of those child leaf nodes
@@ -142,11 +187,47 @@ public:
 		IncreaseSize(size);
 	}
 
+	void Append(const InternalNode &entry, BufferPool &bpm, table_oid_t table_oid) {
+		assert(GetSize() < GetMaxSize() && "internal page is full");
+		SetKeyAt(GetSize(), entry.first);
+		SetValueAt(GetSize(), entry.second);
+		bpm.FetchPageBasic({table_oid, entry.second}).AsMut<BtreePage>().SetParentPageId(GetPageId());
+		IncreaseSize(1);
+	}
+
 private:
-	static_assert(std::is_trivially_copyable_v<IndexKeyType>);
-	static_assert(std::is_trivially_copyable_v<InternalValueType>);
+	[[nodiscard]] idx_t GetEntrySize() const {
+		return GetKeySize() + sizeof(InternalValueType);
+	}
+	[[nodiscard]] data_t *EntryAt(idx_t index) {
+		return entries_ + index * GetEntrySize();
+	}
+	[[nodiscard]] const data_t *EntryAt(idx_t index) const {
+		return entries_ + index * GetEntrySize();
+	}
+	// the first entry past the first whose key is greater than the key, or not less unless past equal
+	[[nodiscard]] idx_t FindKeyIndex(IndexKeyView key, bool past_equal) const {
+		return DispatchKeyComparator(GetKeySize(), [this, key, past_equal](const auto &comparator) {
+			return FindKeyIndex(key, comparator, past_equal);
+		});
+	}
+	template <typename Comparator>
+	[[nodiscard]] idx_t FindKeyIndex(IndexKeyView key, const Comparator &comparator, bool past_equal) const {
+		idx_t low = 1;
+		idx_t high = GetSize();
+		while (low < high) {
+			auto mid = low + (high - low) / 2;
+			auto result = comparator(KeyAt(mid), key);
+			if (result < 0 || (past_equal && result == 0)) {
+				low = mid + 1;
+			} else {
+				high = mid;
+			}
+		}
+		return low;
+	}
 
-	InternalNode node_array_[];
+	data_t entries_[];
 };
 static_assert(sizeof(BtreeInternalPage) == INTERNAL_PAGE_HEADER_SIZE);
 } // namespace db
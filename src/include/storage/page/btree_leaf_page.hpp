@@ -7,19 +7,16 @@
 #include "storage/page/btree_page.hpp"
 
 #include <algorithm>
+#include <cstring>
 #include <optional>
 namespace db {
 static constexpr int LEAF_PAGE_HEADER_SIZE = 40;
 
-using LeafNode = std::pair<IndexKeyType, IndexValueType>;
-// static constexpr int LEAF_MAX_NODE_SIZE = 30;
-static constexpr int LEAF_MAX_NODE_SIZE = (PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / (sizeof(LeafNode));
+// a key and the value it maps to, as handed to a leaf
+using LeafNode = std::pair<IndexKeyView, IndexValueType>;
 
+// each entry of a leaf is its key, as wide as all keys of the index, followed by the value
 class BtreeLeafPage : public BtreePage {
-	static_assert(sizeof(LeafNode) == 20);
-	static_assert(sizeof(IndexKeyType) == 8);
-	static_assert(sizeof(IndexValueType) == 12);
-
 public:
 	// delete all 5
 	BtreeLeafPage() = delete;
@@ -29,36 +26,43 @@ public:
 	BtreeLeafPage &operator=(BtreeLeafPage &&other) = delete;
 	~BtreeLeafPage() = delete;
 
-	void Init(page_id_t page_id, page_id_t parent_id) {
+	void Init(page_id_t page_id, page_id_t parent_id, uint32_t key_size) {
 		SetPageType(IndexPageType::LEAF_PAGE);
 		SetSize(0);
 		SetPageId(page_id);
 		SetParentPageId(parent_id);
 		SetNextPageId(INVALID_PAGE_ID);
-		SetMaxSize(LEAF_MAX_NODE_SIZE);
+		SetKeySize(key_size);
+		SetMaxSize(static_cast<int>(GetMaxSizeFor(key_size)));
 		LOG_TRACE("Setting size to 0 and max size to %d", static_cast<int>(GetMaxSize()));
 		assert(GetMaxSize() > 0);
 	}
 
+	// the entries a leaf with keys of the size has room for
+	[[nodiscard]] static idx_t GetMaxSizeFor(uint32_t key_size) {
+		return (PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / (key_size + sizeof(IndexValueType));
+	}
+
 	[[nodiscard]] page_id_t GetNextPageId() const {
 		return next_page_id_;
 	}
 	void SetNextPageId(page_id_t next_page_id) {
 		next_page_id_ = next_page_id;
 	}
-	[[nodiscard]] IndexKeyType KeyAt(int index) const {
-		return node_array_[index].first;
+	// the key in place on the page
+	[[nodiscard]] IndexKeyView KeyAt(idx_t index) const {
+		return {EntryAt(index), GetKeySize()};
 	}
-	void Insert(const IndexKeyType &key, const IndexValueType &value, const Comparator &comparator) {
+	void Insert(IndexKeyView key, const IndexValueType &value) {
 		assert(GetMaxSize() > 0);
 		if (GetSize() == GetMaxSize()) {
 			throw RuntimeException("Leaf node is full, shouldve split bruh");
 		}
 
-		auto key_idx = FindKeyIndex(key, comparator);
+		auto key_idx = FindKeyIndex(key);
 
-		// if size is 0 then no way already exist
-		if (GetSize() && comparator(node_array_[key_idx].first, key) == 0) {
+		// entries past the size may be left over from removed keys
+		if (key_idx < GetSize() && KeyComparator<> {}(KeyAt(key_idx), key) == 0) {
 			LOG_TRACE("Key %s already exists%s", IndexKeyTypeToString(key).c_str(), value.ToString().c_str());
 			// todo(gavinnwang): update the value of the key?
 			return;
@@ -66,52 +70,94 @@ public:
 		LOG_TRACE("Inserting key %s at index %d with val: %s", IndexKeyTypeToString(key).c_str(),
 		          static_cast<int>(key_idx), value.ToString().c_str());
 
-		if (key_idx == GetSize()) {
-			*(node_array_ + key_idx) = {key, value};
-		} else {
-			// shift everything at and after the key idx back one to make space
-			std::move_backward(node_array_ + key_idx, node_array_ + GetSize(), node_array_ + GetSize() + 1);
-			*(node_array_ + key_idx) = {key, value};
-		}
+		// shift everything at and after the key idx back one to make space
+		std::memmove(EntryAt(key_idx + 1), EntryAt(key_idx), (GetSize() - key_idx) * GetEntrySize());
+		SetEntryAt(key_idx, key, value);
 		IncreaseSize(1);
 	}
-	[[nodiscard]] idx_t FindKeyIndex(const IndexKeyType &key, const Comparator &comparator) const {
+	// the first entry whose key is not less than the key
+	[[nodiscard]] idx_t FindKeyIndex(IndexKeyView key) const {
+		return DispatchKeyComparator(GetKeySize(),
+		                             [this, key](const auto &comparator) { return FindKeyIndex(key, comparator); });
+	}
+	template <typename Comparator>
+	[[nodiscard]] idx_t FindKeyIndex(IndexKeyView key, const Comparator &comparator) const {
 		assert(GetMaxSize() > 0);
-		auto target_idx =
-		    std::lower_bound(node_array_, node_array_ + GetSize(), key,
-		                     [&comparator](const auto &pair, auto k) { return comparator(pair.first, k) < 0; });
-		return std::distance(node_array_, target_idx);
+		idx_t low = 0;
+		idx_t high = GetSize();
+		while (low < high) {
+			auto mid = low + (high - low) / 2;
+			if (comparator(KeyAt(mid), key) < 0) {
+				low = mid + 1;
+			} else {
+				high = mid;
+			}
+		}
+		return low;
 	}
-	[[nodiscard]] std::optional<IndexValueType> Lookup(const IndexKeyType &key, const Comparator &comparator) const {
-
-		idx_t target_index = FindKeyIndex(key, comparator);
+	[[nodiscard]] std::optional<IndexValueType> Lookup(IndexKeyView key) const {
 
-		auto leaf_key = node_array_[target_index].first;
-		LOG_TRACE("comparing to leaf key %s at index %d", IndexKeyTypeToString(leaf_key).c_str(),
-		          static_cast<int>(target_index));
+		idx_t target_index = FindKeyIndex(key);
 
-		if (target_index < GetSize() && leaf_key == key) {
+		if (target_index < GetSize() && KeyComparator<> {}(KeyAt(target_index), key) == 0) {
 			LOG_TRACE("Key %s index is %d", IndexKeyTypeToString(key).c_str(), static_cast<int>(target_index));
-			return node_array_[target_index].second;
+			return ValueAt(target_index);
 		}
 		LOG_TRACE("Key with looked up index %d not found", static_cast<int>(target_index));
 
 		return std::nullopt;
 	}
+	// false if the key is not in the page
+	bool Remove(IndexKeyView key) {
+		auto key_idx = FindKeyIndex(key);
+		if (key_idx == GetSize() || KeyComparator<> {}(KeyAt(key_idx), key) != 0) {
+			return false;
+		}
+		std::memmove(EntryAt(key_idx), EntryAt(key_idx + 1), (GetSize() - key_idx - 1) * GetEntrySize());
+		SetSize(GetSize() - 1);
+		return true;
+	}
+	// append all entries to the recipient, the left sibling, which takes over the link to the next leaf
+	void MoveAllTo(BtreeLeafPage &recipient) {
+		recipient.CopyNFrom(EntryAt(0), GetSize());
+		recipient.SetNextPageId(GetNextPageId());
+		SetSize(0);
+	}
+	// move the first entry to the end of the recipient, the left sibling
+	void MoveFirstToEndOf(BtreeLeafPage &recipient) {
+		recipient.CopyNFrom(EntryAt(0), 1);
+		std::memmove(EntryAt(0), EntryAt(1), (GetSize() - 1) * GetEntrySize());
+		SetSize(GetSize() - 1);
+	}
+	// move the last entry to the front of the recipient, the right sibling
+	void MoveLastToFrontOf(BtreeLeafPage &recipient) {
+		std::memmove(recipient.EntryAt(1), recipient.EntryAt(0), recipient.GetSize() * GetEntrySize());
+		std::memcpy(recipient.EntryAt(0), EntryAt(GetSize() - 1), GetEntrySize());
+		recipient.IncreaseSize(1);
+		SetSize(GetSize() - 1);
+	}
 	void MoveHalfTo(BtreeLeafPage &recipient) {
 		assert(GetMaxSize() > 0);
 		idx_t start_split_indx = GetMinSize();
 		SetSize(start_split_indx);
-		recipient.CopyNFrom(node_array_ + start_split_indx, GetMaxSize() - start_split_indx);
+		recipient.CopyNFrom(EntryAt(start_split_indx), GetMaxSize() - start_split_indx);
 	}
-	void CopyNFrom(LeafNode *items, idx_t size) {
+	// append entries laid out like those of the page
+	void CopyNFrom(const data_t *entries, idx_t size) {
 		assert(GetMaxSize() > 0);
-		std::copy(items, items + size, node_array_ + GetSize());
+		std::memcpy(EntryAt(GetSize()), entries, size * GetEntrySize());
 		IncreaseSize(size);
 	}
+	void Append(const LeafNode &entry) {
+		assert(GetSize() < GetMaxSize() && "leaf is full");
+		SetEntryAt(GetSize(), entry.first, entry.second);
+		IncreaseSize(1);
+	}
 
-	[[nodiscard]] IndexValueType ValueAt(int index) const {
-		return node_array_[index].second;
+	[[nodiscard]] IndexValueType ValueAt(idx_t index) const {
+		IndexValueType value;
+		std::memcpy(&value, EntryAt(index) + GetKeySize(), sizeof(IndexValueType));
+		return value;
 	}
 
 	[[nodiscard]] std::string ToString() const {
@@ -135,8 +181,24 @@ public:
 	}
 
 private:
+	[[nodiscard]] idx_t GetEntrySize() const {
+		return GetKeySize() + sizeof(IndexValueType);
+	}
+	[[nodiscard]] data_t *EntryAt(idx_t index) {
+		return entries_ + index * GetEntrySize();
+	}
+	[[nodiscard]] const data_t *EntryAt(idx_t index) const {
+		return entries_ + index * GetEntrySize();
+	}
+	void SetEntryAt(idx_t index, IndexKeyView key, const IndexValueType &value) {
+		assert(key.size() == GetKeySize() && "key of another index");
+		auto *entry = EntryAt(index);
+		std::memcpy(entry, key.data(), GetKeySize());
+		std::memcpy(entry + GetKeySize(), &value, sizeof(IndexValueType));
+	}
+
 	page_id_t next_page_id_ {INVALID_PAGE_ID};
-	LeafNode node_array_[];
+	data_t entries_[];
 };
 
 static_assert(sizeof(BtreeLeafPage) == LEAF_PAGE_HEADER_SIZE);
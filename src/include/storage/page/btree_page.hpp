@@ -4,6 +4,7 @@
 #include "common/typedef.hpp"
 
 #include <cassert>
+#include <cstdint>
 namespace db {
 
 enum class IndexPageType { INVALID_INDEX_PAGE = 0, HEADER_PAGE, LEAF_PAGE, INTERNAL_PAGE };
@@ -77,10 +78,19 @@ public:
 		return page_id_;
 	}
 
+	// the width of the keys of the page, all pages of an index have the same
+	[[nodiscard]] uint32_t GetKeySize() const {
+		return key_size_;
+	}
+	void SetKeySize(uint32_t key_size) {
+		key_size_ = key_size;
+	}
+
 private:
 	IndexPageType page_type_;
 	page_id_t parent_page_id_ {INVALID_PAGE_ID};
 	page_id_t page_id_;
+	uint32_t key_size_;
 	idx_t size_ {0};
 	idx_t max_size_;
 };
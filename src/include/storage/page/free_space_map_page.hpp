@@ -0,0 +1,58 @@
+#pragma once
+
+#include "common/config.hpp"
+#include "common/typedef.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <optional>
+namespace db {
+static constexpr uint64_t FREE_SPACE_MAP_PAGE_HEADER_SIZE = 8;
+/**
+ * FreeSpaceMapPage is one page of the free-space map of a table. It holds one byte per page of the table data file,
+ * the free bytes of the page divided by FSM_CATEGORY_SIZE, so that 0 stands for pages without room as well as for pages
+ * that are not table heap pages. The pages of a map form a linked list, each covering the next ENTRY_COUNT pages.
+ */
+class FreeSpaceMapPage {
+public:
+	FreeSpaceMapPage() = delete;
+	FreeSpaceMapPage(const FreeSpaceMapPage &other) = delete;
+	FreeSpaceMapPage &operator=(const FreeSpaceMapPage &other) = delete;
+	~FreeSpaceMapPage() = delete;
+
+	static constexpr uint32_t ENTRY_COUNT = PAGE_SIZE - FREE_SPACE_MAP_PAGE_HEADER_SIZE;
+
+	void Init() {
+		next_page_id_ = INVALID_PAGE_ID;
+		std::memset(categories_, 0, ENTRY_COUNT);
+	}
+	[[nodiscard]] page_id_t GetNextPageId() const {
+		return next_page_id_;
+	}
+	void SetNextPageId(page_id_t next_page_id) {
+		next_page_id_ = next_page_id;
+	}
+	[[nodiscard]] uint8_t GetCategory(uint32_t slot) const {
+		return categories_[slot];
+	}
+	void SetCategory(uint32_t slot, uint8_t category) {
+		categories_[slot] = category;
+	}
+	// the first slot from begin on with at least the given category
+	[[nodiscard]] std::optional<uint32_t> FindSlot(uint8_t category, uint32_t begin) const {
+		for (uint32_t slot = begin; slot < ENTRY_COUNT; slot++) {
+			if (categories_[slot] >= category) {
+				return slot;
+			}
+		}
+		return std::nullopt;
+	}
+
+private:
+	// header format: NextPageId (4) | Reserved (4)
+	page_id_t next_page_id_;
+	uint32_t reserved_;
+	uint8_t categories_[0];
+};
+static_assert(sizeof(FreeSpaceMapPage) == FREE_SPACE_MAP_PAGE_HEADER_SIZE);
+} // namespace db
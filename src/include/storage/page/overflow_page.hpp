@@ -0,0 +1,52 @@
+#pragma once
+
+#include "common/config.hpp"
+#include "common/typedef.hpp"
+
+#include <cstdint>
+namespace db {
+static constexpr uint64_t OVERFLOW_PAGE_HEADER_SIZE = 8;
+/**
+ * OverflowPage holds a piece of a varchar value too large to stay in the slot of its tuple. The pages of one value form
+ * a linked list, every page but the last one is full.
+ */
+class OverflowPage {
+public:
+	OverflowPage() = delete;
+	OverflowPage(const OverflowPage &other) = delete;
+	OverflowPage &operator=(const OverflowPage &other) = delete;
+	~OverflowPage() = delete;
+
+	static constexpr uint32_t CAPACITY = PAGE_SIZE - OVERFLOW_PAGE_HEADER_SIZE;
+
+	void Init() {
+		next_page_id_ = INVALID_PAGE_ID;
+		size_ = 0;
+	}
+	[[nodiscard]] page_id_t GetNextPageId() const {
+		return next_page_id_;
+	}
+	void SetNextPageId(page_id_t next_page_id) {
+		next_page_id_ = next_page_id;
+	}
+	[[nodiscard]] uint32_t GetSize() const {
+		return size_;
+	}
+	[[nodiscard]] const char *GetData() const {
+		return data_;
+	}
+	[[nodiscard]] char *GetData() {
+		return data_;
+	}
+	void SetSize(uint32_t size) {
+		size_ = size;
+	}
+
+private:
+	// header format: NextPageId (4) | Size (4)
+	page_id_t next_page_id_;
+	uint32_t size_;
+	char data_[0];
+};
+static_assert(sizeof(OverflowPage) == OVERFLOW_PAGE_HEADER_SIZE);
+} // namespace db
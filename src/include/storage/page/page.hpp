@@ -8,13 +8,14 @@
 #include <cstring>
 
 namespace db {
+class BufferRing;
+
 class Page {
 	friend class BufferPool;
 
 public:
-	explicit Page() {
-		ResetMemory();
-	}
+	// the data is handed out by the buffer pool frame arena
+	explicit Page() = default;
 
 	Page(const Page &) = delete;
 	Page &operator=(const Page &) = delete;
@@ -24,7 +25,7 @@ public:
 	~Page() = default;
 
 	auto GetData() -> char * {
-		return data_.data();
+		return data_;
 	}
 	auto GetPageId() -> PageId {
 		return page_id_;
@@ -46,6 +47,9 @@ public:
 	void WLatch() {
 		rwlatch_.WLock();
 	}
+	[[nodiscard]] bool TryWLatch() {
+		return rwlatch_.TryWLock();
+	}
 	void WUnlatch() {
 		rwlatch_.WUnlock();
 	}
@@ -55,20 +59,47 @@ public:
 	void RUnlatch() {
 		rwlatch_.RUnlock();
 	}
+	// optimistic reads, see ReaderWriterLatch. the buffer pool changes the version whenever it maps the frame to another
+	// page, so the frame may even be read unpinned as long as its page id is checked before the version is validated
+	[[nodiscard]] std::optional<uint64_t> ReadVersion() const {
+		return rwlatch_.ReadVersion();
+	}
+	[[nodiscard]] bool ValidateVersion(uint64_t version) const {
+		return rwlatch_.ValidateVersion(version);
+	}
+	// turn a read latch into a write latch, false if another reader is already upgrading
+	[[nodiscard]] bool UpgradeLatch() {
+		return rwlatch_.Upgrade();
+	}
 	[[nodiscard]] std::string ToString() const {
 		return fmt::format("Page {{ table_id={}, page_id={} is_dirty={}, pin_count={}, data_size={} }}",
-		                   page_id_.table_id_, page_id_.page_number_, is_dirty_, pin_count_, data_.size());
+		                   page_id_.table_id_, page_id_.page_number_, is_dirty_, pin_count_, PAGE_SIZE);
 	}
 
 private:
 	void ResetMemory() {
-		std::memset(data_.data(), 0, PAGE_SIZE);
+		std::memset(data_, 0, PAGE_SIZE);
+	}
+	// the buffer pool maps the frame to another page or to none, only ever while nobody has it pinned
+	void BeginRemap() {
+		rwlatch_.BeginUnlatchedWrite();
+	}
+	void EndRemap() {
+		rwlatch_.EndUnlatchedWrite();
 	}
 	PageId page_id_;
 	bool is_dirty_ = false;
+	// set while the frame is being read in or its previous page written back, guarded by the buffer pool shard latch
+	bool io_in_progress_ = false;
+	// loaded by read-ahead and not requested since, guarded by the buffer pool shard latch
+	bool prefetched_ = false;
+	// a flush of the page is in flight, guarded by the buffer pool shard latch
+	bool flush_in_progress_ = false;
+	// the ring recycling this frame, such frames are not tracked by the replacer, guarded by the buffer pool shard latch
+	const BufferRing *ring_ = nullptr;
 	uint16_t pin_count_ = 0;
 	ReaderWriterLatch rwlatch_;
-	std::array<char, PAGE_SIZE> data_ {};
+	char *data_ {nullptr};
 };
 } // namespace db
 
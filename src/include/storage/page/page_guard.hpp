@@ -26,6 +26,13 @@ public:
 	[[nodiscard]] WritePageGuard UpgradeWrite();
 	// clear all content and unpin page
 	void Drop();
+	// latch the pinned page for a short read without giving up the pin
+	void RLatch() {
+		page_->RLatch();
+	}
+	void RUnlatch() {
+		page_->RUnlatch();
+	}
 
 	page_id_t PageId() {
 		return page_->GetPageId().page_number_;
@@ -53,6 +60,8 @@ private:
 	bool is_dirty_ {false};
 };
 class WritePageGuard {
+	friend class ReadPageGuard;
+
 public:
 	WritePageGuard() = default;
 	WritePageGuard(BufferPool &bpm, Page &page) : guard_(bpm, page) {
@@ -96,10 +105,7 @@ public:
 	void Drop();
 	~ReadPageGuard();
 
-	WritePageGuard UpgradeWrite() {
-		guard_.page_->RUnlatch();
-		return guard_.UpgradeWrite();
-	}
+	WritePageGuard UpgradeWrite();
 	[[nodiscard]] page_id_t PageId() {
 		return guard_.PageId();
 	}
@@ -0,0 +1,122 @@
+#pragma once
+#include "storage/table/tuple.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+namespace db {
+static constexpr uint64_t PAX_PAGE_HEADER_SIZE = 16;
+
+/**
+ * PaxLayout is where the minipages of a PAX page of a schema lie. All pages of a table share it, so it is worked out
+ * once from the schema: the page holds a fixed number of tuples, and every column gets room for the values of that many
+ * tuples.
+ */
+class PaxLayout {
+	friend class PaxPage;
+
+public:
+	// the schema must fit, see Fits
+	explicit PaxLayout(const Schema &schema);
+
+	// whether a page has room for at least one tuple of the schema
+	[[nodiscard]] static bool Fits(const Schema &schema);
+
+	[[nodiscard]] uint16_t GetCapacity() const {
+		return capacity_;
+	}
+	// the size of a value in the minipage of the column, for a varchar column the size of the offset of the value
+	[[nodiscard]] uint32_t GetValueWidth(column_t column_idx) const {
+		return minipages_[column_idx].width_;
+	}
+
+private:
+	struct Minipage {
+		// where the minipage starts in the page
+		uint32_t offset_;
+		uint32_t width_;
+		// where the value, or for a varchar its offset, goes in the serialized tuple
+		uint32_t tuple_offset_;
+		bool is_inlined_;
+	};
+
+	std::vector<Minipage> minipages_;
+	uint32_t inline_size_;
+	uint16_t capacity_;
+	// the end of the last minipage, varchar values are not stored below it
+	uint32_t var_data_start_;
+};
+
+/**
+ * PaxPage is a table heap page laid out by column (PAX). The values of each column are kept together in a minipage,
+ * those of a fixed-size column as a dense array in slot order, so that a scan of a few columns of a wide table only
+ * reads their minipages and can run over them in vectorized loops. A varchar minipage holds the offsets of the values,
+ * which are stored from the end of the page in the format of a serialized tuple, overflow references included.
+ *
+ * Tuples never move, so views of them read the page in place for as long as it stays pinned. Slots of deleted tuples
+ * are not reused.
+ */
+class PaxPage {
+public:
+	PaxPage() = delete;
+	PaxPage(const PaxPage &other) = delete;
+	PaxPage &operator=(const PaxPage &other) = delete;
+	~PaxPage() = delete;
+	void Init();
+	[[nodiscard]] uint32_t GetNumTuples() const {
+		return num_tuples_;
+	}
+	[[nodiscard]] uint32_t GetNumDeletedTuples() const {
+		return num_deleted_tuples_;
+	}
+	[[nodiscard]] page_id_t GetNextPageId() const {
+		return next_page_id_;
+	}
+	void SetNextPageId(page_id_t next_page_id) {
+		next_page_id_ = next_page_id;
+	}
+	// the size of the largest serialized tuple that still fits, 0 once all slots are taken
+	[[nodiscard]] size_t GetFreeSpace(const PaxLayout &layout) const;
+	[[nodiscard]] std::optional<uint16_t> InsertTuple(const PaxLayout &layout, const TupleMeta &meta,
+	                                                  const Tuple &tuple);
+	[[nodiscard]] TupleMeta GetTupleMeta(const RID &rid) const;
+	void UpdateTupleMeta(const TupleMeta &meta, const RID &rid);
+	[[nodiscard]] std::optional<std::pair<TupleMeta, Tuple>> GetTuple(const PaxLayout &layout, const RID &rid) const;
+	// append views of the tuples in the slots [0, end) of the page, end must not exceed the number of tuples
+	void GetTupleViews(const PaxLayout &layout, PageId page_id, uint32_t end,
+	                   std::vector<std::pair<TupleMeta, TupleView>> &views) const;
+	// the values of a fixed-size column of the tuples in slot order, T must match the type of the column
+	template <typename T>
+	[[nodiscard]] std::span<const T> GetColumn(const PaxLayout &layout, column_t column_idx) const {
+		assert(layout.minipages_[column_idx].is_inlined_ && layout.minipages_[column_idx].width_ == sizeof(T));
+		return {reinterpret_cast<const T *>(page_start_ + layout.minipages_[column_idx].offset_), num_tuples_};
+	}
+	[[nodiscard]] const_data_ptr_t GetColumnData(const PaxLayout &layout, column_t column_idx) const {
+		return const_data_ptr_cast(page_start_ + layout.minipages_[column_idx].offset_);
+	}
+	// where the value of the column of the tuple in the slot is, in the format of a serialized tuple
+	[[nodiscard]] const_data_ptr_t GetValuePtr(const PaxLayout &layout, column_t column_idx, uint32_t slot) const;
+	// the size the tuple in the slot has serialized
+	[[nodiscard]] uint32_t GetTupleSize(const PaxLayout &layout, uint32_t slot) const;
+	// serialize the tuple in the slot into data
+	void ReadTuple(const PaxLayout &layout, uint32_t slot, std::vector<data_t> &data) const;
+
+private:
+	// the size of a stored varchar value: its length and data, or an overflow reference
+	[[nodiscard]] static uint32_t GetVarValueSize(const_data_ptr_t value);
+
+	// header format: NextPageId (4) | NumTuples (2) | NumDeletedTuples (2) | VarDataOffset (2) | Reserved (6)
+	// the tuple metas of all slots (1 each), then the minipages, each 8 byte aligned. varchar values are laid out
+	// from the end of the page down to VarDataOffset
+	char page_start_[0];
+	page_id_t next_page_id_;
+	uint16_t num_tuples_;
+	uint16_t num_deleted_tuples_;
+	uint16_t var_data_offset_;
+	uint16_t reserved_[3];
+	TupleMeta tuple_metas_[0];
+};
+static_assert(sizeof(PaxPage) == PAX_PAGE_HEADER_SIZE);
+} // namespace db
@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <optional>
 #include <tuple>
+#include <vector>
 namespace db {
 static constexpr uint64_t TABLE_PAGE_HEADER_SIZE = 8;
 class TablePage {
@@ -14,6 +15,10 @@ public:
 	[[nodiscard]] auto GetNumTuples() const -> uint32_t {
 		return num_tuples_;
 	}
+	// deleted tuples whose bytes have not been reclaimed by Compact yet
+	[[nodiscard]] auto GetNumDeletedTuples() const -> uint32_t {
+		return num_deleted_tuples_;
+	}
 	[[nodiscard]] auto GetNextPageId() const -> page_id_t {
 		return next_page_id_;
 	}
@@ -21,16 +26,29 @@ public:
 		next_page_id_ = next_page_id;
 	}
 	[[nodiscard]] std::optional<uint16_t> GetNextTupleOffset(const Tuple &tuple) const;
+	// bytes the data of the next inserted tuple may take up, the slot it needs is already taken into account
+	[[nodiscard]] size_t GetFreeSpace() const;
 	[[nodiscard]] std::optional<uint16_t> InsertTuple(const TupleMeta &meta, const Tuple &tuple);
 	[[nodiscard]] auto GetTupleMeta(const RID &rid) const -> TupleMeta;
 	[[nodiscard]] auto GetTuple(const RID &rid) const -> std::optional<std::pair<TupleMeta, Tuple>>;
+	// the tuple read in place, the view is valid as long as the page stays pinned
+	[[nodiscard]] auto GetTupleView(const RID &rid) const -> std::pair<TupleMeta, TupleView>;
+	// append the tuples in the slots [0, end) of the page read in place, end must not exceed the number of tuples
+	void GetTupleViews(PageId page_id, uint32_t end, std::vector<std::pair<TupleMeta, TupleView>> &views) const;
+	// a deleted tuple whose bytes were reclaimed cannot be undeleted
 	void UpdateTupleMeta(const TupleMeta &meta, const RID &rid);
+	// move the live tuples to the end of the page, dropping the bytes of deleted tuples, and return the bytes freed.
+	// slots keep their numbers, the slots of deleted tuples stay behind empty. tuple data moves, so nobody else may have
+	// the page pinned
+	size_t Compact();
 	void UpdateTupleInPlaceUnsafe(const TupleMeta &meta, const Tuple &tuple, RID rid);
 
 private:
 	// slotted page
 	// header format:  NextPageId (4)| NumTuples(2) | NumDeletedTuples(2)
 	// tuple 1 offset+size+meta | tuple 2 offset+size+meta
+	// tuple data is laid out from the end of the page in slot order, so the last slot has the lowest offset. the slot
+	// of a deleted tuple reclaimed by Compact has size 0
 	using TupleInfo = std::tuple<uint16_t, uint16_t, TupleMeta>;
 
 	char page_start_[0];
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "common/config.hpp"
+#include "common/typedef.hpp"
+
+#include <cstdint>
+#include <cstring>
+namespace db {
+static constexpr uint64_t ZONE_MAP_PAGE_HEADER_SIZE = 8;
+/**
+ * ZoneMapPage is one page of the zone map of a table. It holds one zone per page of the table data file, all of the
+ * size the schema of the table asks for. The pages of a map form a linked list, each covering the next entry count
+ * pages.
+ */
+class ZoneMapPage {
+public:
+	ZoneMapPage() = delete;
+	ZoneMapPage(const ZoneMapPage &other) = delete;
+	ZoneMapPage &operator=(const ZoneMapPage &other) = delete;
+	~ZoneMapPage() = delete;
+
+	// zone format: NextPageId (4) | IsTracked (4) | column 1 min (8) + max (8) | column 2 min (8) + max (8) ...
+	struct Zone {
+		// the page linked after the heap page, so that a scan can skip the heap page without reading it
+		page_id_t next_page_id_;
+		// zones of pages that are not heap pages, or of heap pages from before the zone map, are not tracked
+		uint32_t is_tracked_;
+		int64_t bounds_[0];
+	};
+	static_assert(sizeof(Zone) == 8);
+
+	[[nodiscard]] static constexpr uint32_t GetZoneSize(uint32_t column_count) {
+		return sizeof(Zone) + 2 * sizeof(int64_t) * column_count;
+	}
+	[[nodiscard]] static constexpr uint32_t GetZoneCount(uint32_t zone_size) {
+		return (PAGE_SIZE - ZONE_MAP_PAGE_HEADER_SIZE) / zone_size;
+	}
+
+	void Init() {
+		next_page_id_ = INVALID_PAGE_ID;
+		std::memset(zones_, 0, PAGE_SIZE - ZONE_MAP_PAGE_HEADER_SIZE);
+	}
+	[[nodiscard]] page_id_t GetNextPageId() const {
+		return next_page_id_;
+	}
+	void SetNextPageId(page_id_t next_page_id) {
+		next_page_id_ = next_page_id;
+	}
+	[[nodiscard]] const Zone &GetZone(uint32_t slot, uint32_t zone_size) const {
+		return *reinterpret_cast<const Zone *>(zones_ + slot * zone_size);
+	}
+	[[nodiscard]] Zone &GetZone(uint32_t slot, uint32_t zone_size) {
+		return *reinterpret_cast<Zone *>(zones_ + slot * zone_size);
+	}
+
+private:
+	// header format: NextPageId (4) | Reserved (4)
+	page_id_t next_page_id_;
+	uint32_t reserved_;
+	char zones_[0];
+};
+static_assert(sizeof(ZoneMapPage) == ZONE_MAP_PAGE_HEADER_SIZE);
+} // namespace db
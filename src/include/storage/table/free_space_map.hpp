@@ -0,0 +1,45 @@
+#pragma once
+
+#include "common/typedef.hpp"
+#include "storage/buffer/buffer_pool.hpp"
+#include "storage/page/free_space_map_page.hpp"
+#include "storage/table/table_meta.hpp"
+
+#include <optional>
+namespace db {
+/**
+ * FreeSpaceMap tracks about how many bytes are free on each page of a table heap, so that inserts find a page with room
+ * without visiting the heap pages. Its pages live in the table data file and go through the buffer pool like the heap
+ * pages, the first one is recorded in the TableMeta.
+ *
+ * The map only ever has to be approximate: it is updated when a page is added to the heap, when an insert found a
+ * page to have less room than recorded, and when space is reclaimed. Free bytes are rounded down to FSM_CATEGORY_SIZE.
+ */
+class FreeSpaceMap {
+public:
+	FreeSpaceMap(BufferPool &bpm, TableMeta &table_meta, PageAllocator &page_allocator)
+	    : bpm_(bpm), table_meta_(table_meta), page_allocator_(page_allocator) {
+	}
+
+	// allocate the first page of the map, must hold the heap latch of the table
+	void Create();
+	// record that the heap page has about free_bytes free
+	void Update(page_id_t page_number, size_t free_bytes);
+	// a heap page recorded with at least free_bytes free, looking at the pages from start on first and wrapping around
+	[[nodiscard]] std::optional<page_id_t> Search(size_t free_bytes, page_id_t start);
+	// the free bytes recorded for the heap page, rounded down
+	[[nodiscard]] size_t GetFreeSpace(page_id_t page_number);
+
+private:
+	// the page of the map with the entry of the heap page, the map grows to cover it if it does not yet
+	WritePageGuard FetchEntryPage(page_id_t page_number);
+	// the page of the map following the given one, appended if it is the last one
+	page_id_t Grow(page_id_t page_number);
+	// search the entries of the heap pages in [begin, end)
+	std::optional<page_id_t> SearchRange(uint8_t category, page_id_t begin, page_id_t end);
+
+	BufferPool &bpm_;
+	TableMeta &table_meta_;
+	PageAllocator &page_allocator_;
+};
+} // namespace db
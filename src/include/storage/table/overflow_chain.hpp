@@ -0,0 +1,24 @@
+#pragma once
+
+#include "common/page_id.hpp"
+#include "common/typedef.hpp"
+#include "storage/buffer/buffer_pool.hpp"
+#include "storage/page_allocator.hpp"
+
+#include <string>
+#include <string_view>
+namespace db {
+/**
+ * A varchar value too large to be kept in its tuple is stored in a chain of overflow pages of the table data file. The
+ * tuple keeps the length of the value with VARCHAR_OVERFLOW_FLAG set, followed by the first page of the chain, and the
+ * value is only read from the chain when the column is.
+ */
+// bytes an overflowed value takes up in its tuple: the flagged length and the first page of the chain
+static constexpr uint32_t VARCHAR_OVERFLOW_REF_SIZE = sizeof(uint32_t) + sizeof(page_id_t);
+
+// write the value to a chain of new pages, returns the first one
+[[nodiscard]] page_id_t WriteOverflowChain(BufferPool &bpm, PageAllocator &page_allocator, table_oid_t table_oid,
+                                           std::string_view value);
+// read the value of the given size from the chain starting at the page
+[[nodiscard]] std::string ReadOverflowChain(BufferPool &bpm, PageId first_page_id, uint32_t size);
+} // namespace db
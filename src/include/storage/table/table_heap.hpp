@@ -1,12 +1,23 @@
 #include "common/typedef.hpp"
 #include "storage/buffer/buffer_pool.hpp"
+#include "storage/page/pax_page.hpp"
+#include "storage/table/free_space_map.hpp"
 #include "storage/table/table_iterator.hpp"
 #include "storage/table/table_meta.hpp"
 #include "storage/table/tuple.hpp"
+#include "storage/table/zone_map.hpp"
 
 #include <optional>
+#include <vector>
 namespace db {
 
+struct VacuumStats {
+	uint32_t pages_compacted_ {0};
+	// pages due for compaction that someone else had pinned, they are left for a later vacuum
+	uint32_t pages_skipped_ {0};
+	uint64_t bytes_reclaimed_ {0};
+};
+
 class TableHeap : public PageAllocator {
 	friend class TableIterator;
 	// in memory representation of table heap
@@ -16,22 +27,55 @@ public:
 	TableHeap(TableHeap &&) = delete;
 	TableHeap &operator=(TableHeap &&) = delete;
 	explicit TableHeap(BufferPool &bpm, TableMeta &table_meta);
-	// doesn't ensure the tuple is the same schema as the table
+	// doesn't ensure the tuple is the same schema as the table. the tuple goes to the page the last insert went to if it
+	// has room and is not latched by a concurrent inserter, otherwise to a page with room from the free-space map,
+	// otherwise to a new page. a tuple larger than TUPLE_OVERFLOW_THRESHOLD first has its largest varchar values moved
+	// to overflow pages
 	[[nodiscard]] std::optional<RID> InsertTuple(const TupleMeta &meta, const Tuple &tuple);
+	// fill new pages with the tuples and link them into the heap at once, the rids are in the order of the tuples.
+	// tuples that would not fill a page go through InsertTuple instead, so that small batches leave no half empty pages
+	[[nodiscard]] std::vector<RID> BulkInsertTuples(const TupleMeta &meta, const std::vector<Tuple> &tuples);
 	void UpdateTupleMeta(const TupleMeta &meta, RID rid);
-	[[nodiscard]] std::optional<std::pair<TupleMeta, Tuple>> GetTuple(RID rid) const;
+	[[nodiscard]] std::optional<std::pair<TupleMeta, Tuple>> GetTuple(RID rid, BufferRing *ring = nullptr) const;
 	[[nodiscard]] TupleMeta GetTupleMeta(RID rid);
 	[[nodiscard]] page_id_t GetFirstPageId() const;
-	[[nodiscard]] TableIterator MakeIterator();
+	// a bulk scan reads through a BufferRing so that it does not evict the working set of other queries. with ranges the
+	// scan skips, without reading them, the pages whose zone rules out a tuple in all of the ranges
+	[[nodiscard]] TableIterator MakeIterator(bool bulk_scan = false, std::vector<ZoneRange> ranges = {});
+	// compact the pages with at least deleted_ratio of their tuples deleted and record the space reclaimed in the
+	// free-space map, so that inserts fill it again. rids of the remaining tuples do not change
+	VacuumStats Vacuum(double deleted_ratio = VACUUM_DELETED_RATIO);
+	[[nodiscard]] FreeSpaceMap &GetFreeSpaceMap() {
+		return fsm_;
+	}
+	// where the columns lie on the pages of a table in the PAX layout, nullptr for a table in the row layout
+	[[nodiscard]] const PaxLayout *GetPaxLayout() const {
+		return pax_layout_.has_value() ? &*pax_layout_ : nullptr;
+	}
+	// heap pages only become part of the heap once InsertIntoNewPage links them
 	[[nodiscard]] PageId AllocatePage() final {
 		assert(table_meta_.table_oid_ != INVALID_TABLE_OID);
-		table_meta_.last_table_heap_data_page_id_ = table_meta_.IncrementTableDataPageId();
-		return {table_meta_.table_oid_, table_meta_.last_table_data_page_id_};
+		return {table_meta_.table_oid_, table_meta_.IncrementTableDataPageId()};
 	}
 
 private:
+	// move the largest varchar values of the tuple to overflow chains until it is no larger than TUPLE_OVERFLOW_THRESHOLD
+	Tuple MoveOutLargeValues(const Tuple &tuple);
+	// extend the heap by a page holding the tuple
+	RID InsertIntoNewPage(const TupleMeta &meta, const Tuple &tuple);
+
+	// heap pages are TablePages, or PaxPages for a table in the PAX layout
+	void InitPage(char *page) const;
+	[[nodiscard]] std::optional<uint16_t> InsertIntoPage(char *page, const TupleMeta &meta, const Tuple &tuple) const;
+	[[nodiscard]] size_t GetPageFreeSpace(const char *page) const;
+	[[nodiscard]] uint32_t GetPageNumTuples(const char *page) const;
+	[[nodiscard]] page_id_t GetPageNextPageId(const char *page) const;
+	void SetPageNextPageId(char *page, page_id_t next_page_id) const;
+
 	BufferPool &bpm_;
 	TableMeta &table_meta_;
-	std::mutex latch_;
+	FreeSpaceMap fsm_;
+	ZoneMap zone_map_;
+	std::optional<PaxLayout> pax_layout_;
 };
 } // namespace db
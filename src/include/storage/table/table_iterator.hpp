@@ -1,17 +1,47 @@
 #pragma once
 
 #include "common/rid.hpp"
+#include "storage/buffer/buffer_ring.hpp"
+#include "storage/page/page_guard.hpp"
 #include "storage/table/tuple.hpp"
+#include "storage/table/zone_map.hpp"
 
 #include <cassert>
+#include <memory>
+#include <span>
 #include <utility>
+#include <vector>
 
 namespace db {
 
 class TableHeap;
 
 /**
- * TableIterator enables the sequential scan of a TableHeap.
+ * ColumnBatch holds some fixed-size columns of the tuples of a PAX page, read in place: each column is a dense array of
+ * the values of the tuples in slot order, ready for vectorized loops. Deleted tuples are flagged in the metas instead of
+ * left out, so that the arrays line up.
+ */
+struct ColumnBatch {
+	PageId page_id_ {};
+	// the slot of the first tuple of the batch
+	uint32_t begin_slot_ {0};
+	std::vector<TupleMeta> metas_;
+	std::vector<const_data_ptr_t> columns_;
+
+	[[nodiscard]] size_t Size() const {
+		return metas_.size();
+	}
+	// the values of the i-th column asked for, T must match its type
+	template <typename T>
+	[[nodiscard]] std::span<const T> GetColumn(size_t i) const {
+		return {reinterpret_cast<const T *>(columns_[i]), metas_.size()};
+	}
+};
+
+/**
+ * TableIterator enables the sequential scan of a TableHeap. It works a page at a time: on entering a page it pins it,
+ * reads its slot array under one short read latch and then hands out the tuples of the page without going back to the
+ * buffer pool. Tuples inserted into the page after that are not seen by the scan.
  */
 class TableIterator {
 	friend class Cursor;
@@ -22,23 +52,61 @@ public:
 	TableIterator(TableIterator &&) = delete;
 	TableIterator &operator=(TableIterator &&) = delete;
 
-	TableIterator(const TableHeap &table_heap, RID rid, RID stop_at_rid)
-	    : table_heap_(table_heap), rid_(rid), stop_at_rid_(stop_at_rid) {};
+	// with a ring the scan only recycles the ring's frames instead of cycling the whole buffer pool, with ranges it
+	// skips the pages whose zone rules out a tuple in all of them
+	TableIterator(const TableHeap &table_heap, RID rid, RID stop_at_rid, std::unique_ptr<BufferRing> ring = nullptr,
+	              std::vector<ZoneRange> ranges = {});
 
 	~TableIterator() = default;
 
 	std::optional<std::pair<TupleMeta, Tuple>> GetTuple();
+	// the tuple read in place on its page, which the iterator keeps pinned until it is advanced past the page
+	std::optional<std::pair<TupleMeta, TupleView>> GetTupleView();
+
+	// the tuples not deleted from the cursor to the end of its page, read in place, and moves the cursor to the next
+	// page. pages without such tuples are skipped, so the batch is only empty at the end of the scan. the views are
+	// valid until the iterator is used again
+	std::span<const TupleView> NextBatch();
+
+	// like NextBatch, but only the given fixed-size columns of the tuples, read from their minipages. the table must be
+	// in the PAX layout. the batch is valid until the iterator is used again
+	const ColumnBatch &NextColumnBatch(const std::vector<column_t> &column_idxs);
 
 	auto GetRID() -> RID;
 
 	auto IsEnd() -> bool;
 
+	// pages left out because of their zone
+	[[nodiscard]] uint32_t GetSkippedPageCount() const {
+		return skipped_page_count_;
+	}
+
 	auto operator++() -> TableIterator &;
 
 private:
+	// pin the page of the cursor and read its slot array, unless that page is already loaded
+	void LoadPage();
+	// move the cursor to the first slot of the next page, or to the end. the page left stays pinned
+	void MoveToNextPage();
+	// unpin the loaded page
+	void ReleasePage();
+	// the first page from the given one on that the zone map cannot skip
+	page_id_t SkipPages(page_id_t page_number);
+
 	const TableHeap &table_heap_;
 	RID rid_;
 	RID stop_at_rid_;
+	std::unique_ptr<BufferRing> ring_;
+	// dropped before the ring it may have been read through
+	BasicPageGuard page_guard_;
+	page_id_t pinned_page_number_ {INVALID_PAGE_ID};
+	// the slots of the pinned page up to the stop tuple and the page linked after it, read when the page was loaded
+	std::vector<std::pair<TupleMeta, TupleView>> slots_;
+	page_id_t next_page_number_ {INVALID_PAGE_ID};
+	std::vector<TupleView> batch_;
+	ColumnBatch column_batch_;
+	std::vector<ZoneRange> ranges_;
+	uint32_t skipped_page_count_ {0};
 };
 
 } // namespace db
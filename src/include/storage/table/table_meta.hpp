@@ -6,17 +6,22 @@
 #include "storage/page_allocator.hpp"
 #include "storage/serializer/serializer.hpp"
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <mutex>
 
 namespace db {
 
+// the format of the heap pages of a table, chosen when it is created. Row pages keep the tuples whole, PAX pages keep
+// the values of each column together, which suits scans of a few columns of a wide table
+enum class PageLayout : uint8_t { Row, Pax };
+
 struct TableMeta {
 	explicit TableMeta() = default;
 
-	TableMeta(Schema schema, std::string name, table_oid_t table_oid)
-	    : schema_ {std::move(schema)}, name_ {std::move(name)}, table_oid_ {table_oid} {
+	TableMeta(Schema schema, std::string name, table_oid_t table_oid, PageLayout layout = PageLayout::Row)
+	    : schema_ {std::move(schema)}, name_ {std::move(name)}, table_oid_ {table_oid}, layout_ {layout} {
 	}
 
 	void Serialize(Serializer &serializer) const {
@@ -25,7 +30,11 @@ struct TableMeta {
 		serializer.WriteProperty(102, "table_schema", schema_);
 		serializer.WriteProperty(103, "last_table_data_page_id", last_table_data_page_id_);
 		serializer.WriteProperty(104, "last_table_heap_data_page_id", last_table_heap_data_page_id_);
-		serializer.WriteProperty(105, "tuple_count", tuple_count_);
+		serializer.WriteProperty(105, "tuple_count", tuple_count_.load());
+		serializer.WriteProperty(106, "first_table_heap_data_page_id", first_table_heap_data_page_id_);
+		serializer.WriteProperty(107, "free_space_map_page_id", free_space_map_page_id_);
+		serializer.WriteProperty(108, "zone_map_page_id", zone_map_page_id_);
+		serializer.WriteProperty(109, "page_layout", layout_);
 	}
 
 	[[nodiscard]] static std::unique_ptr<TableMeta> Deserialize(Deserializer &deserializer) {
@@ -35,7 +44,15 @@ struct TableMeta {
 		deserializer.ReadProperty(102, "table_schema", meta->schema_);
 		deserializer.ReadProperty(103, "last_table_data_page_id", meta->last_table_data_page_id_);
 		deserializer.ReadProperty(104, "last_table_heap_data_page_id", meta->last_table_heap_data_page_id_);
-		deserializer.ReadProperty(105, "tuple_count", meta->tuple_count_);
+		meta->tuple_count_ = deserializer.ReadProperty<uint64_t>(105, "tuple_count");
+		// tables written before the free-space map started with their heap and have no map yet
+		deserializer.ReadPropertyWithDefault(106, "first_table_heap_data_page_id", meta->first_table_heap_data_page_id_,
+		                                     page_id_t {START_PAGE_ID});
+		deserializer.ReadPropertyWithDefault(107, "free_space_map_page_id", meta->free_space_map_page_id_,
+		                                     page_id_t {INVALID_PAGE_ID});
+		deserializer.ReadPropertyWithDefault(108, "zone_map_page_id", meta->zone_map_page_id_,
+		                                     page_id_t {INVALID_PAGE_ID});
+		deserializer.ReadPropertyWithDefault(109, "page_layout", meta->layout_, PageLayout::Row);
 		return meta;
 	}
 
@@ -55,9 +72,15 @@ struct TableMeta {
 		return last_table_heap_data_page_id_;
 	}
 
+	[[nodiscard]] page_id_t GetFirstTableHeapDataPageId() const {
+		return first_table_heap_data_page_id_;
+	}
+
 	// effectively bump the end of the table data file
 	page_id_t IncrementTableDataPageId() {
 		assert(table_oid_ != INVALID_TABLE_OID);
+		// heap and index pages of the table are allocated from the same file by different threads
+		std::lock_guard<std::mutex> lock(latch_);
 		if (last_table_data_page_id_ == INVALID_PAGE_ID) {
 			// start from 0
 			return last_table_data_page_id_ = START_PAGE_ID;
@@ -65,19 +88,20 @@ struct TableMeta {
 		return ++last_table_data_page_id_;
 	}
 
-	void IncreaseTupleCount() {
-		tuple_count_++;
+	void IncreaseTupleCount(uint64_t count = 1) {
+		tuple_count_ += count;
 	}
 
 	std::string ToString() const {
 		return fmt::format("TableMeta(name: {}, table_oid: {}, schema: {}, last_table_data_page_id: {}, "
 		                   "last_table_heap_data_page_id: {}, tuple_count: {})",
 		                   name_, table_oid_, schema_.ToString(), last_table_data_page_id_,
-		                   last_table_heap_data_page_id_, tuple_count_);
+		                   last_table_heap_data_page_id_, tuple_count_.load());
 	}
 	Schema schema_;
 	std::string name_;
 	table_oid_t table_oid_ {INVALID_TABLE_OID};
+	PageLayout layout_ {PageLayout::Row};
 
 	static constexpr page_id_t START_PAGE_ID = 0;
 	// the last page id of the table data file
@@ -90,9 +114,21 @@ struct TableMeta {
 	// the last page id of the table heap file
 	// effectively the end of the table heap
 	page_id_t last_table_heap_data_page_id_ {INVALID_PAGE_ID};
-
-	uint64_t tuple_count_ {0};
+	// the head of the linked list of table heap pages
+	page_id_t first_table_heap_data_page_id_ {INVALID_PAGE_ID};
+	// the first page of the free-space map of the table heap
+	page_id_t free_space_map_page_id_ {INVALID_PAGE_ID};
+	// the first page of the zone map of the table heap
+	page_id_t zone_map_page_id_ {INVALID_PAGE_ID};
+	// the heap page the last insert went to, where the next insert tries first. not persisted
+	std::atomic<page_id_t> insert_page_id_ {INVALID_PAGE_ID};
+
+	std::atomic<uint64_t> tuple_count_ {0};
 	std::mutex latch_;
+	// guards linking new pages into the table heap and into the free-space map
+	std::mutex heap_latch_;
+	// guards growing the zone map, which happens while the heap latch is held
+	std::mutex zone_map_latch_;
 };
 } // namespace db
 
@@ -4,7 +4,11 @@
 #include "common/typedef.hpp"
 
 #include <string>
+#include <utility>
+#include <vector>
 namespace db {
+class BufferPool;
+class PaxLayout;
 
 static constexpr size_t TUPLE_META_SIZE = 1;
 
@@ -24,7 +28,9 @@ static_assert(sizeof(TupleMeta) == TUPLE_META_SIZE);
 class Tuple {
 
 	friend class TablePage;
+	friend class PaxPage;
 	friend class TableHeap;
+	friend class TupleView;
 
 public:
 	// Default constructor (to create a dummy tuple)
@@ -47,10 +53,19 @@ public:
 		rid_ = rid;
 	}
 
+	[[nodiscard]] RID GetRid() const {
+		return rid_;
+	}
+
 	[[nodiscard]] const_data_ptr_t GetData() const {
 		return data_.data();
 	}
 
+	// the buffer pool overflowed varchar values of the tuple are read through
+	void SetBufferPool(BufferPool *bpm) {
+		bpm_ = bpm;
+	}
+
 	[[nodiscard]] inline auto GetStorageSize() const -> uint32_t {
 		return data_.size();
 	}
@@ -61,13 +76,75 @@ public:
 
 	[[nodiscard]] std::string ToString(const Schema &schema) const;
 
-private:
-	// Get the starting storage address of specific column
-	[[nodiscard]] const_data_ptr_t GetDataPtr(const Column &col) const;
+	// a copy of the tuple with the varchar values of the given columns replaced by references to the overflow chains
+	// they were written to, given as pairs of column index and first page of the chain
+	[[nodiscard]] Tuple WithOverflowValues(const Schema &schema,
+	                                       const std::vector<std::pair<uint32_t, page_id_t>> &chains) const;
 
+private:
 	RID rid_ {};
 
 	// char *data_;
 	std::vector<data_t> data_;
+	BufferPool *bpm_ {nullptr};
+};
+
+/**
+ * TupleView reads the columns of a serialized tuple where it lies, typically on a pinned page, without copying it into
+ * a Tuple. It does not own the bytes: a view into a page is only valid while the page stays pinned, for a view handed
+ * out by a TableIterator until the iterator is advanced. A Tuple converts to a view of its own data.
+ *
+ * Varchar values moved to overflow pages are only read from them, through the buffer pool of the view, when their
+ * column is. A view of a tuple on a PaxPage reads each value from the minipage of its column, so only the columns read
+ * are touched.
+ */
+class TupleView {
+public:
+	TupleView() = default;
+	TupleView(const_data_ptr_t data, uint32_t size, RID rid) : data_(data), size_(size), rid_(rid) {
+	}
+	// the tuple in the slot of the rid on the PAX page
+	TupleView(const_data_ptr_t page, const PaxLayout &layout, RID rid) : data_(page), rid_(rid), pax_layout_(&layout) {
+	}
+	// implicit, so that a tuple can be passed wherever a view is expected
+	TupleView(const Tuple &tuple)
+	    : data_(tuple.data_.data()), size_(tuple.data_.size()), rid_(tuple.rid_), bpm_(tuple.bpm_) {
+	}
+
+	// the serialized tuple, or for a view of a PAX page the page
+	[[nodiscard]] const_data_ptr_t GetData() const {
+		return data_;
+	}
+	[[nodiscard]] uint32_t GetStorageSize() const;
+	[[nodiscard]] RID GetRid() const {
+		return rid_;
+	}
+	void SetBufferPool(BufferPool *bpm) {
+		bpm_ = bpm;
+	}
+
+	[[nodiscard]] Value GetValue(const Column &col) const;
+
+	[[nodiscard]] Value GetValue(const Schema &schema, uint32_t column_idx) const;
+
+	// whether the varchar value of the column is kept in overflow pages
+	[[nodiscard]] bool IsOverflowed(const Column &col) const;
+
+	[[nodiscard]] std::string ToString(const Schema &schema) const;
+
+	// copy the tuple out, for when it has to outlive the bytes it is read from
+	[[nodiscard]] Tuple ToTuple() const;
+	// like ToTuple, but reuses the buffer of the tuple, which does not allocate once it is large enough
+	void CopyTo(Tuple &tuple) const;
+
+private:
+	// Get the starting storage address of specific column
+	[[nodiscard]] const_data_ptr_t GetDataPtr(const Column &col) const;
+
+	const_data_ptr_t data_ {nullptr};
+	uint32_t size_ {0};
+	RID rid_ {};
+	BufferPool *bpm_ {nullptr};
+	const PaxLayout *pax_layout_ {nullptr};
 };
 } // namespace db
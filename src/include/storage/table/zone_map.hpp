@@ -0,0 +1,75 @@
+#pragma once
+
+#include "common/typedef.hpp"
+#include "common/value.hpp"
+#include "storage/buffer/buffer_pool.hpp"
+#include "storage/page/zone_map_page.hpp"
+#include "storage/table/table_meta.hpp"
+#include "storage/table/tuple.hpp"
+
+#include <optional>
+#include <shared_mutex>
+#include <utility>
+#include <vector>
+namespace db {
+
+// a scan that only wants the tuples whose column lies in [min_, max_], in zone keys
+struct ZoneRange {
+	uint32_t column_idx_;
+	int64_t min_;
+	int64_t max_;
+};
+
+// the smallest and largest key of each fixed-size column over some tuples, in the order of the columns
+using ZoneBounds = std::vector<std::pair<int64_t, int64_t>>;
+
+/**
+ * ZoneMap keeps the smallest and largest value of every fixed-size column of each table heap page, so that a scan can
+ * skip the pages that cannot hold a tuple it is after without reading them. Its pages live in the table data file like
+ * those of the FreeSpaceMap, the first one is recorded in the TableMeta. A schema with more fixed-size columns than a
+ * zone has room for only keeps the bounds of the first ones.
+ *
+ * A zone is only ever widened: deleting tuples leaves it as it is, which keeps it correct if loose. Heap pages start
+ * being tracked when they are created, pages of heaps written before the zone map are never skipped. Since heap pages
+ * are not linked in the order of their numbers, a zone also records the page linked after its heap page.
+ */
+class ZoneMap {
+public:
+	ZoneMap(BufferPool &bpm, TableMeta &table_meta, PageAllocator &page_allocator);
+
+	// allocate the first page of the map, must hold the heap latch of the table
+	void Create();
+	// bounds that no tuple lies in, to be extended by the tuples of a page
+	[[nodiscard]] ZoneBounds MakeBounds() const;
+	void Extend(ZoneBounds &bounds, const TupleView &tuple) const;
+	// start tracking a heap page that was just initialized, with the bounds of the tuples already on it
+	void Track(page_id_t page_number, const ZoneBounds &bounds);
+	// widen the zone of the heap page to cover the tuple, untracked pages stay untracked
+	void Extend(page_id_t page_number, const TupleView &tuple);
+	void SetNextPageId(page_id_t page_number, page_id_t next_page_number);
+	// the page linked after the heap page if none of its tuples can lie in all of the ranges, empty if the page has to
+	// be read
+	[[nodiscard]] std::optional<page_id_t> Skip(page_id_t page_number, const std::vector<ZoneRange> &ranges) const;
+	// the key of a fixed-size value, keys order like the values they stand for
+	[[nodiscard]] static int64_t ToZoneKey(const Value &value);
+
+private:
+	// the page of the map with the zone of the heap page, the map grows to cover it if it does not yet
+	WritePageGuard FetchZonePage(page_id_t page_number);
+	// the map_index-th page of the map, INVALID_PAGE_ID if the map does not reach that far yet
+	[[nodiscard]] page_id_t GetMapPage(size_t map_index) const;
+	// append a page to the map unless someone else just did
+	void Grow();
+
+	BufferPool &bpm_;
+	TableMeta &table_meta_;
+	PageAllocator &page_allocator_;
+	// the fixed-size columns of the schema, in the order their bounds are kept in a zone
+	std::vector<uint32_t> columns_;
+	uint32_t zone_size_;
+	uint32_t zone_count_;
+	// the pages of the map in chain order as far as they were looked up, so that finding a zone does not walk the chain
+	mutable std::shared_mutex map_page_latch_;
+	mutable std::vector<page_id_t> map_page_numbers_;
+};
+} // namespace db
@@ -5,19 +5,28 @@
 #include "index/bplus_tree_index.hpp"
 #include "index/index.hpp"
 #include "storage/file_path_manager.hpp"
+#include "storage/page/pax_page.hpp"
+#include "storage/table/table_heap.hpp"
+#include "storage/table/table_iterator.hpp"
 
 #include <optional>
+#include <utility>
+#include <vector>
 
 namespace db {
 
-std::optional<table_oid_t> Catalog::CreateTable(const std::string &table_name, const Schema &schema) {
+std::optional<table_oid_t> Catalog::CreateTable(const std::string &table_name, const Schema &schema,
+                                                PageLayout layout) {
 	if (table_names_.contains(table_name)) {
 		return std::nullopt;
 	}
+	if (layout == PageLayout::Pax && !PaxLayout::Fits(schema)) {
+		throw RuntimeException(fmt::format("Table {} has too many or too wide columns for the PAX layout", table_name));
+	}
 	const table_oid_t table_oid = tables_.size();
 	table_names_.emplace(table_name, table_oid);
 
-	auto table_meta = std::make_unique<TableMeta>(schema, table_name, table_oid);
+	auto table_meta = std::make_unique<TableMeta>(schema, table_name, table_oid, layout);
 
 	tables_.insert({table_oid, std::move(table_meta)});
 	index_names_.emplace(table_name, std::unordered_map<std::string, index_oid_t> {});
@@ -30,8 +39,8 @@ std::optional<table_oid_t> Catalog::CreateTable(const std::string &table_name, c
 }
 
 std::optional<index_oid_t> Catalog::CreateIndex(const std::string &index_name, const std::string &table_name,
-                                                       const Column &key_col, bool is_primary_key, IndexType index_type,
-                                                       BufferPool &bpm) {
+                                                std::vector<Column> key_cols, bool is_primary_key,
+                                                IndexType index_type, BufferPool &bpm) {
 	if (table_names_.find(table_name) == table_names_.end()) {
 		return std::nullopt;
 	}
@@ -43,14 +52,39 @@ std::optional<index_oid_t> Catalog::CreateIndex(const std::string &index_name, c
 	}
 	table_oid_t table_id = table_names_[table_name];
 
-	// IndexMeta(std::string name, table_oid_t table_id, Column key_col, IndexConstraintType index_constraint_type)
 	IndexConstraintType constraint_type = is_primary_key ? IndexConstraintType::PRIMARY : IndexConstraintType::NONE;
-	auto index_meta = std::make_unique<IndexMeta>(index_name, table_id, key_col, constraint_type, index_type);
+	auto index_meta =
+	    std::make_unique<IndexMeta>(index_name, table_id, std::move(key_cols), constraint_type, index_type);
 
 	std::unique_ptr<Index> index;
 	const auto &table_meta = tables_.at(table_names_.at(table_name));
 	if (index_type == IndexType::BPlusTreeIndex) {
 		auto btree_index = std::make_unique<BTreeIndex>(*index_meta, *table_meta, bpm);
+		if (table_meta->GetLastTableHeapDataPageId() != INVALID_PAGE_ID) {
+			// the keys of a populated table are sorted and built into the tree at once
+			TableHeap table_heap(bpm, *table_meta);
+			std::vector<std::pair<IndexKeyType, RID>> entries;
+			entries.reserve(table_meta->tuple_count_.load());
+			const auto &key_layout = btree_index->GetKeyLayout();
+			std::vector<Value> key_values;
+			auto it = table_heap.MakeIterator(true);
+			for (auto batch = it.NextBatch(); !batch.empty(); batch = it.NextBatch()) {
+				for (const auto &view : batch) {
+					key_values.clear();
+					for (const auto &key_col : key_layout.GetKeyColumns()) {
+						key_values.push_back(view.GetValue(key_col));
+					}
+					auto key = key_layout.Encode(key_values);
+					if (!key.has_value()) {
+						throw RuntimeException(fmt::format("Row {} has a key value longer than its column",
+						                                   view.GetRid().ToString()));
+					}
+					entries.emplace_back(std::move(*key), view.GetRid());
+				}
+			}
+			// throws on rows with the same key, before the index is registered
+			btree_index->BulkLoad(std::move(entries));
+		}
 	} else {
 		throw NotImplementedException("Unsupported index type");
 	}
@@ -1,7 +1,10 @@
 #include "query/executors/insert_executor.hpp"
 
+#include "common/config.hpp"
 #include "storage/table/table_heap.hpp"
 
+#include <vector>
+
 namespace db {
 
 bool InsertExecutor::Next(Tuple &tuple, RID &rid) {
@@ -17,30 +20,36 @@ bool InsertExecutor::Next(Tuple &tuple, RID &rid) {
 	auto table_heap = std::make_unique<TableHeap>(exec_ctx_.GetBufferPoolManager(), table_meta);
 	LOG_TRACE("created table heap");
 
-	while (child_executor_->Next(t, r)) {
+	// the tuples are handed to the table heap in batches, which fills whole pages at once for large inserts
+	std::vector<Tuple> batch;
+	auto insert_batch = [&]() {
 		TupleMeta meta = TupleMeta();
 		meta.is_deleted_ = false;
-
-		LOG_TRACE("got tuple {} from child executor", t.ToString(child_executor_->GetOutputSchema()));
-
-		auto return_rid = table_heap->InsertTuple(meta, t);
-
-		if (return_rid.has_value()) {
-			rid = return_rid.value();
-			changed_row_count++;
-			table_meta.tuple_count_++;
-			// TODO: insert to index
-
-			// for (auto index : index_info_) {
-			// 	auto key = t.KeyFromTuple(table_info_->schema_, index->key_schema_, index->index_->GetKeyAttrs());
-			// 	auto rid_val = return_rid.value();
-			// 	index->index_->InsertEntry(key, rid_val, exec_ctx_->GetTransaction());
-			// }
-		} else {
+		auto rids = table_heap->BulkInsertTuples(meta, batch);
+		if (rids.size() != batch.size()) {
 			throw std::runtime_error("Failed to insert tuple");
-			return false;
+		}
+		if (!rids.empty()) {
+			rid = rids.back();
+		}
+		changed_row_count += static_cast<int32_t>(rids.size());
+		// TODO: insert to index
+
+		// for (auto index : index_info_) {
+		// 	auto key = t.KeyFromTuple(table_info_->schema_, index->key_schema_, index->index_->GetKeyAttrs());
+		// 	auto rid_val = return_rid.value();
+		// 	index->index_->InsertEntry(key, rid_val, exec_ctx_->GetTransaction());
+		// }
+		batch.clear();
+	};
+	while (child_executor_->Next(t, r)) {
+		LOG_TRACE("got tuple {} from child executor", t.ToString(child_executor_->GetOutputSchema()));
+		batch.push_back(std::move(t));
+		if (batch.size() == BULK_INSERT_BATCH_SIZE) {
+			insert_batch();
 		}
 	}
+	insert_batch();
 
 	std::vector<Value> values = {Value(TypeId::INTEGER, changed_row_count)};
 	tuple = Tuple(values, plan_->OutputSchema());
@@ -1,22 +1,98 @@
 #include "query/executors/seq_scan_executor.hpp"
 
+#include "common/comparison_type.hpp"
+#include "common/logic_type.hpp"
+#include "query/expressions/column_value_expression.hpp"
+#include "query/expressions/comparison_expression.hpp"
+#include "query/expressions/constant_value_expression.hpp"
+#include "query/expressions/logic_expression.hpp"
+#include "storage/table/zone_map.hpp"
+
+#include <limits>
+
 // #include <backward.hpp>
 namespace db {
 
+std::vector<ZoneRange> SeqScanExecutor::CollectZoneRanges(const AbstractExpression *predicate) {
+	std::vector<ZoneRange> ranges;
+	if (predicate == nullptr) {
+		return ranges;
+	}
+	if (const auto *logic = dynamic_cast<const LogicExpression *>(predicate)) {
+		if (logic->GetLogicType() == LogicType::And) {
+			for (const auto &child : logic->GetChildren()) {
+				auto child_ranges = CollectZoneRanges(child.get());
+				ranges.insert(ranges.end(), child_ranges.begin(), child_ranges.end());
+			}
+		}
+		return ranges;
+	}
+	const auto *comparison = dynamic_cast<const ComparisonExpression *>(predicate);
+	if (comparison == nullptr) {
+		return ranges;
+	}
+	auto compare_type = comparison->GetComparisonType();
+	const auto *column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(0).get());
+	const auto *constant = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(1).get());
+	if (column == nullptr) {
+		column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(1).get());
+		constant = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(0).get());
+		compare_type = ComparisonTypeHelper::Flip(compare_type);
+	}
+	if (column == nullptr || constant == nullptr || column->GetReturnType() == TypeId::VARCHAR) {
+		return ranges;
+	}
+	constexpr auto min_key = std::numeric_limits<int64_t>::min();
+	constexpr auto max_key = std::numeric_limits<int64_t>::max();
+	auto key = ZoneMap::ToZoneKey(constant->GetConstValue());
+	auto column_idx = column->GetColIdx();
+	switch (compare_type) {
+	case ComparisonType::Equal:
+		ranges.push_back({column_idx, key, key});
+		break;
+	case ComparisonType::NotEqual:
+		break;
+	case ComparisonType::LessThan:
+		// nothing is less than the smallest key
+		ranges.push_back(key == min_key ? ZoneRange {column_idx, max_key, min_key}
+		                                : ZoneRange {column_idx, min_key, key - 1});
+		break;
+	case ComparisonType::LessThanOrEqual:
+		ranges.push_back({column_idx, min_key, key});
+		break;
+	case ComparisonType::GreaterThan:
+		ranges.push_back(key == max_key ? ZoneRange {column_idx, max_key, min_key}
+		                                : ZoneRange {column_idx, key + 1, max_key});
+		break;
+	case ComparisonType::GreaterThanOrEqual:
+		ranges.push_back({column_idx, key, max_key});
+		break;
+	}
+	return ranges;
+}
+
 bool SeqScanExecutor::Next(Tuple &tuple,  RID &rid) {
 	// backward::SignalHandling sh; // Automatically handles crashes
-	if (table_iter_.IsEnd()) {
-		LOG_TRACE("end");
-		return false;
-	}
-	auto tuple_opt = table_iter_.GetTuple();
-	if (tuple_opt.has_value()) {
-		auto &[meta, t] = *tuple_opt;
-		tuple = t;
+	const auto &predicate = plan_->filter_predicate_;
+	while (true) {
+		// hand out the tuples of one page after the other, the iterator keeps the page of the batch pinned
+		if (batch_position_ == batch_.size()) {
+			batch_ = table_iter_.NextBatch();
+			batch_position_ = 0;
+			if (batch_.empty()) {
+				LOG_TRACE("end");
+				return false;
+			}
+		}
+		const auto &view = batch_[batch_position_++];
+		if (predicate && predicate->Evaluate(view, plan_->OutputSchema()).GetAs<int8_t>() == 0) {
+			continue;
+		}
+		// read the tuple in place and copy it once, into the buffer of the output tuple
+		view.CopyTo(tuple);
 		LOG_TRACE("Got tuple{}", tuple.ToString(plan_->OutputSchema()));
-		rid = table_iter_.GetRID();
-		++table_iter_;
+		rid = view.GetRid();
+		return true;
 	}
-	return true;
 }
 } // namespace db
@@ -2,179 +2,914 @@
 #include "storage/buffer/buffer_pool.hpp"
 
 #include "common/config.hpp"
+#include "common/exception.hpp"
 #include "common/logger.hpp"
+#include "storage/buffer/lru_k_replacer.hpp"
 #include "storage/buffer/random_replacer.h"
 #include "storage/page/page_guard.hpp"
 #include "storage/page_allocator.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <limits>
 #include <cassert>
 #include <memory>
 #include <mutex>
+#include <optional>
+#include <utility>
 #include <vector>
 namespace db {
-BufferPool::BufferPool(frame_id_t pool_size, DiskManager &disk_manager)
-    : pool_size_(pool_size), replacer_(std::make_unique<RandomBogoReplacer>()), disk_manager_(disk_manager),
-      pages_(pool_size) {
+BufferPool::BufferPool(frame_id_t pool_size, DiskManager &disk_manager, ReplacerType replacer_type,
+                       size_t replacer_k, size_t shard_count, bool enable_background_writer,
+                       frame_id_t max_pool_size)
+    : pool_size_(pool_size), max_pool_size_(std::max(pool_size, max_pool_size)), disk_manager_(disk_manager),
+      arena_(max_pool_size_), pages_(max_pool_size_),
+      // small pools are not split, otherwise a single shard could run out of frames while others are idle
+      shards_(std::clamp<size_t>(pool_size / BUFFER_POOL_MIN_FRAMES_PER_SHARD, 1, std::max<size_t>(shard_count, 1))),
+      flush_buffers_(IO_URING_QUEUE_DEPTH) {
+	for (auto &shard : shards_) {
+		shard.replacer_ = MakeReplacer(replacer_type, replacer_k);
+	}
+	for (frame_id_t i = 0; i < max_pool_size_; ++i) {
+		pages_[i].data_ = arena_.GetFrame(i);
+	}
+	// frames are dealt round robin so every shard owns the same share of the pool
 	for (frame_id_t i = 0; i < pool_size_; ++i) {
-		free_list_.emplace_back(i);
+		shards_[i % shards_.size()].free_list_.emplace_back(i);
 	}
+	if (enable_background_writer) {
+		page_writer_ = std::thread(&BufferPool::RunPageWriter, this);
+	}
+	prefetcher_ = std::thread(&BufferPool::RunPrefetcher, this);
 }
 
-bool BufferPool::AllocateFrame(frame_id_t &frame_id) {
-	if (free_list_.empty()) {
-		// gotta evict a random frame because
-		if (!replacer_->Evict(frame_id)) {
-			replacer_->Print();
+BufferPool::~BufferPool() {
+	{
+		std::lock_guard<std::mutex> lock(prefetch_latch_);
+		stop_prefetcher_ = true;
+	}
+	prefetch_cv_.notify_all();
+	prefetcher_.join();
+	{
+		std::lock_guard<std::mutex> lock(writer_latch_);
+		stop_writer_ = true;
+	}
+	writer_cv_.notify_all();
+	if (page_writer_.joinable()) {
+		page_writer_.join();
+	}
+}
+
+std::unique_ptr<Replacer> BufferPool::MakeReplacer(ReplacerType replacer_type, size_t replacer_k) {
+	switch (replacer_type) {
+	case ReplacerType::RANDOM_BOGO:
+		return std::make_unique<RandomBogoReplacer>();
+	case ReplacerType::LRU_K:
+		return std::make_unique<LRUKReplacer>(replacer_k);
+	}
+	std::unreachable();
+}
+
+bool BufferPool::AllocateFrame(BufferPoolShard &shard, frame_id_t &frame_id, std::optional<PageId> &dirty_victim) {
+	dirty_victim = std::nullopt;
+	while (shard.free_list_.empty()) {
+		if (!shard.replacer_->Evict(frame_id)) {
+			shard.replacer_->Print();
 			return false;
 		}
-		assert(pages_[frame_id].pin_count_ == 0);
-		assert(pages_[frame_id].page_id_.page_number_ >= 0);
-		if (pages_[frame_id].is_dirty_) {
-			auto &evict_page = pages_[frame_id];
-			disk_manager_.WritePage(evict_page.GetPageId(), evict_page.GetData());
+		auto &evict_page = pages_[frame_id];
+		assert(evict_page.pin_count_ == 0);
+		assert(evict_page.page_id_.page_number_ >= 0);
+		// the pool is shrinking, a clean retiring victim is given up rather than reused
+		if (!evict_page.is_dirty_ && shard.retiring_frames_.erase(frame_id) > 0) {
+			if (std::exchange(evict_page.prefetched_, false)) {
+				shard.prefetch_wasted_count_++;
+			}
+			shard.page_table_.erase(evict_page.page_id_);
+			evict_page.BeginRemap();
+			evict_page.page_id_.page_number_ = INVALID_PAGE_ID;
+			evict_page.EndRemap();
+			continue;
+		}
+		if (evict_page.is_dirty_) {
+			// the caller writes the victim out after releasing the latch, until then nobody may read it from disk
+			dirty_victim = evict_page.page_id_;
+			shard.writeback_pages_.insert(evict_page.page_id_);
+			SetDirty(shard, frame_id, false);
+			shard.dirty_eviction_count_++;
+		}
+		if (evict_page.prefetched_) {
+			evict_page.prefetched_ = false;
+			shard.prefetch_wasted_count_++;
 		}
-		pages_[frame_id].ResetMemory();
+		// get rid of the stale page table record
+		shard.page_table_.erase(evict_page.page_id_);
 		return true;
 	}
-	frame_id = free_list_.front();
-	free_list_.pop_front();
+	frame_id = shard.free_list_.front();
+	shard.free_list_.pop_front();
 	return true;
 }
 
+bool BufferPool::TakeFrame(BufferPoolShard &shard, BufferRing *ring, frame_id_t &frame_id,
+                           std::optional<PageId> &dirty_victim) {
+	if (ring != nullptr) {
+		if (auto ring_frame_id = RecycleRingFrame(shard, *ring)) {
+			frame_id = *ring_frame_id;
+			dirty_victim = std::nullopt;
+			return true;
+		}
+	}
+	return AllocateFrame(shard, frame_id, dirty_victim);
+}
+
+void BufferPool::SetDirty(BufferPoolShard &shard, frame_id_t frame_id, bool is_dirty) {
+	pages_[frame_id].is_dirty_ = is_dirty;
+	if (is_dirty) {
+		shard.dirty_frames_.insert(frame_id);
+	} else {
+		shard.dirty_frames_.erase(frame_id);
+	}
+}
+
+void BufferPool::WriteBackVictim(BufferPoolShard &shard, PageId victim_page_id, Page &page) {
+	try {
+		disk_manager_.WritePage(victim_page_id, page.GetData());
+	} catch (...) {
+		std::lock_guard<std::mutex> lock(shard.latch_);
+		shard.writeback_pages_.erase(victim_page_id);
+		shard.io_cv_.notify_all();
+		throw;
+	}
+	std::lock_guard<std::mutex> lock(shard.latch_);
+	shard.writeback_pages_.erase(victim_page_id);
+	shard.io_cv_.notify_all();
+}
+
+void BufferPool::FreeFrame(BufferPoolShard &shard, frame_id_t frame_id) {
+	if (shard.retiring_frames_.erase(frame_id) == 0) {
+		shard.free_list_.push_back(frame_id);
+	}
+}
+
+void BufferPool::AbortIo(BufferPoolShard &shard, frame_id_t frame_id) {
+	std::lock_guard<std::mutex> lock(shard.latch_);
+	Page &page = pages_[frame_id];
+	shard.page_table_.erase(page.page_id_);
+	shard.replacer_->Remove(frame_id);
+	FreeFrame(shard, frame_id);
+	page.page_id_.page_number_ = INVALID_PAGE_ID;
+	page.pin_count_ = 0;
+	SetDirty(shard, frame_id, false);
+	page.io_in_progress_ = false;
+	page.prefetched_ = false;
+	page.ring_ = nullptr;
+	page.EndRemap();
+	shard.io_cv_.notify_all();
+}
+
+void BufferPool::FinishIo(BufferPoolShard &shard, Page &page) {
+	std::lock_guard<std::mutex> lock(shard.latch_);
+	page.io_in_progress_ = false;
+	page.EndRemap();
+	shard.io_cv_.notify_all();
+}
+
 Page &BufferPool::NewPage(PageAllocator &page_allocator, PageId &page_id) {
-	std::lock_guard<std::mutex> lock(latch_);
+	// the page id decides which shard the page lives in, so it has to be allocated up front
+	page_id = page_allocator.AllocatePage();
+	auto &shard = GetShard(page_id);
+	std::unique_lock<std::mutex> lock(shard.latch_);
+	// pages can be written out of order, so read-ahead may have loaded the hole left for this page from disk
+	for (auto it = shard.page_table_.find(page_id); it != shard.page_table_.end();
+	     it = shard.page_table_.find(page_id)) {
+		Page &stale = pages_[it->second];
+		if (stale.io_in_progress_) {
+			shard.io_cv_.wait(lock);
+			continue;
+		}
+		assert(stale.prefetched_ && stale.pin_count_ == 0 && "a new page can only be resident if it was prefetched");
+		stale.prefetched_ = false;
+		stale.BeginRemap();
+		stale.page_id_.page_number_ = INVALID_PAGE_ID;
+		stale.EndRemap();
+		shard.prefetch_wasted_count_++;
+		shard.replacer_->Remove(it->second);
+		FreeFrame(shard, it->second);
+		shard.page_table_.erase(it);
+	}
 	frame_id_t frame_id = -1;
-	if (!AllocateFrame(frame_id)) {
+	std::optional<PageId> dirty_victim;
+	if (!AllocateFrame(shard, frame_id, dirty_victim)) {
 		throw std::runtime_error("Failed to allocate frame");
 		// return nullptr;
 	}
 	// assert that frame id is not in the free list
-	assert(std::find(free_list_.begin(), free_list_.end(), frame_id) == free_list_.end() &&
+	assert(std::find(shard.free_list_.begin(), shard.free_list_.end(), frame_id) == shard.free_list_.end() &&
 	       "frame id should not be in the free list");
 	// assert that frame id is valid
 	assert(frame_id != -1 && "frame id has to be assigned a valid value here");
 
-	replacer_->Pin(frame_id);
+	shard.replacer_->Pin(frame_id);
 
-	// get rid fo the stale page table record
-	auto page_id_to_replace = pages_[frame_id].page_id_;
-	page_table_.erase(page_id_to_replace);
-
-	// assign passed in page_id to the new page
-	// page_id = AllocatePage(page_id.table_id_);
-	page_id = page_allocator.AllocatePage();
-	page_table_[page_id] = frame_id;
-	assert(page_table_.at(page_id) == frame_id && "page table should have the new page id");
-	assert(page_table_.contains(page_id_to_replace) == false && "page table should not have the old page id");
+	shard.page_table_[page_id] = frame_id;
+	assert(shard.page_table_.at(page_id) == frame_id && "page table should have the new page id");
 	// reset the memory and metadata for the new page
 	Page &page = pages_[frame_id];
+	page.BeginRemap();
 	page.page_id_ = page_id;
+	page.rwlatch_.ResetStats();
 	page.pin_count_ = 1;
 	page.is_dirty_ = false;
-	page.ResetMemory();
+	if (!dirty_victim.has_value()) {
+		page.ResetMemory();
+		page.EndRemap();
+		return page;
+	}
 
+	page.io_in_progress_ = true;
+	lock.unlock();
+	try {
+		WriteBackVictim(shard, *dirty_victim, page);
+	} catch (...) {
+		AbortIo(shard, frame_id);
+		throw;
+	}
+	page.ResetMemory();
+	FinishIo(shard, page);
 	return page;
 }
 
-Page &BufferPool::FetchPage(PageId page_id) {
+Page &BufferPool::FetchPage(PageId page_id, BufferRing *ring) {
 	assert(page_id.page_number_ != INVALID_PAGE_ID && "page number should be valid");
-	std::lock_guard<std::mutex> lock(latch_);
-	if (page_table_.find(page_id) != page_table_.end()) {
-		frame_id_t frame_id = page_table_[page_id];
-		Page &page = pages_[frame_id];
-		page.pin_count_++;
-		replacer_->Pin(frame_id);
-		return page;
+	auto &shard = GetShard(page_id);
+	std::unique_lock<std::mutex> lock(shard.latch_);
+	while (true) {
+		auto it = shard.page_table_.find(page_id);
+		if (it != shard.page_table_.end()) {
+			frame_id_t frame_id = it->second;
+			Page &page = pages_[frame_id];
+			// another thread is reading the page in, wait for it instead of issuing a second read
+			if (page.io_in_progress_) {
+				shard.io_cv_.wait(lock);
+				continue;
+			}
+			page.pin_count_++;
+			shard.hit_count_++;
+			bool prefetched = std::exchange(page.prefetched_, false);
+			if (page.ring_ != nullptr) {
+				// ring frames stay out of the replacer no matter who uses them
+			} else if (prefetched && ring != nullptr) {
+				// read-ahead ran in front of a ring scan, the page belongs to the ring rather than to the main pool
+				shard.replacer_->Remove(frame_id);
+				if (auto spare_frame_id = RecycleRingFrame(shard, *ring)) {
+					pages_[*spare_frame_id].BeginRemap();
+					pages_[*spare_frame_id].page_id_.page_number_ = INVALID_PAGE_ID;
+					pages_[*spare_frame_id].EndRemap();
+					FreeFrame(shard, *spare_frame_id);
+				}
+				AdoptRingFrame(shard, *ring, frame_id);
+			} else if (prefetched) {
+				// the access was already recorded by the prefetch, counting it twice would make every scanned page
+				// look hot to lru-k and leave only the pages prefetched but not yet used to be evicted
+				shard.replacer_->Hold(frame_id);
+			} else {
+				shard.replacer_->Pin(frame_id);
+			}
+			if (!prefetched) {
+				return page;
+			}
+			shard.prefetch_hit_count_++;
+			lock.unlock();
+			// the scan caught up with the prefetched pages, keep the window ahead of it
+			ReadAhead(page_id, ring);
+			return page;
+		}
+		// the page was just evicted and its write back has not landed yet, reading it now would see stale data
+		if (shard.writeback_pages_.contains(page_id)) {
+			shard.io_cv_.wait(lock);
+			continue;
+		}
+		break;
 	}
+	shard.miss_count_++;
 
 	frame_id_t frame_id = -1;
-	if (!AllocateFrame(frame_id)) {
+	std::optional<PageId> dirty_victim;
+	if (!TakeFrame(shard, ring, frame_id, dirty_victim)) {
 		throw std::runtime_error("Failed to allocate frame");
 		// return nullptr;
 	}
 	assert(frame_id != -1 && "frame id has to be assigned a valid value here");
 
-	page_table_.erase(pages_[frame_id].page_id_);
-	page_table_.insert({page_id, frame_id});
+	shard.page_table_.insert({page_id, frame_id});
 
+	// the frame is reserved for the page, the actual io happens without holding the shard latch
 	Page &page = pages_[frame_id];
+	page.BeginRemap();
 	page.page_id_ = page_id;
-	page.pin_count_++;
+	page.rwlatch_.ResetStats();
+	page.pin_count_ = 1;
 	page.is_dirty_ = false;
-	disk_manager_.ReadPage(page_id, page.GetData());
+	page.io_in_progress_ = true;
+	if (ring != nullptr) {
+		AdoptRingFrame(shard, *ring, frame_id);
+	} else {
+		shard.replacer_->Pin(frame_id);
+	}
+	lock.unlock();
+	// queue the following pages before blocking on our own read so that their io overlaps with it
+	ReadAhead(page_id, ring);
 
+	try {
+		if (dirty_victim.has_value()) {
+			WriteBackVictim(shard, *dirty_victim, page);
+		}
+		disk_manager_.ReadPage(page_id, page.GetData());
+	} catch (...) {
+		AbortIo(shard, frame_id);
+		throw;
+	}
+	FinishIo(shard, page);
 	return page;
 }
 
+Page *BufferPool::FetchPageIfResident(PageId page_id) {
+	assert(page_id.page_number_ != INVALID_PAGE_ID && "page number should be valid");
+	auto &shard = GetShard(page_id);
+	std::unique_lock<std::mutex> lock(shard.latch_);
+	while (true) {
+		auto it = shard.page_table_.find(page_id);
+		if (it == shard.page_table_.end()) {
+			return nullptr;
+		}
+		frame_id_t frame_id = it->second;
+		Page &page = pages_[frame_id];
+		if (page.io_in_progress_) {
+			shard.io_cv_.wait(lock);
+			continue;
+		}
+		page.pin_count_++;
+		shard.hit_count_++;
+		bool prefetched = std::exchange(page.prefetched_, false);
+		if (prefetched) {
+			shard.prefetch_hit_count_++;
+		}
+		if (page.ring_ != nullptr) {
+			// ring frames stay out of the replacer no matter who uses them
+		} else if (prefetched) {
+			shard.replacer_->Hold(frame_id);
+		} else {
+			shard.replacer_->Pin(frame_id);
+		}
+		return &page;
+	}
+}
+
 bool BufferPool::UnpinPage(PageId page_id, bool is_dirty) {
 	assert(page_id.page_number_ != INVALID_PAGE_ID);
-	std::lock_guard<std::mutex> lock(latch_);
-	if (page_table_.find(page_id) == page_table_.end()) {
+	auto &shard = GetShard(page_id);
+	std::lock_guard<std::mutex> lock(shard.latch_);
+	auto it = shard.page_table_.find(page_id);
+	if (it == shard.page_table_.end()) {
 		LOG_ERROR("Page %s not found in page table", page_id.ToString().c_str());
 		assert(false);
 		return false;
 	}
-	frame_id_t frame_id = page_table_[page_id];
+	frame_id_t frame_id = it->second;
 	Page &page = pages_[frame_id];
 	if (is_dirty) {
-		page.is_dirty_ = true;
+		SetDirty(shard, frame_id, true);
 	}
 	if (page.pin_count_ == 0) {
 		return false;
 	}
 	page.pin_count_--;
 	assert(page.pin_count_ >= 0);
-	if (page.pin_count_ == 0) {
-		replacer_->Unpin(frame_id);
+	if (page.pin_count_ == 0 && page.ring_ == nullptr) {
+		shard.replacer_->Unpin(frame_id);
 	}
 	return true;
 }
 
+std::optional<frame_id_t> BufferPool::BeginFlush(BufferPoolShard &shard, PageId page_id) {
+	std::unique_lock<std::mutex> lock(shard.latch_);
+	frame_id_t frame_id;
+	while (true) {
+		auto it = shard.page_table_.find(page_id);
+		if (it != shard.page_table_.end()) {
+			frame_id = it->second;
+			if (!pages_[frame_id].io_in_progress_ && !pages_[frame_id].flush_in_progress_) {
+				break;
+			}
+		} else if (!shard.writeback_pages_.contains(page_id)) {
+			return std::nullopt;
+		}
+		// wait for the in-flight read, write back or flush so the page is durable once we return and two flushes of
+		// the same page never land out of order
+		shard.io_cv_.wait(lock);
+	}
+	// keep the frame from being evicted while it is written out, without counting the flush as an access
+	Page &page = pages_[frame_id];
+	if (page.pin_count_++ == 0 && page.ring_ == nullptr) {
+		shard.replacer_->Hold(frame_id);
+	}
+	page.flush_in_progress_ = true;
+	SetDirty(shard, frame_id, false);
+	return frame_id;
+}
+
+void BufferPool::EndFlush(BufferPoolShard &shard, frame_id_t frame_id, bool flushed) {
+	std::lock_guard<std::mutex> lock(shard.latch_);
+	Page &page = pages_[frame_id];
+	page.flush_in_progress_ = false;
+	if (!flushed) {
+		SetDirty(shard, frame_id, true);
+	}
+	if (--page.pin_count_ == 0 && page.ring_ == nullptr) {
+		shard.replacer_->Unpin(frame_id);
+	}
+	shard.io_cv_.notify_all();
+}
+
 bool BufferPool::FlushPage(PageId page_id) {
-	std::lock_guard<std::mutex> lock(latch_);
-	if (page_table_.find(page_id) == page_table_.end()) {
+	auto &shard = GetShard(page_id);
+	auto frame_id = BeginFlush(shard, page_id);
+	if (!frame_id.has_value()) {
 		return false;
 	}
-	frame_id_t frame_id = page_table_[page_id];
-	Page &page = pages_[frame_id];
-	disk_manager_.WritePage(page_id, page.GetData());
-	page.is_dirty_ = false;
+	Page &page = pages_[*frame_id];
+	page.RLatch();
+	try {
+		disk_manager_.WritePage(page_id, page.GetData());
+	} catch (...) {
+		page.RUnlatch();
+		EndFlush(shard, *frame_id, false);
+		throw;
+	}
+	page.RUnlatch();
+	EndFlush(shard, *frame_id, true);
 	return true;
 }
 
+std::vector<PageId> BufferPool::CollectDirtyPages(BufferPoolShard &shard, bool unpinned_only, size_t limit) {
+	std::lock_guard<std::mutex> lock(shard.latch_);
+	std::vector<PageId> page_ids;
+	page_ids.reserve(std::min(limit, shard.dirty_frames_.size()));
+	for (auto frame_id : shard.dirty_frames_) {
+		if (page_ids.size() >= limit) {
+			break;
+		}
+		const Page &page = pages_[frame_id];
+		if (unpinned_only && page.pin_count_ > 0) {
+			continue;
+		}
+		page_ids.push_back(page.page_id_);
+	}
+	return page_ids;
+}
+
 void BufferPool::FlushAllPages() {
-	for (frame_id_t i = 0; i < pool_size_; i++) {
-		FlushPage(pages_[i].page_id_);
+	std::vector<PageId> page_ids;
+	std::vector<PageId> writeback_page_ids;
+	for (auto &shard : shards_) {
+		auto shard_page_ids = CollectDirtyPages(shard, false, std::numeric_limits<size_t>::max());
+		page_ids.insert(page_ids.end(), shard_page_ids.begin(), shard_page_ids.end());
+		std::lock_guard<std::mutex> lock(shard.latch_);
+		writeback_page_ids.insert(writeback_page_ids.end(), shard.writeback_pages_.begin(), shard.writeback_pages_.end());
+	}
+	// evicted pages still being written back are not durable yet either, FlushPage waits for them
+	for (const auto &page_id : writeback_page_ids) {
+		FlushPage(page_id);
+	}
+
+	// every page of a batch stays pinned until its write lands, so a batch must leave enough frames to everyone else
+	size_t batch_size = std::clamp<size_t>(pool_size_ / 4, 1, flush_buffers_.GetFrameCount());
+	// the buffers are aligned so that direct io writes the copies without bouncing them
+	std::lock_guard<std::mutex> flush_lock(flush_latch_);
+	size_t failed = 0;
+	for (size_t begin = 0; begin < page_ids.size(); begin += batch_size) {
+		std::vector<DiskRequest> requests;
+		for (size_t i = begin; i < std::min(begin + batch_size, page_ids.size()); i++) {
+			auto &shard = GetShard(page_ids[i]);
+			auto frame_id = BeginFlush(shard, page_ids[i]);
+			if (!frame_id.has_value()) {
+				continue;
+			}
+			// writing a copy lets the page be latched and modified again while the batch is in flight
+			Page &page = pages_[*frame_id];
+			char *buffer = flush_buffers_.GetFrame(requests.size());
+			page.RLatch();
+			std::memcpy(buffer, page.GetData(), PAGE_SIZE);
+			page.RUnlatch();
+			requests.push_back({true, page_ids[i], buffer, [this, &shard, frame_id = *frame_id, &failed](bool ok) {
+				                    failed += ok ? 0 : 1;
+				                    EndFlush(shard, frame_id, ok);
+			                    }});
+		}
+		disk_manager_.SubmitBatch(requests);
+	}
+	if (failed > 0) {
+		throw IOException("failed to flush " + std::to_string(failed) + " pages");
+	}
+}
+
+void BufferPool::RunPageWriter() {
+	std::unique_lock<std::mutex> lock(writer_latch_);
+	while (!writer_cv_.wait_for(lock, std::chrono::milliseconds(BACKGROUND_WRITER_INTERVAL_MS),
+	                            [this] { return stop_writer_; })) {
+		lock.unlock();
+		for (auto &shard : shards_) {
+			// pinned pages are still being modified, writing them now would most likely be wasted
+			for (const auto &page_id : CollectDirtyPages(shard, true, BACKGROUND_WRITER_MAX_PAGES)) {
+				try {
+					if (FlushPage(page_id)) {
+						std::lock_guard<std::mutex> shard_lock(shard.latch_);
+						shard.background_write_count_++;
+					}
+				} catch (const std::exception &e) {
+					// the page stays dirty, eviction or the next round will retry it
+					LOG_WARN("background writer failed to flush page {}: {}", page_id.ToString(), e.what());
+				}
+			}
+		}
+		lock.lock();
+	}
+}
+
+void BufferPool::ReadAhead(PageId page_id, BufferRing *ring) {
+	// never let read-ahead take over more than half of the pool, or of the ring it reads into
+	auto window = static_cast<page_id_t>(std::min<size_t>(
+	    read_ahead_window_,
+	    ring != nullptr ? ring->GetFramesPerShard() * shards_.size() / 2 : static_cast<size_t>(pool_size_) / 2));
+	if (window == 0) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(prefetch_latch_);
+	auto &state = read_ahead_states_[page_id.table_id_];
+	bool sequential = page_id.page_number_ == state.last_page_number_ + 1;
+	state.last_page_number_ = page_id.page_number_;
+	if (!sequential) {
+		state.window_end_ = page_id.page_number_ + 1;
+		return;
+	}
+	auto window_end = page_id.page_number_ + 1 + window;
+	for (auto page_number = std::max(page_id.page_number_ + 1, state.window_end_); page_number < window_end;
+	     ++page_number) {
+		// the prefetcher is falling behind, queueing more only evicts pages that were not used yet
+		if (prefetch_queue_.size() >= static_cast<size_t>(window)) {
+			break;
+		}
+		prefetch_queue_.push_back({{page_id.table_id_, page_number}, ring});
+		state.window_end_ = page_number + 1;
+	}
+	prefetch_cv_.notify_all();
+}
+
+std::optional<frame_id_t> BufferPool::ReservePrefetchFrame(PageId page_id, BufferRing *ring) {
+	// the table heap ends somewhere, pages past the end of the file do not exist yet
+	if (page_id.page_number_ >= disk_manager_.GetPageCount(page_id.table_id_)) {
+		return std::nullopt;
+	}
+	auto &shard = GetShard(page_id);
+	std::unique_lock<std::mutex> lock(shard.latch_);
+	// a page being written back is dirty in memory until the write lands, reading it now would see stale data
+	if (shard.page_table_.contains(page_id) || shard.writeback_pages_.contains(page_id)) {
+		return std::nullopt;
+	}
+	if (ring != nullptr && IsRingFrontPinned(shard, *ring)) {
+		// the scan still holds the page the ring would recycle next, reading ahead now would take a frame from the
+		// main pool for a page that is only read once
+		return std::nullopt;
+	}
+	frame_id_t frame_id = -1;
+	std::optional<PageId> dirty_victim;
+	if (!TakeFrame(shard, ring, frame_id, dirty_victim)) {
+		return std::nullopt;
+	}
+	shard.page_table_.insert({page_id, frame_id});
+	Page &page = pages_[frame_id];
+	page.BeginRemap();
+	page.page_id_ = page_id;
+	page.rwlatch_.ResetStats();
+	page.pin_count_ = 1;
+	page.is_dirty_ = false;
+	page.io_in_progress_ = true;
+	page.prefetched_ = true;
+	if (ring != nullptr) {
+		AdoptRingFrame(shard, *ring, frame_id);
+	} else {
+		shard.replacer_->Pin(frame_id);
+	}
+	shard.prefetch_count_++;
+	lock.unlock();
+
+	if (dirty_victim.has_value()) {
+		try {
+			WriteBackVictim(shard, *dirty_victim, page);
+		} catch (const std::exception &e) {
+			AbortIo(shard, frame_id);
+			LOG_WARN("failed to write back page {}: {}", dirty_victim->ToString(), e.what());
+			return std::nullopt;
+		}
+	}
+	return frame_id;
+}
+
+void BufferPool::FinishPrefetch(BufferPoolShard &shard, frame_id_t frame_id) {
+	std::lock_guard<std::mutex> lock(shard.latch_);
+	Page &page = pages_[frame_id];
+	page.io_in_progress_ = false;
+	page.EndRemap();
+	if (--page.pin_count_ == 0 && page.ring_ == nullptr) {
+		shard.replacer_->Unpin(frame_id);
+	}
+	shard.io_cv_.notify_all();
+}
+
+void BufferPool::Prefetch(const std::vector<PrefetchRequest> &requests) {
+	std::vector<DiskRequest> disk_requests;
+	disk_requests.reserve(requests.size());
+	for (const auto &request : requests) {
+		auto frame_id = ReservePrefetchFrame(request.page_id_, request.ring_);
+		if (!frame_id.has_value()) {
+			continue;
+		}
+		auto &shard = GetShard(request.page_id_);
+		disk_requests.push_back(
+		    {false, request.page_id_, pages_[*frame_id].GetData(), [this, &shard, frame_id = *frame_id](bool ok) {
+			     // read-ahead is only a hint, the page is read again once it is actually requested
+			     ok ? FinishPrefetch(shard, frame_id) : AbortIo(shard, frame_id);
+		     }});
+	}
+	// the whole window is in flight at once
+	disk_manager_.SubmitBatch(disk_requests);
+}
+
+void BufferPool::RunPrefetcher() {
+	std::unique_lock<std::mutex> lock(prefetch_latch_);
+	while (true) {
+		prefetch_cv_.wait(lock, [this] { return stop_prefetcher_ || !prefetch_queue_.empty(); });
+		if (stop_prefetcher_) {
+			return;
+		}
+		prefetching_.assign(prefetch_queue_.begin(), prefetch_queue_.end());
+		prefetch_queue_.clear();
+		lock.unlock();
+		try {
+			Prefetch(prefetching_);
+		} catch (const std::exception &e) {
+			LOG_WARN("failed to prefetch {} pages: {}", prefetching_.size(), e.what());
+		}
+		lock.lock();
+		prefetching_.clear();
+		prefetch_cv_.notify_all();
+	}
+}
+
+std::optional<frame_id_t> BufferPool::RecycleRingFrame(BufferPoolShard &shard, BufferRing &ring) {
+	auto &frames = ring.frames_[GetShardIndex(shard)];
+	while (frames.size() >= ring.frames_per_shard_) {
+		auto [frame_id, page_id] = frames.front();
+		frames.pop_front();
+		Page &page = pages_[frame_id];
+		if (page.ring_ != &ring || page.page_id_ != page_id) {
+			continue;
+		}
+		if (page.pin_count_ == 0 && !page.is_dirty_ && !page.io_in_progress_) {
+			if (page.prefetched_) {
+				page.prefetched_ = false;
+				shard.prefetch_wasted_count_++;
+			}
+			shard.page_table_.erase(page_id);
+			page.ring_ = nullptr;
+			return frame_id;
+		}
+		// someone else still uses or modified the page, it stays resident and is evicted like any other page
+		DisownRingFrame(shard, frame_id);
+	}
+	return std::nullopt;
+}
+
+bool BufferPool::IsRingFrontPinned(BufferPoolShard &shard, BufferRing &ring) {
+	auto &frames = ring.frames_[GetShardIndex(shard)];
+	if (frames.size() < ring.frames_per_shard_) {
+		return false;
+	}
+	auto [frame_id, page_id] = frames.front();
+	const Page &page = pages_[frame_id];
+	return page.ring_ == &ring && page.page_id_ == page_id && page.pin_count_ > 0;
+}
+
+void BufferPool::AdoptRingFrame(BufferPoolShard &shard, BufferRing &ring, frame_id_t frame_id) {
+	Page &page = pages_[frame_id];
+	page.ring_ = &ring;
+	ring.frames_[GetShardIndex(shard)].emplace_back(frame_id, page.page_id_);
+}
+
+void BufferPool::DisownRingFrame(BufferPoolShard &shard, frame_id_t frame_id) {
+	Page &page = pages_[frame_id];
+	page.ring_ = nullptr;
+	shard.replacer_->Pin(frame_id);
+	if (page.pin_count_ == 0) {
+		shard.replacer_->Unpin(frame_id);
+	}
+}
+
+void BufferPool::ReleaseRing(BufferRing &ring) {
+	{
+		std::unique_lock<std::mutex> lock(prefetch_latch_);
+		std::erase_if(prefetch_queue_, [&ring](const PrefetchRequest &request) { return request.ring_ == &ring; });
+		prefetch_cv_.wait(lock, [this, &ring] {
+			return std::ranges::none_of(prefetching_, [&ring](const PrefetchRequest &request) {
+				return request.ring_ == &ring;
+			});
+		});
+	}
+	for (auto &shard : shards_) {
+		std::lock_guard<std::mutex> lock(shard.latch_);
+		for (auto [frame_id, page_id] : ring.frames_[GetShardIndex(shard)]) {
+			if (pages_[frame_id].ring_ == &ring && pages_[frame_id].page_id_ == page_id) {
+				DisownRingFrame(shard, frame_id);
+			}
+		}
+		ring.frames_[GetShardIndex(shard)].clear();
 	}
 }
 
 bool BufferPool::DeletePage(PageId page_id) {
-	std::lock_guard<std::mutex> lock(latch_);
-	if (page_table_.find(page_id) == page_table_.end()) {
+	auto &shard = GetShard(page_id);
+	std::lock_guard<std::mutex> lock(shard.latch_);
+	auto it = shard.page_table_.find(page_id);
+	if (it == shard.page_table_.end()) {
 		return true;
 	}
-	frame_id_t frame_id = page_table_[page_id];
+	frame_id_t frame_id = it->second;
 	Page &page = pages_[frame_id];
 	if (page.pin_count_ > 0) {
 		return false;
 	}
-	page_table_.erase(page_id);
-	free_list_.push_back(frame_id);
+	if (page.prefetched_) {
+		page.prefetched_ = false;
+		shard.prefetch_wasted_count_++;
+	}
+	shard.page_table_.erase(it);
+	shard.replacer_->Remove(frame_id);
+	FreeFrame(shard, frame_id);
 
-	pages_[frame_id].ResetMemory();
+	page.ring_ = nullptr;
+	page.BeginRemap();
+	page.ResetMemory();
 	page.page_id_.page_number_ = INVALID_PAGE_ID;
+	page.EndRemap();
 	page.pin_count_ = 0;
-	page.is_dirty_ = false;
+	SetDirty(shard, frame_id, false);
 	return true;
 }
 
-BasicPageGuard BufferPool::FetchPageBasic(PageId page_id) {
-	auto &page = FetchPage(page_id);
+void BufferPool::Resize(frame_id_t pool_size) {
+	std::lock_guard<std::mutex> resize_lock(resize_latch_);
+	// the shard count is fixed at construction, every shard must keep a frame
+	if (pool_size < static_cast<frame_id_t>(shards_.size()) || pool_size > max_pool_size_) {
+		throw RuntimeException("cannot resize the buffer pool to " + std::to_string(pool_size) + " frames, it must be in [" +
+		                       std::to_string(shards_.size()) + ", " + std::to_string(max_pool_size_) + "]");
+	}
+	frame_id_t old_pool_size = pool_size_;
+	if (pool_size >= old_pool_size) {
+		for (frame_id_t i = old_pool_size; i < pool_size; ++i) {
+			auto &shard = shards_[i % shards_.size()];
+			std::lock_guard<std::mutex> lock(shard.latch_);
+			// a frame left over from an interrupted shrink still holds its page and simply stays in use
+			if (shard.retiring_frames_.erase(i) == 0) {
+				shard.free_list_.push_back(i);
+			}
+		}
+		pool_size_ = pool_size;
+		return;
+	}
+
+	pool_size_ = pool_size;
+	for (size_t shard_index = 0; shard_index < shards_.size(); shard_index++) {
+		auto &shard = shards_[shard_index];
+		std::lock_guard<std::mutex> lock(shard.latch_);
+		// frames are dealt round robin, the first one given up by this shard is the first above the new size
+		frame_id_t first = pool_size + static_cast<frame_id_t>(
+		                                   (shard_index + shards_.size() - pool_size % shards_.size()) % shards_.size());
+		for (frame_id_t i = first; i < old_pool_size; i += static_cast<frame_id_t>(shards_.size())) {
+			shard.retiring_frames_.insert(i);
+		}
+		// free frames are given up right away
+		std::erase_if(shard.free_list_, [&shard](frame_id_t frame_id) { return shard.retiring_frames_.erase(frame_id) > 0; });
+	}
+	while (true) {
+		size_t remaining = 0;
+		for (auto &shard : shards_) {
+			// flushing dirty pages lets the next round give up their frames without holding the latch during io
+			for (const auto &page_id : RetireFrames(shard)) {
+				FlushPage(page_id);
+			}
+			std::lock_guard<std::mutex> lock(shard.latch_);
+			remaining += shard.retiring_frames_.size();
+		}
+		if (remaining == 0) {
+			break;
+		}
+		// the frames left are pinned, give their users a moment to release them
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	arena_.Release(pool_size, old_pool_size - pool_size);
+}
+
+std::vector<PageId> BufferPool::RetireFrames(BufferPoolShard &shard) {
+	std::vector<PageId> dirty_pages;
+	std::lock_guard<std::mutex> lock(shard.latch_);
+	std::erase_if(shard.retiring_frames_, [&](frame_id_t frame_id) {
+		Page &page = pages_[frame_id];
+		if (page.pin_count_ > 0 || page.io_in_progress_ || page.flush_in_progress_) {
+			return false;
+		}
+		if (page.is_dirty_) {
+			dirty_pages.push_back(page.page_id_);
+			return false;
+		}
+		if (std::exchange(page.prefetched_, false)) {
+			shard.prefetch_wasted_count_++;
+		}
+		// a ring frame is not tracked by the replacer, the ring skips it once it no longer belongs to the ring
+		if (page.ring_ == nullptr) {
+			shard.replacer_->Remove(frame_id);
+		}
+		page.ring_ = nullptr;
+		shard.page_table_.erase(page.page_id_);
+		page.BeginRemap();
+		page.page_id_.page_number_ = INVALID_PAGE_ID;
+		page.EndRemap();
+		return true;
+	});
+	return dirty_pages;
+}
+
+BufferPoolStats BufferPool::GetStats() {
+	BufferPoolStats stats;
+	for (auto &shard : shards_) {
+		std::lock_guard<std::mutex> lock(shard.latch_);
+		stats.hit_count_ += shard.hit_count_;
+		stats.miss_count_ += shard.miss_count_;
+		stats.dirty_eviction_count_ += shard.dirty_eviction_count_;
+		stats.background_write_count_ += shard.background_write_count_;
+		stats.prefetch_count_ += shard.prefetch_count_;
+		stats.prefetch_hit_count_ += shard.prefetch_hit_count_;
+		stats.prefetch_wasted_count_ += shard.prefetch_wasted_count_;
+	}
+	return stats;
+}
+
+bool BufferPool::IsResident(PageId page_id) {
+	auto &shard = GetShard(page_id);
+	std::lock_guard<std::mutex> lock(shard.latch_);
+	return shard.page_table_.contains(page_id);
+}
+
+uint16_t BufferPool::GetPinCount(PageId page_id) {
+	auto &shard = GetShard(page_id);
+	std::lock_guard<std::mutex> lock(shard.latch_);
+	auto it = shard.page_table_.find(page_id);
+	return it == shard.page_table_.end() ? 0 : pages_[it->second].pin_count_;
+}
+
+size_t BufferPool::GetDirtyPageCount() {
+	size_t count = 0;
+	for (auto &shard : shards_) {
+		std::lock_guard<std::mutex> lock(shard.latch_);
+		count += shard.dirty_frames_.size();
+	}
+	return count;
+}
+
+std::vector<PageLatchStats> BufferPool::GetLatchContention(size_t limit) {
+	std::vector<PageLatchStats> contention;
+	for (auto &shard : shards_) {
+		std::lock_guard<std::mutex> lock(shard.latch_);
+		for (const auto &[page_id, frame_id] : shard.page_table_) {
+			const auto &latch = pages_[frame_id].rwlatch_;
+			if (latch.GetWaitCount() > 0) {
+				contention.push_back({page_id, latch.GetWaitCount(), latch.GetWaitNanos()});
+			}
+		}
+	}
+	std::ranges::sort(contention, std::greater {}, &PageLatchStats::wait_nanos_);
+	contention.resize(std::min(contention.size(), limit));
+	return contention;
+}
+
+BasicPageGuard BufferPool::FetchPageBasic(PageId page_id, BufferRing *ring) {
+	auto &page = FetchPage(page_id, ring);
 	return {*this, page};
 }
 
-ReadPageGuard BufferPool::FetchPageRead(PageId page_id) {
-	auto &page = FetchPage(page_id);
+ReadPageGuard BufferPool::FetchPageRead(PageId page_id, BufferRing *ring) {
+	auto &page = FetchPage(page_id, ring);
 	page.RLatch();
 	return {*this, page};
 }
@@ -185,6 +920,15 @@ WritePageGuard BufferPool::FetchPageWrite(PageId page_id) {
 	return {*this, page};
 }
 
+std::optional<WritePageGuard> BufferPool::TryFetchPageWrite(PageId page_id) {
+	auto &page = FetchPage(page_id);
+	if (!page.TryWLatch()) {
+		UnpinPage(page_id, false);
+		return std::nullopt;
+	}
+	return WritePageGuard {*this, page};
+}
+
 BasicPageGuard BufferPool::NewPageGuarded(PageAllocator &page_allocator, PageId &page_id) {
 	auto &page = NewPage(page_allocator, page_id);
 	return {*this, page};
@@ -0,0 +1,19 @@
+#include "storage/buffer/buffer_ring.hpp"
+
+#include "storage/buffer/buffer_pool.hpp"
+
+#include <algorithm>
+
+namespace db {
+BufferRing::BufferRing(BufferPool &bpm, size_t ring_size)
+    : bpm_(bpm),
+      // a ring must never take over a noticeable part of a small pool, but every shard needs at least one frame
+      frames_per_shard_(std::max<size_t>(
+          1, std::min<size_t>(ring_size, bpm.GetPoolSize() / BUFFER_RING_MAX_POOL_FRACTION) / bpm.GetShardCount())),
+      frames_(bpm.GetShardCount()) {
+}
+
+BufferRing::~BufferRing() {
+	bpm_.ReleaseRing(*this);
+}
+} // namespace db
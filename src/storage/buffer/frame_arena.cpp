@@ -0,0 +1,52 @@
+#include "storage/buffer/frame_arena.hpp"
+
+#include "common/exception.hpp"
+#include "common/logger.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <sys/mman.h>
+
+namespace db {
+FrameArena::FrameArena(size_t frame_count)
+    : frame_count_(frame_count), size_(std::max<size_t>(frame_count, 1) * PAGE_SIZE) {
+	void *ptr = MAP_FAILED;
+	// explicit huge pages only exist if the administrator reserved some, mmap fails right away otherwise. they must be
+	// reserved at map time, an unreserved huge page that cannot be backed later faults with SIGBUS
+	if (size_ % HUGE_PAGE_SIZE == 0) {
+		ptr = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		huge_pages_ = ptr != MAP_FAILED;
+	}
+	if (ptr == MAP_FAILED) {
+		// anonymous mappings are page aligned and zero filled
+		ptr = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		if (ptr == MAP_FAILED) {
+			throw RuntimeException("failed to allocate " + std::to_string(frame_count) +
+			                       " buffer pool frames: " + std::string(strerror(errno)));
+		}
+		if (size_ >= HUGE_PAGE_SIZE && madvise(ptr, size_, MADV_HUGEPAGE) != 0) {
+			LOG_DEBUG("transparent huge pages unavailable for the buffer pool: {}", strerror(errno));
+		}
+	}
+	data_ = static_cast<char *>(ptr);
+}
+
+void FrameArena::Release(size_t first, size_t count) {
+	size_t begin = first * PAGE_SIZE;
+	size_t end = (first + count) * PAGE_SIZE;
+	// huge pages can only be dropped as a whole
+	if (huge_pages_) {
+		begin = (begin + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+		end = end / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+	}
+	if (begin < end && madvise(data_ + begin, end - begin, MADV_DONTNEED) != 0) {
+		LOG_WARN("failed to release {} buffer pool frames: {}", count, strerror(errno));
+	}
+}
+
+FrameArena::~FrameArena() {
+	munmap(data_, size_);
+}
+} // namespace db
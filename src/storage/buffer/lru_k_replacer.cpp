@@ -0,0 +1,63 @@
+#include "storage/buffer/lru_k_replacer.hpp"
+
+#include <cassert>
+
+namespace db {
+LRUKReplacer::LRUKReplacer(size_t k) : k_(k) {
+	assert(k_ > 0 && "k has to be at least 1");
+}
+
+auto LRUKReplacer::Evict(frame_id_t &frame_id) -> bool {
+	if (evictable_.empty()) {
+		return false;
+	}
+	auto victim = evictable_.begin();
+	frame_id = victim->second;
+	evictable_.erase(victim);
+	// the frame is about to hold a different page, so its access history no longer applies
+	node_store_.erase(frame_id);
+	return true;
+}
+
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+	auto &node = node_store_[frame_id];
+	if (node.is_evictable_) {
+		evictable_.erase({GetEvictKey(node), frame_id});
+		node.is_evictable_ = false;
+	}
+	node.history_.push_back(current_timestamp_++);
+	if (node.history_.size() > k_) {
+		node.history_.pop_front();
+	}
+}
+
+void LRUKReplacer::Hold(frame_id_t frame_id) {
+	auto it = node_store_.find(frame_id);
+	if (it == node_store_.end() || !it->second.is_evictable_) {
+		return;
+	}
+	evictable_.erase({GetEvictKey(it->second), frame_id});
+	it->second.is_evictable_ = false;
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+	auto it = node_store_.find(frame_id);
+	if (it == node_store_.end() || it->second.is_evictable_) {
+		return;
+	}
+	auto &node = it->second;
+	node.is_evictable_ = true;
+	evictable_.insert({GetEvictKey(node), frame_id});
+}
+
+void LRUKReplacer::Remove(frame_id_t frame_id) {
+	auto it = node_store_.find(frame_id);
+	if (it == node_store_.end()) {
+		return;
+	}
+	if (it->second.is_evictable_) {
+		evictable_.erase({GetEvictKey(it->second), frame_id});
+	}
+	node_store_.erase(it);
+}
+} // namespace db
@@ -6,80 +6,376 @@
 #include "meta/catalog.hpp"
 #include "storage/file_path_manager.hpp"
 
+#include <cerrno>
+#include <cstdint>
 #include <cstddef>
 #include <cstdlib>
 #include <cstring>
+#include <fcntl.h>
 #include <iostream>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace db {
+namespace {
+bool IsAligned(const char *data) {
+	return reinterpret_cast<uintptr_t>(data) % PAGE_SIZE == 0;
+}
+
+// direct io of an unaligned buffer goes through this one
+char *GetBounceBuffer() {
+	alignas(PAGE_SIZE) static thread_local char buffer[PAGE_SIZE];
+	return buffer;
+}
+} // namespace
+
+DiskManager::DiskManager(Catalog &catalog, DiskManagerBackend backend, bool direct_io)
+    : cm_(catalog), backend_(backend), direct_io_(direct_io && backend != DiskManagerBackend::FSTREAM) {
+	if (direct_io && backend == DiskManagerBackend::FSTREAM) {
+		LOG_WARN("direct io is not supported by the fstream backend, using buffered io");
+	}
+}
 
-void DiskManager::AddTableDataIfNotExist(table_oid_t table_id) {
-	if (!table_data_files_.contains(table_id)) {
-		fs::path table_data_path;
+DiskManager::TableDataFile &DiskManager::GetTableDataFile(table_oid_t table_id) {
+	{
+		std::shared_lock<std::shared_mutex> lock(latch_);
+		auto it = table_data_files_.find(table_id);
+		if (it != table_data_files_.end()) {
+			return *it->second;
+		}
+	}
+	std::unique_lock<std::shared_mutex> lock(latch_);
+	auto &file = table_data_files_[table_id];
+	if (file == nullptr) {
+		auto new_file = std::make_unique<TableDataFile>();
+		// resolved once, the catalog is not consulted on the io path anymore
 		if (table_id == SYSTEM_CATALOG_ID) {
-			table_data_path = FilePathManager::GetInstance().GetSystemCatalogPath();
+			new_file->path_ = FilePathManager::GetInstance().GetSystemCatalogPath();
 		} else {
-			auto table_name = cm_.GetTableName(table_id);
-			table_data_path = FilePathManager::GetInstance().GetTableDataPath(table_name);
+			new_file->path_ = FilePathManager::GetInstance().GetTableDataPath(cm_.GetTableName(table_id));
 		}
-		auto data_fs = std::fstream(table_data_path, std::ios::binary | std::ios::in | std::ios::out);
-		if (!data_fs.is_open()) {
-			data_fs.clear();
+		OpenTableDataFile(*new_file);
+		file = std::move(new_file);
+	}
+	return *file;
+}
+
+void DiskManager::OpenTableDataFile(TableDataFile &file) {
+	if (backend_ == DiskManagerBackend::FSTREAM) {
+		file.stream_ = std::fstream(file.path_, std::ios::binary | std::ios::in | std::ios::out);
+		if (!file.stream_.is_open()) {
+			file.stream_.clear();
 			// create a new file
-			data_fs.open(table_data_path, std::ios::binary | std::ios::trunc | std::ios::out | std::ios::in);
-			if (!data_fs.is_open()) {
+			file.stream_.open(file.path_, std::ios::binary | std::ios::trunc | std::ios::out | std::ios::in);
+			if (!file.stream_.is_open()) {
 				throw IOException("failed to open table data file");
 			}
 		}
-		table_data_files_.emplace(table_id, std::move(data_fs));
+		file.stream_.seekg(0, std::ios::end);
+		file.size_ = static_cast<int64_t>(file.stream_.tellg());
+		return;
+	}
+	if (direct_io_) {
+		file.fd_ = open(file.path_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC | O_DIRECT, 0644);
+		file.direct_ = file.fd_ >= 0;
+		// some file systems such as tmpfs refuse O_DIRECT
+		if (file.fd_ < 0 && errno == EINVAL) {
+			LOG_WARN("direct io unsupported for {}, using buffered io", file.path_.string());
+		}
+	}
+	if (file.fd_ < 0) {
+		file.fd_ = open(file.path_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	}
+	if (file.fd_ < 0) {
+		throw IOException("failed to open table data file: " + std::string(strerror(errno)));
 	}
+	struct stat stat_buf;
+	if (fstat(file.fd_, &stat_buf) != 0) {
+		throw IOException("failed to stat table data file: " + std::string(strerror(errno)));
+	}
+	file.size_ = stat_buf.st_size;
 }
 
-void DiskManager::WritePage(PageId page_id, const char *page_data) {
-	AddTableDataIfNotExist(page_id.table_id_);
+namespace {
+void PwriteFully(int fd, const char *data, size_t len, int64_t offset) {
+	size_t written = 0;
+	while (written < len) {
+		auto ret = pwrite(fd, data + written, len - written, offset + static_cast<int64_t>(written));
+		if (ret < 0 && errno == EINTR) {
+			continue;
+		}
+		if (ret <= 0) {
+			throw IOException("failed to write to table data file: " + std::string(strerror(errno)));
+		}
+		written += ret;
+	}
+}
 
-	auto &data_fs = table_data_files_.at(page_id.table_id_);
-	auto offset = page_id.page_number_ * PAGE_SIZE;
-	data_fs.seekp(offset);
-	data_fs.write(page_data, PAGE_SIZE);
-	if (data_fs.bad()) {
-		throw IOException("failed to write to table data file");
+// returns the number of bytes read, less than len only at the end of the file
+size_t PreadFully(int fd, char *data, size_t len, int64_t offset) {
+	size_t read = 0;
+	while (read < len) {
+		auto ret = pread(fd, data + read, len - read, offset + static_cast<int64_t>(read));
+		if (ret < 0 && errno == EINTR) {
+			continue;
+		}
+		if (ret < 0) {
+			throw IOException("failed to read from table data file: " + std::string(strerror(errno)));
+		}
+		if (ret == 0) {
+			break;
+		}
+		read += ret;
 	}
-	// flush to sync data
-	data_fs.flush();
+	return read;
 }
+} // namespace
 
-void DiskManager::ReadPage(PageId page_id, char *page_data) {
-	AddTableDataIfNotExist(page_id.table_id_);
+void DiskManager::GrowFileSize(TableDataFile &file, int64_t end) {
+	auto size = file.size_.load();
+	while (size < end && !file.size_.compare_exchange_weak(size, end)) {
+	}
+}
+
+void DiskManager::CheckReadable(TableDataFile &file, int64_t offset) {
+	if (offset > file.size_) {
+		throw IOException("read page out of file size" + std::to_string(offset) + " " + std::to_string(file.size_));
+	}
+}
 
-	size_t offset = static_cast<size_t>(page_id.page_number_) * PAGE_SIZE;
-	auto data_file_path = FilePathManager::GetInstance().GetTableDataPath(cm_.GetTableName(page_id.table_id_));
-	if (offset > GetFileSize(data_file_path)) {
-		throw IOException("read page out of file size" + std::to_string(offset) + " " +
-		                  std::to_string(GetFileSize(data_file_path)));
+void DiskManager::FinishShortRead(PageId page_id, char *page_data, size_t read) {
+	// todo investigate this
+	LOG_ERROR("IO read less than a page, read {} rather than {}", read, PAGE_SIZE);
+	memset(page_data + read, 0, PAGE_SIZE - read);
+	WritePage(page_id, page_data);
+}
+
+void DiskManager::WritePage(PageId page_id, const char *page_data) {
+	auto &file = GetTableDataFile(page_id.table_id_);
+	auto offset = static_cast<int64_t>(page_id.page_number_) * PAGE_SIZE;
+	if (backend_ == DiskManagerBackend::FSTREAM) {
+		std::lock_guard<std::mutex> lock(file.stream_latch_);
+		file.stream_.seekp(offset);
+		file.stream_.write(page_data, PAGE_SIZE);
+		if (file.stream_.bad()) {
+			throw IOException("failed to write to table data file");
+		}
+		// flush to sync data
+		file.stream_.flush();
+	} else if (file.direct_ && !IsAligned(page_data)) {
+		char *buffer = GetBounceBuffer();
+		std::memcpy(buffer, page_data, PAGE_SIZE);
+		PwriteFully(file.fd_, buffer, PAGE_SIZE, offset);
+	} else {
+		PwriteFully(file.fd_, page_data, PAGE_SIZE, offset);
 	}
-	auto &data_fs = table_data_files_.at(page_id.table_id_);
-	data_fs.seekp(static_cast<int64_t>(offset));
-	data_fs.read(page_data, PAGE_SIZE);
-	if (data_fs.bad()) {
-		throw IOException("failed to read from table data file");
+	GrowFileSize(file, offset + PAGE_SIZE);
+}
+
+void DiskManager::ReadPage(PageId page_id, char *page_data) {
+	auto &file = GetTableDataFile(page_id.table_id_);
+	auto offset = static_cast<int64_t>(page_id.page_number_) * PAGE_SIZE;
+	CheckReadable(file, offset);
+	size_t read = 0;
+	if (backend_ == DiskManagerBackend::FSTREAM) {
+		std::lock_guard<std::mutex> lock(file.stream_latch_);
+		file.stream_.seekg(offset);
+		file.stream_.read(page_data, PAGE_SIZE);
+		if (file.stream_.bad()) {
+			throw IOException("failed to read from table data file");
+		}
+		read = file.stream_.gcount();
+		file.stream_.clear();
+	} else if (file.direct_ && !IsAligned(page_data)) {
+		char *buffer = GetBounceBuffer();
+		read = PreadFully(file.fd_, buffer, PAGE_SIZE, offset);
+		std::memcpy(page_data, buffer, read);
+	} else {
+		read = PreadFully(file.fd_, page_data, PAGE_SIZE, offset);
 	}
 	// if file ends before reading PAGE_SIZE
-	uint32_t gcount = data_fs.gcount();
-	if (gcount < PAGE_SIZE) {
-		// todo investigate this
-		LOG_ERROR("IO read less than a page, read {} rather than {}", gcount, PAGE_SIZE);
-		data_fs.clear();
-		memset(page_data + gcount, 0, PAGE_SIZE - gcount);
-		data_fs.seekp(static_cast<int64_t>(offset));
-		data_fs.write(page_data, PAGE_SIZE);
+	if (read < PAGE_SIZE) {
+		FinishShortRead(page_id, page_data, read);
 	}
 }
 
+std::unique_ptr<IoUring> DiskManager::AcquireRing() {
+	if (backend_ != DiskManagerBackend::IO_URING) {
+		return nullptr;
+	}
+	std::lock_guard<std::mutex> lock(uring_latch_);
+	if (uring_unavailable_) {
+		return nullptr;
+	}
+	if (!idle_rings_.empty()) {
+		auto ring = std::move(idle_rings_.back());
+		idle_rings_.pop_back();
+		return ring;
+	}
+	try {
+		return std::make_unique<IoUring>(IO_URING_QUEUE_DEPTH);
+	} catch (const IOException &e) {
+		LOG_WARN("falling back to synchronous io: {}", e.what());
+		// rings already handed out are still used until their batches finish
+		uring_unavailable_ = true;
+		idle_rings_.clear();
+		return nullptr;
+	}
+}
+
+void DiskManager::ReleaseRing(std::unique_ptr<IoUring> ring) {
+	std::lock_guard<std::mutex> lock(uring_latch_);
+	if (!uring_unavailable_) {
+		idle_rings_.push_back(std::move(ring));
+	}
+}
+
+bool DiskManager::IsIoUringActive() {
+	auto ring = AcquireRing();
+	if (ring == nullptr) {
+		return false;
+	}
+	ReleaseRing(std::move(ring));
+	return true;
+}
+
+void DiskManager::SubmitBatch(std::vector<DiskRequest> &requests) {
+	auto ring = AcquireRing();
+	if (ring == nullptr) {
+		SubmitSynchronously(requests, 0);
+		return;
+	}
+
+	size_t next = 0;
+	size_t in_flight = 0;
+	// the completion queue only has room for so many, the rest waits for requests to finish
+	const size_t max_in_flight = ring->GetEntries();
+	std::vector<bool> pending(requests.size(), false);
+	while (next < requests.size() || in_flight > 0) {
+		// queue as many requests as the ring takes
+		while (next < requests.size() && in_flight < max_in_flight) {
+			auto &request = requests[next];
+			auto offset = static_cast<int64_t>(request.page_id_.page_number_) * PAGE_SIZE;
+			int fd;
+			bool bounce;
+			try {
+				auto &file = GetTableDataFile(request.page_id_.table_id_);
+				if (!request.is_write_) {
+					CheckReadable(file, offset);
+				}
+				fd = file.fd_;
+				// only aligned buffers can be handed to the kernel for direct io, the others bounce synchronously
+				bounce = file.direct_ && !IsAligned(request.data_);
+				if (bounce) {
+					request.is_write_ ? WritePage(request.page_id_, request.data_)
+					                  : ReadPage(request.page_id_, request.data_);
+				}
+			} catch (const Exception &e) {
+				next++;
+				request.callback_(false);
+				continue;
+			}
+			if (bounce) {
+				next++;
+				request.callback_(true);
+				continue;
+			}
+			if (!ring->PrepareReadWrite(request.is_write_, fd, request.data_, PAGE_SIZE, offset, next)) {
+				break;
+			}
+			pending[next] = true;
+			next++;
+			in_flight++;
+		}
+		if (in_flight == 0) {
+			continue;
+		}
+		uint64_t index;
+		int32_t res;
+		try {
+			ring->Submit(1);
+		} catch (const IOException &e) {
+			// every callback has to run, or the frames waiting on it stay pinned with their io in progress. what already
+			// finished completes, the rest fails and io_uring is given up for synchronous io
+			LOG_WARN("falling back to synchronous io: {}", e.what());
+			while (ring->PopCompletion(index, res)) {
+				pending[index] = false;
+				CompleteRequest(requests[index], res);
+			}
+			for (size_t i = 0; i < requests.size(); i++) {
+				if (pending[i]) {
+					requests[i].callback_(false);
+				}
+			}
+			{
+				std::lock_guard<std::mutex> lock(uring_latch_);
+				uring_unavailable_ = true;
+				idle_rings_.clear();
+			}
+			ring.reset();
+			SubmitSynchronously(requests, next);
+			return;
+		}
+		while (ring->PopCompletion(index, res)) {
+			in_flight--;
+			pending[index] = false;
+			CompleteRequest(requests[index], res);
+		}
+	}
+	ReleaseRing(std::move(ring));
+}
+
+void DiskManager::SubmitSynchronously(std::vector<DiskRequest> &requests, size_t first) {
+	for (size_t i = first; i < requests.size(); i++) {
+		auto &request = requests[i];
+		bool ok = true;
+		try {
+			request.is_write_ ? WritePage(request.page_id_, request.data_) : ReadPage(request.page_id_, request.data_);
+		} catch (const Exception &e) {
+			ok = false;
+		}
+		request.callback_(ok);
+	}
+}
+
+void DiskManager::CompleteRequest(DiskRequest &request, int32_t res) {
+	if (res < 0) {
+		LOG_WARN("{} of page {} failed: {}", request.is_write_ ? "write" : "read", request.page_id_.ToString(),
+		         strerror(-res));
+		request.callback_(false);
+		return;
+	}
+	bool ok = true;
+	try {
+		if (static_cast<size_t>(res) == PAGE_SIZE) {
+			if (request.is_write_) {
+				auto &file = GetTableDataFile(request.page_id_.table_id_);
+				GrowFileSize(file, static_cast<int64_t>(request.page_id_.page_number_) * PAGE_SIZE + PAGE_SIZE);
+			}
+		} else {
+			// the kernel transferred less than asked for. the rest would start at an offset direct io cannot take, so
+			// the whole page is done again synchronously, which also reads the end of the file as zeros
+			request.is_write_ ? WritePage(request.page_id_, request.data_) : ReadPage(request.page_id_, request.data_);
+		}
+	} catch (const Exception &e) {
+		ok = false;
+	}
+	request.callback_(ok);
+}
+
+page_id_t DiskManager::GetPageCount(table_oid_t table_id) {
+	return static_cast<page_id_t>(GetTableDataFile(table_id).size_ / PAGE_SIZE);
+}
+
 void DiskManager::ShutDown() {
-	for (auto &[table_id, data_fs] : table_data_files_) {
-		data_fs.close();
+	std::unique_lock<std::shared_mutex> lock(latch_);
+	for (auto &[table_id, file] : table_data_files_) {
+		if (file->fd_ >= 0) {
+			close(file->fd_);
+		}
+		file->stream_.close();
 	}
+	table_data_files_.clear();
 	for (auto &[table_id, meta_fs] : table_meta_files_) {
 		meta_fs.close();
 	}
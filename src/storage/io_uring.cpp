@@ -0,0 +1,165 @@
+#include "storage/io_uring.hpp"
+
+#include "common/exception.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace db {
+namespace {
+int IoUringSetup(unsigned entries, io_uring_params *params) {
+	return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int IoUringRegister(int ring_fd, unsigned opcode, void *arg, unsigned nr_args) {
+	return static_cast<int>(syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args));
+}
+
+int IoUringEnter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+	return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+// the ring indices are shared with the kernel, which reads and writes them concurrently
+unsigned LoadAcquire(unsigned *p) {
+	return std::atomic_ref<unsigned>(*p).load(std::memory_order_acquire);
+}
+
+void StoreRelease(unsigned *p, unsigned v) {
+	std::atomic_ref<unsigned>(*p).store(v, std::memory_order_release);
+}
+
+// kernels from before IORING_OP_READ and IORING_OP_WRITE accept the ring but fail every request on it
+bool SupportsReadWrite(int ring_fd) {
+	constexpr unsigned op_count = IORING_OP_WRITE + 1;
+	alignas(io_uring_probe) char buffer[sizeof(io_uring_probe) + op_count * sizeof(io_uring_probe_op)] {};
+	auto *probe = reinterpret_cast<io_uring_probe *>(buffer);
+	if (IoUringRegister(ring_fd, IORING_REGISTER_PROBE, probe, op_count) < 0) {
+		return false;
+	}
+	auto supported = [probe](unsigned op) {
+		return op <= probe->last_op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED) != 0;
+	};
+	return supported(IORING_OP_READ) && supported(IORING_OP_WRITE);
+}
+
+void *MapRing(int ring_fd, size_t size, off_t offset) {
+	void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, offset);
+	if (ptr == MAP_FAILED) {
+		throw IOException("failed to map io_uring: " + std::string(strerror(errno)));
+	}
+	return ptr;
+}
+} // namespace
+
+IoUring::IoUring(unsigned entries) {
+	io_uring_params params {};
+	ring_fd_ = IoUringSetup(entries, &params);
+	if (ring_fd_ < 0) {
+		throw IOException("io_uring is unavailable: " + std::string(strerror(errno)));
+	}
+	entries_ = params.sq_entries;
+	try {
+		if (!SupportsReadWrite(ring_fd_)) {
+			throw IOException("io_uring does not support IORING_OP_READ and IORING_OP_WRITE");
+		}
+		sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+		cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+		if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0) {
+			sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+		}
+		sq_ring_ = MapRing(ring_fd_, sq_ring_size_, IORING_OFF_SQ_RING);
+		cq_ring_ = (params.features & IORING_FEAT_SINGLE_MMAP) != 0
+		               ? sq_ring_
+		               : MapRing(ring_fd_, cq_ring_size_, IORING_OFF_CQ_RING);
+		sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+		sqes_ = static_cast<io_uring_sqe *>(MapRing(ring_fd_, sqes_size_, IORING_OFF_SQES));
+	} catch (...) {
+		Release();
+		throw;
+	}
+
+	auto *sq = static_cast<char *>(sq_ring_);
+	sq_head_ = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+	sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+	sq_mask_ = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+	sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+	auto *cq = static_cast<char *>(cq_ring_);
+	cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+	cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+	cq_mask_ = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+	cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+}
+
+IoUring::~IoUring() {
+	Release();
+}
+
+void IoUring::Release() {
+	if (sqes_ != nullptr) {
+		munmap(sqes_, sqes_size_);
+	}
+	if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+		munmap(cq_ring_, cq_ring_size_);
+	}
+	if (sq_ring_ != nullptr) {
+		munmap(sq_ring_, sq_ring_size_);
+	}
+	if (ring_fd_ >= 0) {
+		close(ring_fd_);
+	}
+}
+
+bool IoUring::PrepareReadWrite(bool is_write, int fd, void *buf, unsigned len, uint64_t offset, uint64_t user_data) {
+	unsigned tail = *sq_tail_;
+	if (tail - LoadAcquire(sq_head_) >= entries_) {
+		return false;
+	}
+	unsigned index = tail & *sq_mask_;
+	io_uring_sqe &sqe = sqes_[index];
+	std::memset(&sqe, 0, sizeof(sqe));
+	sqe.opcode = is_write ? IORING_OP_WRITE : IORING_OP_READ;
+	sqe.fd = fd;
+	sqe.addr = reinterpret_cast<uint64_t>(buf);
+	sqe.len = len;
+	sqe.off = offset;
+	sqe.user_data = user_data;
+	sq_array_[index] = index;
+	StoreRelease(sq_tail_, tail + 1);
+	to_submit_++;
+	return true;
+}
+
+void IoUring::Submit(unsigned min_complete) {
+	while (true) {
+		int ret = IoUringEnter(ring_fd_, to_submit_, min_complete, min_complete > 0 ? IORING_ENTER_GETEVENTS : 0);
+		if (ret < 0 && errno == EINTR) {
+			continue;
+		}
+		if (ret < 0) {
+			throw IOException("io_uring_enter failed: " + std::string(strerror(errno)));
+		}
+		to_submit_ -= static_cast<unsigned>(ret);
+		if (to_submit_ == 0) {
+			return;
+		}
+	}
+}
+
+bool IoUring::PopCompletion(uint64_t &user_data, int32_t &res) {
+	unsigned head = *cq_head_;
+	if (head == LoadAcquire(cq_tail_)) {
+		return false;
+	}
+	const io_uring_cqe &cqe = cqes_[head & *cq_mask_];
+	user_data = cqe.user_data;
+	res = cqe.res;
+	StoreRelease(cq_head_, head + 1);
+	return true;
+}
+} // namespace db
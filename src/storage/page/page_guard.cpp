@@ -90,6 +90,18 @@ WritePageGuard::~WritePageGuard() {
 	Drop();
 }
 
+auto ReadPageGuard::UpgradeWrite() -> WritePageGuard {
+	// upgrading in place keeps other writers out in between, only when another reader is upgrading already the latch
+	// has to be released and taken again
+	if (guard_.page_->UpgradeLatch()) {
+		auto ret = WritePageGuard {};
+		ret.guard_ = std::move(guard_);
+		return ret;
+	}
+	guard_.page_->RUnlatch();
+	return guard_.UpgradeWrite();
+}
+
 auto BasicPageGuard::UpgradeRead() -> ReadPageGuard {
 	page_->RLatch();
 
@@ -0,0 +1,181 @@
+#include "storage/page/pax_page.hpp"
+
+#include "common/config.hpp"
+#include "common/logger.hpp"
+#include "storage/table/overflow_chain.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+
+namespace db {
+
+namespace {
+constexpr uint32_t MINIPAGE_ALIGNMENT = 8;
+
+constexpr uint32_t AlignMinipage(uint32_t offset) {
+	return (offset + MINIPAGE_ALIGNMENT - 1) / MINIPAGE_ALIGNMENT * MINIPAGE_ALIGNMENT;
+}
+
+// every minipage and the metas may need padding to be aligned. a page keeps room for a tuple as large as any that is
+// not cut down by moving values to overflow pages, so that an empty page takes every tuple
+uint32_t GetReservedSize(const Schema &schema) {
+	return PAX_PAGE_HEADER_SIZE + MINIPAGE_ALIGNMENT * (schema.GetColumnCount() + 1) +
+	       (schema.GetUninlinedColumnCount() > 0 ? TUPLE_OVERFLOW_THRESHOLD : 0);
+}
+
+// the bytes each tuple takes from a page
+uint32_t GetTupleSpace(const Schema &schema) {
+	return TUPLE_META_SIZE + schema.GetTupleInlinePartStorageSize() +
+	       schema.GetUninlinedColumnCount() * PAX_VARCHAR_SPACE;
+}
+} // namespace
+
+bool PaxLayout::Fits(const Schema &schema) {
+	return GetReservedSize(schema) + GetTupleSpace(schema) <= PAGE_SIZE;
+}
+
+PaxLayout::PaxLayout(const Schema &schema) : inline_size_(schema.GetTupleInlinePartStorageSize()) {
+	const auto column_count = schema.GetColumnCount();
+	const uint32_t reserved = GetReservedSize(schema);
+	const uint32_t tuple_space = GetTupleSpace(schema);
+	assert(Fits(schema) && "tuple is too large for a PAX page");
+	capacity_ = std::min<uint32_t>((PAGE_SIZE - reserved) / tuple_space, std::numeric_limits<uint16_t>::max());
+
+	uint32_t offset = AlignMinipage(PAX_PAGE_HEADER_SIZE + TUPLE_META_SIZE * capacity_);
+	minipages_.reserve(column_count);
+	for (const auto &col : schema.GetColumns()) {
+		const uint32_t width = col.IsInlined() ? col.GetStorageSize() : sizeof(uint32_t);
+		minipages_.push_back({offset, width, col.GetStorageOffset(), col.IsInlined()});
+		offset = AlignMinipage(offset + width * capacity_);
+	}
+	var_data_start_ = offset;
+	assert(var_data_start_ <= PAGE_SIZE && "minipages out of range");
+}
+
+void PaxPage::Init() {
+	next_page_id_ = INVALID_PAGE_ID;
+	num_tuples_ = 0;
+	num_deleted_tuples_ = 0;
+	var_data_offset_ = PAGE_SIZE;
+}
+
+size_t PaxPage::GetFreeSpace(const PaxLayout &layout) const {
+	if (num_tuples_ == layout.capacity_) {
+		return 0;
+	}
+	// the inline part of a tuple goes to the minipages, only the rest needs the free bytes
+	return layout.inline_size_ + var_data_offset_ - layout.var_data_start_;
+}
+
+std::optional<uint16_t> PaxPage::InsertTuple(const PaxLayout &layout, const TupleMeta &meta, const Tuple &tuple) {
+	assert(tuple.GetStorageSize() >= layout.inline_size_ && "tuple does not match the layout");
+	if (tuple.GetStorageSize() > GetFreeSpace(layout)) {
+		return std::nullopt;
+	}
+	const auto slot = num_tuples_;
+	const auto *data = tuple.GetData();
+	for (const auto &minipage : layout.minipages_) {
+		auto *value_ptr = page_start_ + minipage.offset_ + slot * minipage.width_;
+		if (minipage.is_inlined_) {
+			std::memcpy(value_ptr, data + minipage.tuple_offset_, minipage.width_);
+			continue;
+		}
+		const auto *var_value = data + *reinterpret_cast<const uint32_t *>(data + minipage.tuple_offset_);
+		const auto size = GetVarValueSize(var_value);
+		var_data_offset_ -= size;
+		std::memcpy(page_start_ + var_data_offset_, var_value, size);
+		*reinterpret_cast<uint32_t *>(value_ptr) = var_data_offset_;
+	}
+	assert(var_data_offset_ >= layout.var_data_start_ && "varchar data out of range");
+	tuple_metas_[slot] = meta;
+	num_tuples_++;
+	LOG_TRACE("slot={}, var_data_offset={}", slot, var_data_offset_);
+	return slot;
+}
+
+TupleMeta PaxPage::GetTupleMeta(const RID &rid) const {
+	auto tuple_id = rid.GetSlotNum();
+	if (tuple_id >= num_tuples_) {
+		throw Exception("Tuple ID out of range");
+	}
+	return tuple_metas_[tuple_id];
+}
+
+void PaxPage::UpdateTupleMeta(const TupleMeta &meta, const RID &rid) {
+	auto tuple_id = rid.GetSlotNum();
+	if (tuple_id >= num_tuples_) {
+		throw Exception("Tuple ID out of range");
+	}
+	auto &old_meta = tuple_metas_[tuple_id];
+	if (!old_meta.is_deleted_ && meta.is_deleted_) {
+		num_deleted_tuples_++;
+	} else if (old_meta.is_deleted_ && !meta.is_deleted_) {
+		num_deleted_tuples_--;
+	}
+	old_meta = meta;
+}
+
+std::optional<std::pair<TupleMeta, Tuple>> PaxPage::GetTuple(const PaxLayout &layout, const RID &rid) const {
+	auto tuple_id = rid.GetSlotNum();
+	if (tuple_id >= num_tuples_) {
+		throw Exception(fmt::format("Tuple ID out of range, {} >= {}", tuple_id, num_tuples_));
+	}
+	Tuple tuple;
+	ReadTuple(layout, tuple_id, tuple.data_);
+	tuple.rid_ = rid;
+	return std::make_pair(tuple_metas_[tuple_id], std::move(tuple));
+}
+
+void PaxPage::GetTupleViews(const PaxLayout &layout, PageId page_id, uint32_t end,
+                            std::vector<std::pair<TupleMeta, TupleView>> &views) const {
+	assert(end <= num_tuples_ && "tuple id out of range");
+	for (uint32_t tuple_id = 0; tuple_id < end; tuple_id++) {
+		views.emplace_back(tuple_metas_[tuple_id],
+		                   TupleView(const_data_ptr_cast(page_start_), layout, RID {page_id, tuple_id}));
+	}
+}
+
+const_data_ptr_t PaxPage::GetValuePtr(const PaxLayout &layout, column_t column_idx, uint32_t slot) const {
+	const auto &minipage = layout.minipages_[column_idx];
+	const auto *value_ptr = page_start_ + minipage.offset_ + slot * minipage.width_;
+	if (minipage.is_inlined_) {
+		return const_data_ptr_cast(value_ptr);
+	}
+	return const_data_ptr_cast(page_start_ + *reinterpret_cast<const uint32_t *>(value_ptr));
+}
+
+uint32_t PaxPage::GetTupleSize(const PaxLayout &layout, uint32_t slot) const {
+	uint32_t size = layout.inline_size_;
+	for (column_t column_idx = 0; column_idx < layout.minipages_.size(); column_idx++) {
+		if (!layout.minipages_[column_idx].is_inlined_) {
+			size += GetVarValueSize(GetValuePtr(layout, column_idx, slot));
+		}
+	}
+	return size;
+}
+
+void PaxPage::ReadTuple(const PaxLayout &layout, uint32_t slot, std::vector<data_t> &data) const {
+	data.resize(GetTupleSize(layout, slot));
+	uint32_t var_offset = layout.inline_size_;
+	for (column_t column_idx = 0; column_idx < layout.minipages_.size(); column_idx++) {
+		const auto &minipage = layout.minipages_[column_idx];
+		const auto *value_ptr = GetValuePtr(layout, column_idx, slot);
+		if (minipage.is_inlined_) {
+			std::memcpy(data.data() + minipage.tuple_offset_, value_ptr, minipage.width_);
+			continue;
+		}
+		const auto size = GetVarValueSize(value_ptr);
+		std::memcpy(data.data() + var_offset, value_ptr, size);
+		std::memcpy(data.data() + minipage.tuple_offset_, &var_offset, sizeof(uint32_t));
+		var_offset += size;
+	}
+}
+
+uint32_t PaxPage::GetVarValueSize(const_data_ptr_t value) {
+	const auto var_len = *reinterpret_cast<const uint32_t *>(value);
+	return (var_len & VARCHAR_OVERFLOW_FLAG) != 0 ? VARCHAR_OVERFLOW_REF_SIZE : sizeof(uint32_t) + var_len;
+}
+
+} // namespace db
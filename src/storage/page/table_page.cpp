@@ -3,6 +3,7 @@
 #include "common/logger.hpp"
 
 #include <cassert>
+#include <cstring>
 
 namespace db {
 void TablePage::Init() {
@@ -35,6 +36,12 @@ std::optional<uint16_t> TablePage::GetNextTupleOffset(const Tuple &tuple) const
 	return tuple_offset;
 }
 
+size_t TablePage::GetFreeSpace() const {
+	size_t slot_end_offset = num_tuples_ > 0 ? std::get<0>(tuple_info_[num_tuples_ - 1]) : PAGE_SIZE;
+	auto offset_size = TABLE_PAGE_HEADER_SIZE + TUPLE_INFO_SIZE * (num_tuples_ + 1);
+	return slot_end_offset > offset_size ? slot_end_offset - offset_size : 0;
+}
+
 auto TablePage::InsertTuple(const TupleMeta &meta, const Tuple &tuple) -> std::optional<uint16_t> {
 	auto tuple_offset = GetNextTupleOffset(tuple);
 	if (tuple_offset == std::nullopt) {
@@ -55,27 +62,60 @@ void TablePage::UpdateTupleMeta(const TupleMeta &meta, const RID &rid) {
 		throw Exception("Tuple ID out of range");
 	}
 	auto &[offset, size, old_meta] = tuple_info_[tuple_id];
+	if (old_meta.is_deleted_ && !meta.is_deleted_ && size == 0) {
+		throw Exception("Tuple has been reclaimed");
+	}
 	if (!old_meta.is_deleted_ && meta.is_deleted_) {
 		num_deleted_tuples_++;
+	} else if (old_meta.is_deleted_ && !meta.is_deleted_) {
+		num_deleted_tuples_--;
 	}
 	tuple_info_[tuple_id] = std::make_tuple(offset, size, meta);
 }
 
+size_t TablePage::Compact() {
+	// tuples only ever move towards the end of the page, going in slot order a tuple never overwrites one not yet moved
+	size_t data_end = PAGE_SIZE;
+	size_t reclaimed = 0;
+	for (uint32_t tuple_id = 0; tuple_id < num_tuples_; tuple_id++) {
+		auto &[offset, size, meta] = tuple_info_[tuple_id];
+		if (meta.is_deleted_) {
+			reclaimed += size;
+			size = 0;
+		} else {
+			assert(offset + size <= data_end && "tuple data out of slot order");
+			std::memmove(page_start_ + data_end - size, page_start_ + offset, size);
+		}
+		data_end -= size;
+		offset = data_end;
+	}
+	num_deleted_tuples_ = 0;
+	LOG_TRACE("Reclaimed {} bytes", reclaimed);
+	return reclaimed;
+}
+
 auto TablePage::GetTuple(const RID &rid) const -> std::optional<std::pair<TupleMeta, Tuple>> {
+	auto [meta, view] = GetTupleView(rid);
+	return std::make_pair(meta, view.ToTuple());
+}
+
+auto TablePage::GetTupleView(const RID &rid) const -> std::pair<TupleMeta, TupleView> {
 	auto tuple_id = rid.GetSlotNum();
 	if (tuple_id >= num_tuples_) {
-		// return std::nullopt;
 		throw Exception(fmt::format("Tuple ID out of range, {} >= {}", tuple_id, num_tuples_));
 	}
 	const auto &[offset, size, meta] = tuple_info_[tuple_id];
-	Tuple tuple;
-	tuple.data_.resize(size);
 	assert(offset + size <= PAGE_SIZE && "tuple out of range");
-	tuple.DeserializeFrom(page_start_ + offset, size);
-	// memmove(tuple.data_.data(), page_start_ + offset, size);
-	tuple.rid_ = rid;
-	// printData(page_start_, PAGE_SIZE);
-	return std::make_pair(meta, std::move(tuple));
+	return {meta, TupleView(const_data_ptr_cast(page_start_ + offset), size, rid)};
+}
+
+void TablePage::GetTupleViews(PageId page_id, uint32_t end,
+                              std::vector<std::pair<TupleMeta, TupleView>> &views) const {
+	assert(end <= num_tuples_ && "tuple id out of range");
+	for (uint32_t tuple_id = 0; tuple_id < end; tuple_id++) {
+		const auto &[offset, size, meta] = tuple_info_[tuple_id];
+		views.emplace_back(meta, TupleView(const_data_ptr_cast(page_start_ + offset), size, RID {page_id, tuple_id}));
+	}
 }
 
 auto TablePage::GetTupleMeta(const RID &rid) const -> TupleMeta {
@@ -0,0 +1,103 @@
+#include "storage/table/free_space_map.hpp"
+
+#include "common/config.hpp"
+#include "storage/page/free_space_map_page.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <mutex>
+
+namespace db {
+namespace {
+constexpr uint32_t MAX_CATEGORY = std::numeric_limits<uint8_t>::max();
+} // namespace
+
+void FreeSpaceMap::Create() {
+	assert(table_meta_.free_space_map_page_id_ == INVALID_PAGE_ID);
+	PageId page_id {table_meta_.table_oid_};
+	auto guard = bpm_.NewPageGuarded(page_allocator_, page_id);
+	guard.AsMut<FreeSpaceMapPage>().Init();
+	table_meta_.free_space_map_page_id_ = page_id.page_number_;
+}
+
+void FreeSpaceMap::Update(page_id_t page_number, size_t free_bytes) {
+	auto category = static_cast<uint8_t>(std::min<size_t>(free_bytes / FSM_CATEGORY_SIZE, MAX_CATEGORY));
+	auto guard = FetchEntryPage(page_number);
+	guard.AsMut<FreeSpaceMapPage>().SetCategory(page_number % FreeSpaceMapPage::ENTRY_COUNT, category);
+}
+
+std::optional<page_id_t> FreeSpaceMap::Search(size_t free_bytes, page_id_t start) {
+	// a page recorded with a category has at least that many multiples of FSM_CATEGORY_SIZE free
+	auto category = (free_bytes + FSM_CATEGORY_SIZE - 1) / FSM_CATEGORY_SIZE;
+	if (category > MAX_CATEGORY) {
+		return std::nullopt;
+	}
+	auto found = SearchRange(category, start, std::numeric_limits<page_id_t>::max());
+	if (!found.has_value() && start > 0) {
+		found = SearchRange(category, 0, start);
+	}
+	return found;
+}
+
+size_t FreeSpaceMap::GetFreeSpace(page_id_t page_number) {
+	page_id_t map_page_number = table_meta_.free_space_map_page_id_;
+	for (auto index = page_number / FreeSpaceMapPage::ENTRY_COUNT; map_page_number != INVALID_PAGE_ID; index--) {
+		auto guard = bpm_.FetchPageRead({table_meta_.table_oid_, map_page_number});
+		const auto &page = guard.As<FreeSpaceMapPage>();
+		if (index == 0) {
+			return page.GetCategory(page_number % FreeSpaceMapPage::ENTRY_COUNT) * FSM_CATEGORY_SIZE;
+		}
+		map_page_number = page.GetNextPageId();
+	}
+	// the map does not cover the page yet
+	return 0;
+}
+
+WritePageGuard FreeSpaceMap::FetchEntryPage(page_id_t page_number) {
+	page_id_t map_page_number = table_meta_.free_space_map_page_id_;
+	for (auto index = page_number / FreeSpaceMapPage::ENTRY_COUNT; index > 0; index--) {
+		auto guard = bpm_.FetchPageRead({table_meta_.table_oid_, map_page_number});
+		auto next_page_number = guard.As<FreeSpaceMapPage>().GetNextPageId();
+		guard.Drop();
+		map_page_number = next_page_number != INVALID_PAGE_ID ? next_page_number : Grow(map_page_number);
+	}
+	return bpm_.FetchPageWrite({table_meta_.table_oid_, map_page_number});
+}
+
+page_id_t FreeSpaceMap::Grow(page_id_t page_number) {
+	std::lock_guard<std::mutex> lock(table_meta_.heap_latch_);
+	auto guard = bpm_.FetchPageWrite({table_meta_.table_oid_, page_number});
+	// another thread may have grown the map in the meantime
+	if (guard.As<FreeSpaceMapPage>().GetNextPageId() == INVALID_PAGE_ID) {
+		PageId next_page_id {table_meta_.table_oid_};
+		auto next_guard = bpm_.NewPageGuarded(page_allocator_, next_page_id);
+		next_guard.AsMut<FreeSpaceMapPage>().Init();
+		guard.AsMut<FreeSpaceMapPage>().SetNextPageId(next_page_id.page_number_);
+	}
+	return guard.As<FreeSpaceMapPage>().GetNextPageId();
+}
+
+std::optional<page_id_t> FreeSpaceMap::SearchRange(uint8_t category, page_id_t begin, page_id_t end) {
+	page_id_t map_page_number = table_meta_.free_space_map_page_id_;
+	page_id_t base = 0;
+	while (map_page_number != INVALID_PAGE_ID && base < end) {
+		auto guard = bpm_.FetchPageRead({table_meta_.table_oid_, map_page_number});
+		const auto &page = guard.As<FreeSpaceMapPage>();
+		if (begin < base + static_cast<page_id_t>(FreeSpaceMapPage::ENTRY_COUNT)) {
+			auto slot = page.FindSlot(category, std::max(begin - base, 0));
+			if (slot.has_value()) {
+				// the first match is past the range, so nothing in the range matches
+				if (base + static_cast<page_id_t>(*slot) >= end) {
+					return std::nullopt;
+				}
+				return base + static_cast<page_id_t>(*slot);
+			}
+		}
+		map_page_number = page.GetNextPageId();
+		base += FreeSpaceMapPage::ENTRY_COUNT;
+	}
+	return std::nullopt;
+}
+
+} // namespace db
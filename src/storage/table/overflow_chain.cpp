@@ -0,0 +1,54 @@
+#include "storage/table/overflow_chain.hpp"
+
+#include "common/exception.hpp"
+#include "storage/page/overflow_page.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace db {
+
+page_id_t WriteOverflowChain(BufferPool &bpm, PageAllocator &page_allocator, table_oid_t table_oid,
+                             std::string_view value) {
+	assert(!value.empty() && "empty values are kept in their tuple");
+	// the chain is only reachable once the tuple referencing it is inserted, so the pages are written unlatched
+	page_id_t first_page_number = INVALID_PAGE_ID;
+	BasicPageGuard page_guard;
+	for (size_t written = 0; written < value.size();) {
+		PageId page_id {table_oid};
+		auto new_page_guard = bpm.NewPageGuarded(page_allocator, page_id);
+		assert(page_id.page_number_ != INVALID_PAGE_ID && "cannot allocate page");
+		auto &page = new_page_guard.AsMut<OverflowPage>();
+		page.Init();
+		auto size = std::min<size_t>(value.size() - written, OverflowPage::CAPACITY);
+		std::memcpy(page.GetData(), value.data() + written, size);
+		page.SetSize(size);
+		written += size;
+		if (first_page_number == INVALID_PAGE_ID) {
+			first_page_number = page_id.page_number_;
+		} else {
+			page_guard.AsMut<OverflowPage>().SetNextPageId(page_id.page_number_);
+		}
+		page_guard = std::move(new_page_guard);
+	}
+	return first_page_number;
+}
+
+std::string ReadOverflowChain(BufferPool &bpm, PageId first_page_id, uint32_t size) {
+	std::string value;
+	value.reserve(size);
+	auto page_number = first_page_id.page_number_;
+	while (value.size() < size) {
+		if (page_number == INVALID_PAGE_ID) {
+			throw Exception(fmt::format("Overflow chain of {} ends early", first_page_id.ToString()));
+		}
+		auto page_guard = bpm.FetchPageRead({first_page_id.table_id_, page_number});
+		const auto &page = page_guard.As<OverflowPage>();
+		value.append(page.GetData(), page.GetSize());
+		page_number = page.GetNextPageId();
+	}
+	assert(value.size() == size && "overflow chain longer than its value");
+	return value;
+}
+} // namespace db
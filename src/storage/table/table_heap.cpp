@@ -3,105 +3,364 @@
 
 #include "common/logger.hpp"
 #include "common/page_id.hpp"
+#include "common/value.hpp"
 #include "storage/buffer/buffer_pool.hpp"
+#include "storage/page/pax_page.hpp"
 #include "storage/page/table_page.hpp"
+#include "storage/table/overflow_chain.hpp"
 #include "storage/table/table_iterator.hpp"
 #include "storage/table/table_meta.hpp"
 
+#include <algorithm>
+#include <functional>
 #include <utility>
 namespace db {
 
-TableHeap::TableHeap(BufferPool &bpm, TableMeta &table_meta) : bpm_(bpm), table_meta_(table_meta) {
-	if (table_meta_.GetLastTableHeapDataPageId() == INVALID_PAGE_ID) {
+TableHeap::TableHeap(BufferPool &bpm, TableMeta &table_meta)
+    : bpm_(bpm), table_meta_(table_meta), fsm_(bpm, table_meta, *this), zone_map_(bpm, table_meta, *this) {
+	if (table_meta_.layout_ == PageLayout::Pax) {
+		pax_layout_.emplace(table_meta_.schema_);
+	}
+	std::unique_lock<std::mutex> lock(table_meta_.heap_latch_);
+	const bool is_new_heap = table_meta_.GetLastTableHeapDataPageId() == INVALID_PAGE_ID;
+	if (is_new_heap) {
 		PageId new_page_id {table_meta_.table_oid_};
 		auto guard = bpm.NewPageGuarded(*this, new_page_id);
 		assert(new_page_id.page_number_ != INVALID_PAGE_ID && new_page_id.page_number_ >= 0 &&
 		       "table heap create page failed");
 
-		auto &first_page = guard.AsMut<TablePage>();
-		first_page.Init();
+		InitPage(guard.GetDataMut());
+		table_meta_.first_table_heap_data_page_id_ = new_page_id.page_number_;
+		table_meta_.SetLastTableHeapDataPageId(new_page_id.page_number_);
+	}
+	if (table_meta_.zone_map_page_id_ == INVALID_PAGE_ID) {
+		// the pages of a heap written before the zone map stay untracked
+		zone_map_.Create();
+	}
+	if (is_new_heap) {
+		zone_map_.Track(table_meta_.first_table_heap_data_page_id_, zone_map_.MakeBounds());
 	}
 	assert(table_meta_.GetLastTableHeapDataPageId() >= 0);
+	if (table_meta_.free_space_map_page_id_ != INVALID_PAGE_ID) {
+		return;
+	}
+	// a new heap, or one written before the free-space map, of which only the last page is known to have room
+	fsm_.Create();
+	auto last_page_id = table_meta_.GetLastTableHeapDataPageId();
+	lock.unlock();
+	auto free_space = GetPageFreeSpace(bpm_.FetchPageRead({table_meta_.table_oid_, last_page_id}).GetData());
+	fsm_.Update(last_page_id, free_space);
 };
 
-std::optional<RID> TableHeap::InsertTuple(const TupleMeta &meta, const Tuple &tuple) {
-	std::unique_lock<std::mutex> guard(latch_);
-	PageId new_page_id {table_meta_.table_oid_, table_meta_.GetLastTableHeapDataPageId()};
-	auto page_guard = bpm_.FetchPageWrite(new_page_id);
-	while (true) {
-		auto &page = page_guard.AsMut<TablePage>();
-		if (page.GetNextTupleOffset(tuple) != std::nullopt) {
+std::optional<RID> TableHeap::InsertTuple(const TupleMeta &meta, const Tuple &inserted_tuple) {
+	const auto table_oid = table_meta_.table_oid_;
+	std::optional<Tuple> moved_tuple;
+	if (inserted_tuple.GetStorageSize() > TUPLE_OVERFLOW_THRESHOLD) {
+		moved_tuple = MoveOutLargeValues(inserted_tuple);
+	}
+	const auto &tuple = moved_tuple.has_value() ? *moved_tuple : inserted_tuple;
+	const auto size = tuple.GetStorageSize();
+	std::optional<page_id_t> page_number = table_meta_.insert_page_id_.load(std::memory_order_relaxed);
+	if (*page_number == INVALID_PAGE_ID) {
+		std::lock_guard<std::mutex> lock(table_meta_.heap_latch_);
+		page_number = table_meta_.GetLastTableHeapDataPageId();
+	}
+	uint32_t busy_pages = 0;
+	while (page_number.has_value() && busy_pages < TABLE_HEAP_MAX_BUSY_PAGES) {
+		auto page_guard = bpm_.TryFetchPageWrite({table_oid, *page_number});
+		if (!page_guard.has_value()) {
+			// another inserter works on the page, rather than queue up behind it look for another page with room
+			busy_pages++;
+			page_number = fsm_.Search(size, *page_number + 1);
+			continue;
+		}
+		auto slot_id = InsertIntoPage(page_guard->GetDataMut(), meta, tuple);
+		if (slot_id.has_value()) {
+			// the zone covers the tuple by the time readers can latch the page
+			zone_map_.Extend(*page_number, tuple);
+			page_guard->Drop();
+			table_meta_.insert_page_id_.store(*page_number, std::memory_order_relaxed);
+			table_meta_.IncreaseTupleCount();
+			const auto rid = RID({table_oid, *page_number}, *slot_id);
+			LOG_TRACE("Inserted tuple with rid {}", rid.ToString());
+			return rid;
+		}
+		// the map overestimated the page, correct it so that later inserts skip it as well
+		auto free_space = GetPageFreeSpace(page_guard->GetData());
+		page_guard->Drop();
+		fsm_.Update(*page_number, free_space);
+		page_number = fsm_.Search(size, *page_number + 1);
+	}
+	auto rid = InsertIntoNewPage(meta, tuple);
+	table_meta_.IncreaseTupleCount();
+	LOG_TRACE("Inserted tuple with rid {}", rid.ToString());
+	return rid;
+};
+
+Tuple TableHeap::MoveOutLargeValues(const Tuple &tuple) {
+	const auto &schema = table_meta_.schema_;
+	const TupleView view(tuple);
+	std::vector<std::pair<Value, uint32_t>> values;
+	for (auto column_idx : schema.GetUninlinedColumns()) {
+		if (!view.IsOverflowed(schema.GetColumn(column_idx))) {
+			values.emplace_back(view.GetValue(schema, column_idx), column_idx);
+		}
+	}
+	std::ranges::sort(values, std::greater {}, [](const auto &value) { return value.first.GetStorageSize(); });
+	std::vector<std::pair<uint32_t, page_id_t>> chains;
+	auto size = tuple.GetStorageSize();
+	for (const auto &[value, column_idx] : values) {
+		auto stored_size = sizeof(uint32_t) + value.GetStorageSize();
+		if (size <= TUPLE_OVERFLOW_THRESHOLD || stored_size <= VARCHAR_OVERFLOW_REF_SIZE) {
 			break;
 		}
-		// tuple page is empty and still cannot insert
-		assert(page.GetNumTuples() != 0 && "tuple is too large");
-		// allocate a new page for the tuple because the current page is full
-		// page_id_t next_page_id = INVALID_PAGE_ID;
-		PageId next_page_id {table_meta_.table_oid_};
-		auto npg = bpm_.NewPageGuarded(*this, next_page_id);
-		assert(next_page_id.page_number_ != INVALID_PAGE_ID && "cannot allocate page");
-		// construct the linked list
-		page.SetNextPageId(next_page_id.page_number_);
-		// initialize the next page
-		auto &next_page = npg.AsMut<TablePage>();
-		next_page.Init();
-		// drop the current page
-		page_guard.Drop();
-		// fetch the next page
-		auto next_page_guard = npg.UpgradeWrite();
-		page_guard = std::move(next_page_guard);
+		chains.emplace_back(column_idx,
+		                    WriteOverflowChain(bpm_, *this, table_meta_.table_oid_, value.GetAs<std::string>()));
+		size -= stored_size - VARCHAR_OVERFLOW_REF_SIZE;
 	}
-	auto last_page_id = table_meta_.GetLastTableHeapDataPageId();
+	LOG_TRACE("Moved {} values to overflow pages, tuple shrank from {} to {} bytes", chains.size(),
+	          tuple.GetStorageSize(), size);
+	return tuple.WithOverflowValues(schema, chains);
+}
 
-	auto &page = page_guard.AsMut<TablePage>();
-	auto slot_id = *page.InsertTuple(meta, tuple);
-	guard.unlock();
+RID TableHeap::InsertIntoNewPage(const TupleMeta &meta, const Tuple &tuple) {
+	// heap pages are numbered in the order they are linked, and scans only reach a page once it holds the tuple
+	std::unique_lock<std::mutex> lock(table_meta_.heap_latch_);
+	PageId new_page_id {table_meta_.table_oid_};
+	auto page_guard = bpm_.NewPageGuarded(*this, new_page_id).UpgradeWrite();
+	assert(new_page_id.page_number_ != INVALID_PAGE_ID && "cannot allocate page");
+	InitPage(page_guard.GetDataMut());
+	auto slot_id = InsertIntoPage(page_guard.GetDataMut(), meta, tuple);
+	assert(slot_id.has_value() && "tuple is too large");
+	auto free_space = GetPageFreeSpace(page_guard.GetData());
+	auto bounds = zone_map_.MakeBounds();
+	zone_map_.Extend(bounds, tuple);
+	zone_map_.Track(new_page_id.page_number_, bounds);
+	auto last_page_number = table_meta_.GetLastTableHeapDataPageId();
+	auto last_page_guard = bpm_.FetchPageWrite({table_meta_.table_oid_, last_page_number});
+	SetPageNextPageId(last_page_guard.GetDataMut(), new_page_id.page_number_);
+	zone_map_.SetNextPageId(last_page_number, new_page_id.page_number_);
+	table_meta_.SetLastTableHeapDataPageId(new_page_id.page_number_);
+	last_page_guard.Drop();
 	page_guard.Drop();
+	lock.unlock();
 
-	table_meta_.IncreaseTupleCount();
+	fsm_.Update(new_page_id.page_number_, free_space);
+	table_meta_.insert_page_id_.store(new_page_id.page_number_, std::memory_order_relaxed);
+	return {new_page_id, *slot_id};
+}
 
-	const auto rid = RID({table_meta_.table_oid_, last_page_id}, slot_id);
-	LOG_TRACE("Inserted tuple with rid {}", rid.ToString());
-	return rid;
-};
+std::vector<RID> TableHeap::BulkInsertTuples(const TupleMeta &meta, const std::vector<Tuple> &tuples) {
+	std::vector<RID> rids;
+	rids.reserve(tuples.size());
+	size_t total_size = 0;
+	for (const auto &tuple : tuples) {
+		total_size += tuple.GetStorageSize();
+	}
+	if (total_size < PAGE_SIZE - TABLE_PAGE_HEADER_SIZE) {
+		for (const auto &tuple : tuples) {
+			auto rid = InsertTuple(meta, tuple);
+			assert(rid.has_value() && "tuple is too large");
+			rids.push_back(*rid);
+		}
+		return rids;
+	}
+
+	// the new pages are only reachable from each other until they are linked into the heap, so nobody else latches
+	// them and each one is only looked up once
+	const auto table_oid = table_meta_.table_oid_;
+	// the page numbers of the new pages and the free bytes they are left with
+	std::vector<std::pair<page_id_t, size_t>> pages;
+	// the zone of each new page
+	std::vector<ZoneBounds> page_bounds;
+	WritePageGuard page_guard;
+	for (const auto &inserted_tuple : tuples) {
+		std::optional<Tuple> moved_tuple;
+		if (inserted_tuple.GetStorageSize() > TUPLE_OVERFLOW_THRESHOLD) {
+			moved_tuple = MoveOutLargeValues(inserted_tuple);
+		}
+		const auto &tuple = moved_tuple.has_value() ? *moved_tuple : inserted_tuple;
+		std::optional<uint16_t> slot_id;
+		if (!pages.empty()) {
+			slot_id = InsertIntoPage(page_guard.GetDataMut(), meta, tuple);
+		}
+		if (!slot_id.has_value()) {
+			PageId new_page_id {table_oid};
+			auto new_page_guard = bpm_.NewPageGuarded(*this, new_page_id).UpgradeWrite();
+			assert(new_page_id.page_number_ != INVALID_PAGE_ID && "cannot allocate page");
+			InitPage(new_page_guard.GetDataMut());
+			if (!pages.empty()) {
+				SetPageNextPageId(page_guard.GetDataMut(), new_page_id.page_number_);
+				pages.back().second = GetPageFreeSpace(page_guard.GetData());
+			}
+			page_guard = std::move(new_page_guard);
+			pages.emplace_back(new_page_id.page_number_, 0);
+			page_bounds.push_back(zone_map_.MakeBounds());
+			slot_id = InsertIntoPage(page_guard.GetDataMut(), meta, tuple);
+			assert(slot_id.has_value() && "tuple is too large");
+		}
+		zone_map_.Extend(page_bounds.back(), tuple);
+		rids.emplace_back(PageId {table_oid, pages.back().first}, *slot_id);
+	}
+	pages.back().second = GetPageFreeSpace(page_guard.GetData());
+	page_guard.Drop();
+	for (size_t i = 0; i < pages.size(); i++) {
+		zone_map_.Track(pages[i].first, page_bounds[i]);
+		if (i + 1 < pages.size()) {
+			zone_map_.SetNextPageId(pages[i].first, pages[i + 1].first);
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(table_meta_.heap_latch_);
+		auto last_page_number = table_meta_.GetLastTableHeapDataPageId();
+		auto last_page_guard = bpm_.FetchPageWrite({table_oid, last_page_number});
+		SetPageNextPageId(last_page_guard.GetDataMut(), pages.front().first);
+		zone_map_.SetNextPageId(last_page_number, pages.front().first);
+		table_meta_.SetLastTableHeapDataPageId(pages.back().first);
+	}
+	for (const auto &[page_number, free_space] : pages) {
+		fsm_.Update(page_number, free_space);
+	}
+	table_meta_.insert_page_id_.store(pages.back().first, std::memory_order_relaxed);
+	table_meta_.IncreaseTupleCount(tuples.size());
+	LOG_TRACE("Bulk inserted {} tuples on {} new pages", tuples.size(), pages.size());
+	return rids;
+}
 
 void TableHeap::UpdateTupleMeta(const TupleMeta &meta, RID rid) {
 	auto page_guard = bpm_.FetchPageWrite(rid.GetPageId());
-	auto &page = page_guard.AsMut<TablePage>();
-	page.UpdateTupleMeta(meta, rid);
+	if (pax_layout_.has_value()) {
+		page_guard.AsMut<PaxPage>().UpdateTupleMeta(meta, rid);
+		return;
+	}
+	page_guard.AsMut<TablePage>().UpdateTupleMeta(meta, rid);
 };
 
-std::optional<std::pair<TupleMeta, Tuple>> TableHeap::GetTuple(RID rid) const {
-	auto page_guard = bpm_.FetchPageRead(rid.GetPageId());
-	const auto &page = page_guard.As<TablePage>();
-	auto ret = page.GetTuple(rid);
+VacuumStats TableHeap::Vacuum(double deleted_ratio) {
+	if (pax_layout_.has_value()) {
+		// slots of a PAX page are not reused, there is nothing to compact
+		return {};
+	}
+	const auto table_oid = table_meta_.table_oid_;
+	std::unique_lock<std::mutex> lock(table_meta_.heap_latch_);
+	auto page_number = table_meta_.GetFirstTableHeapDataPageId();
+	lock.unlock();
+	VacuumStats stats;
+	while (page_number != INVALID_PAGE_ID) {
+		auto page_guard = bpm_.FetchPageWrite({table_oid, page_number});
+		auto &page = page_guard.AsMut<TablePage>();
+		auto next_page_number = page.GetNextPageId();
+		auto num_deleted = page.GetNumDeletedTuples();
+		if (num_deleted > 0 && num_deleted >= deleted_ratio * page.GetNumTuples()) {
+			// views of the tuples are read in place while the page is pinned, so compaction needs the only pin. anyone
+			// pinning the page after the check waits for the write latch before reading the slot array
+			if (bpm_.GetPinCount({table_oid, page_number}) > 1) {
+				stats.pages_skipped_++;
+			} else {
+				stats.bytes_reclaimed_ += page.Compact();
+				stats.pages_compacted_++;
+				auto free_space = page.GetFreeSpace();
+				page_guard.Drop();
+				fsm_.Update(page_number, free_space);
+			}
+		}
+		page_number = next_page_number;
+	}
+	LOG_TRACE("Vacuum compacted {} pages, skipped {}, reclaimed {} bytes", stats.pages_compacted_,
+	          stats.pages_skipped_, stats.bytes_reclaimed_);
+	return stats;
+}
+
+std::optional<std::pair<TupleMeta, Tuple>> TableHeap::GetTuple(RID rid, BufferRing *ring) const {
+	auto page_guard = bpm_.FetchPageRead(rid.GetPageId(), ring);
+	auto ret = pax_layout_.has_value() ? page_guard.As<PaxPage>().GetTuple(*pax_layout_, rid)
+	                                   : page_guard.As<TablePage>().GetTuple(rid);
 	if (!ret.has_value()) {
 		return std::nullopt;
 	}
 	auto [meta, tuple] = *ret;
 	tuple.rid_ = rid;
+	tuple.bpm_ = &bpm_;
 	return std::make_pair(meta, std::move(tuple));
 };
 
 TupleMeta TableHeap::GetTupleMeta(RID rid) {
 	auto page_guard = bpm_.FetchPageRead(rid.GetPageId());
-	const auto &page = page_guard.As<TablePage>();
-	return page.GetTupleMeta(rid);
+	if (pax_layout_.has_value()) {
+		return page_guard.As<PaxPage>().GetTupleMeta(rid);
+	}
+	return page_guard.As<TablePage>().GetTupleMeta(rid);
 };
 
-TableIterator TableHeap::MakeIterator() {
-	std::unique_lock<std::mutex> guard(latch_);
+page_id_t TableHeap::GetFirstPageId() const {
+	return table_meta_.GetFirstTableHeapDataPageId();
+}
+
+TableIterator TableHeap::MakeIterator(bool bulk_scan, std::vector<ZoneRange> ranges) {
+	std::unique_lock<std::mutex> guard(table_meta_.heap_latch_);
 	auto table_oid = table_meta_.table_oid_;
+	auto first_page_id = table_meta_.GetFirstTableHeapDataPageId();
 	auto last_page_id = table_meta_.GetLastTableHeapDataPageId();
 	guard.unlock();
 
 	auto page_guard = bpm_.FetchPageRead({table_oid, last_page_id});
-
-	const auto &page = page_guard.As<TablePage>();
-	auto num_tuples = page.GetNumTuples();
+	auto num_tuples = GetPageNumTuples(page_guard.GetData());
 	page_guard.Drop();
-	// iterate from rid 0, 0 to last_page_id and num_tuples
-	return TableIterator {*this, {{table_oid, 1}, 0}, {{table_oid, last_page_id}, num_tuples}};
+	// new pages are only linked with a tuple on them, but the first page stays empty until an insert gets to it
+	auto first_page_guard = bpm_.FetchPageRead({table_oid, first_page_id});
+	if (GetPageNumTuples(first_page_guard.GetData()) == 0) {
+		first_page_id =
+		    first_page_id == last_page_id ? INVALID_PAGE_ID : GetPageNextPageId(first_page_guard.GetData());
+	}
+	first_page_guard.Drop();
+	// iterate from the first tuple of the first page to last_page_id and num_tuples
+	return TableIterator {*this, {{table_oid, first_page_id}, 0}, {{table_oid, last_page_id}, num_tuples},
+	                      bulk_scan ? std::make_unique<BufferRing>(bpm_) : nullptr, std::move(ranges)};
+}
+
+void TableHeap::InitPage(char *page) const {
+	if (pax_layout_.has_value()) {
+		reinterpret_cast<PaxPage *>(page)->Init();
+	} else {
+		reinterpret_cast<TablePage *>(page)->Init();
+	}
+}
+
+std::optional<uint16_t> TableHeap::InsertIntoPage(char *page, const TupleMeta &meta, const Tuple &tuple) const {
+	if (pax_layout_.has_value()) {
+		return reinterpret_cast<PaxPage *>(page)->InsertTuple(*pax_layout_, meta, tuple);
+	}
+	return reinterpret_cast<TablePage *>(page)->InsertTuple(meta, tuple);
+}
+
+size_t TableHeap::GetPageFreeSpace(const char *page) const {
+	if (pax_layout_.has_value()) {
+		return reinterpret_cast<const PaxPage *>(page)->GetFreeSpace(*pax_layout_);
+	}
+	return reinterpret_cast<const TablePage *>(page)->GetFreeSpace();
+}
+
+uint32_t TableHeap::GetPageNumTuples(const char *page) const {
+	if (pax_layout_.has_value()) {
+		return reinterpret_cast<const PaxPage *>(page)->GetNumTuples();
+	}
+	return reinterpret_cast<const TablePage *>(page)->GetNumTuples();
+}
+
+page_id_t TableHeap::GetPageNextPageId(const char *page) const {
+	if (pax_layout_.has_value()) {
+		return reinterpret_cast<const PaxPage *>(page)->GetNextPageId();
+	}
+	return reinterpret_cast<const TablePage *>(page)->GetNextPageId();
+}
+
+void TableHeap::SetPageNextPageId(char *page, page_id_t next_page_id) const {
+	if (pax_layout_.has_value()) {
+		reinterpret_cast<PaxPage *>(page)->SetNextPageId(next_page_id);
+	} else {
+		reinterpret_cast<TablePage *>(page)->SetNextPageId(next_page_id);
+	}
 }
 
 } // namespace db
@@ -1,15 +1,84 @@
 #include "common/config.hpp"
+#include "storage/page/pax_page.hpp"
 #include "storage/page/table_page.hpp"
 #include "storage/table/table_heap.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <optional>
 
 namespace db {
 
+TableIterator::TableIterator(const TableHeap &table_heap, RID rid, RID stop_at_rid, std::unique_ptr<BufferRing> ring,
+                             std::vector<ZoneRange> ranges)
+    : table_heap_(table_heap), rid_(rid), stop_at_rid_(stop_at_rid), ring_(std::move(ring)),
+      ranges_(std::move(ranges)) {
+	rid_ = RID {{rid_.GetPageId().table_id_, SkipPages(rid_.GetPageId().page_number_)}, 0};
+}
+
 std::optional<std::pair<TupleMeta, Tuple>> TableIterator::GetTuple() {
+	auto ret = GetTupleView();
+	if (!ret.has_value()) {
+		return std::nullopt;
+	}
+	return std::make_pair(ret->first, ret->second.ToTuple());
+}
+
+std::optional<std::pair<TupleMeta, TupleView>> TableIterator::GetTupleView() {
 	LOG_TRACE("{}", rid_.ToString());
-	return table_heap_.GetTuple(rid_);
+	LoadPage();
+	if (rid_.GetSlotNum() >= slots_.size()) {
+		return std::nullopt;
+	}
+	return slots_[rid_.GetSlotNum()];
+}
+
+std::span<const TupleView> TableIterator::NextBatch() {
+	batch_.clear();
+	// the last page of the scan was kept pinned for the previous batch
+	if (IsEnd()) {
+		ReleasePage();
+	}
+	while (batch_.empty() && !IsEnd()) {
+		LoadPage();
+		for (auto slot = rid_.GetSlotNum(); slot < slots_.size(); slot++) {
+			if (!slots_[slot].first.is_deleted_) {
+				batch_.push_back(slots_[slot].second);
+			}
+		}
+		// the page stays pinned for the batch until the next page is loaded or the iterator is used at the end
+		MoveToNextPage();
+	}
+	return batch_;
+}
+
+const ColumnBatch &TableIterator::NextColumnBatch(const std::vector<column_t> &column_idxs) {
+	const auto *layout = table_heap_.GetPaxLayout();
+	assert(layout != nullptr && "column batches are only read from PAX pages");
+	column_batch_.metas_.clear();
+	column_batch_.columns_.clear();
+	if (IsEnd()) {
+		ReleasePage();
+	}
+	while (column_batch_.metas_.empty() && !IsEnd()) {
+		LoadPage();
+		const auto begin = rid_.GetSlotNum();
+		if (begin < slots_.size()) {
+			column_batch_.page_id_ = rid_.GetPageId();
+			column_batch_.begin_slot_ = begin;
+			for (auto slot = begin; slot < slots_.size(); slot++) {
+				column_batch_.metas_.push_back(slots_[slot].first);
+			}
+			const auto &page = page_guard_.As<PaxPage>();
+			for (auto column_idx : column_idxs) {
+				column_batch_.columns_.push_back(page.GetColumnData(*layout, column_idx) +
+				                                 begin * layout->GetValueWidth(column_idx));
+			}
+		}
+		// the page stays pinned for the batch until the next page is loaded or the iterator is used at the end
+		MoveToNextPage();
+	}
+	return column_batch_;
 }
 
 auto TableIterator::GetRID() -> RID {
@@ -20,34 +89,76 @@ auto TableIterator::IsEnd() -> bool {
 	return rid_.GetPageId().page_number_ == INVALID_PAGE_ID;
 }
 
-TableIterator &TableIterator::operator++() {
-	auto page_guard = table_heap_.bpm_.FetchPageRead(rid_.GetPageId());
-	const auto &page = page_guard.As<TablePage>();
-	auto next_tuple_id = rid_.GetSlotNum() + 1;
-
-	if (stop_at_rid_.GetPageId().page_number_ != INVALID_PAGE_ID) {
-		assert(
-		    /* case 1: cursor before the page of the stop tuple */ rid_.GetPageId().page_number_ <
-		        stop_at_rid_.GetPageId().page_number_ ||
-		    /* case 2: cursor at the page before the tuple */
-		    (rid_.GetPageId() == stop_at_rid_.GetPageId() && next_tuple_id <= stop_at_rid_.GetSlotNum()) &&
-		        "iterate out of bound");
+void TableIterator::LoadPage() {
+	if (pinned_page_number_ == rid_.GetPageId().page_number_) {
+		return;
+	}
+	// unpin first, so that a ring can recycle the frame
+	page_guard_.Drop();
+	slots_.clear();
+	page_guard_ = table_heap_.bpm_.FetchPageBasic(rid_.GetPageId(), ring_.get());
+	pinned_page_number_ = rid_.GetPageId().page_number_;
+	// the latch only guards the slot array, tuple data does not move while the page is pinned
+	page_guard_.RLatch();
+	const auto *page = page_guard_.GetData();
+	auto end = table_heap_.GetPageNumTuples(page);
+	if (rid_.GetPageId() == stop_at_rid_.GetPageId()) {
+		end = std::min(end, stop_at_rid_.GetSlotNum());
+		next_page_number_ = INVALID_PAGE_ID;
+	} else {
+		next_page_number_ = table_heap_.GetPageNextPageId(page);
+	}
+	if (const auto *layout = table_heap_.GetPaxLayout()) {
+		// the views read the values from the minipages, only once a column is asked for
+		reinterpret_cast<const PaxPage *>(page)->GetTupleViews(*layout, rid_.GetPageId(), end, slots_);
+	} else {
+		reinterpret_cast<const TablePage *>(page)->GetTupleViews(rid_.GetPageId(), end, slots_);
+	}
+	page_guard_.RUnlatch();
+	for (auto &[meta, view] : slots_) {
+		view.SetBufferPool(&table_heap_.bpm_);
 	}
+}
+
+void TableIterator::MoveToNextPage() {
+	// if next page is invalid, RID is set to invalid page; otherwise, it's the first tuple in that page.
+	rid_ = RID {{table_heap_.table_meta_.table_oid_, SkipPages(next_page_number_)}, 0};
+}
 
-	rid_ = RID {rid_.GetPageId(), next_tuple_id};
+void TableIterator::ReleasePage() {
+	page_guard_.Drop();
+	pinned_page_number_ = INVALID_PAGE_ID;
+	slots_.clear();
+}
 
-	if (rid_ == stop_at_rid_) {
-		rid_ = RID {{table_heap_.table_meta_.table_oid_, INVALID_PAGE_ID}, 0};
-	} else if (next_tuple_id < page.GetNumTuples()) {
-		// that's fine
-	} else {
-		auto next_page_id = page.GetNextPageId();
-		// if next page is invalid, RID is set to invalid page; otherwise, it's the first tuple in that page.
-		rid_ = RID {{table_heap_.table_meta_.table_oid_, next_page_id}, 0};
+page_id_t TableIterator::SkipPages(page_id_t page_number) {
+	while (!ranges_.empty() && page_number != INVALID_PAGE_ID) {
+		auto next_page_number = table_heap_.zone_map_.Skip(page_number, ranges_);
+		if (!next_page_number.has_value()) {
+			break;
+		}
+		skipped_page_count_++;
+		// pages linked after the stop tuple's are not part of the scan
+		page_number = page_number == stop_at_rid_.GetPageId().page_number_ ? INVALID_PAGE_ID : *next_page_number;
 	}
+	return page_number;
+}
 
-	page_guard.Drop();
+TableIterator &TableIterator::operator++() {
+	LoadPage();
+	auto next_tuple_id = rid_.GetSlotNum() + 1;
+	// the slots of the page of the stop tuple end before it
+	assert((slots_.empty() || next_tuple_id <= slots_.size()) && "iterate out of bound");
 
+	if (next_tuple_id < slots_.size()) {
+		rid_ = RID {rid_.GetPageId(), next_tuple_id};
+	} else {
+		MoveToNextPage();
+		// a tuple view is only valid until the iterator is advanced past its page
+		if (IsEnd()) {
+			ReleasePage();
+		}
+	}
 	return *this;
 }
 
@@ -2,6 +2,12 @@
 
 #include "common/typedef.hpp"
 #include "common/value.hpp"
+#include "storage/page/pax_page.hpp"
+#include "storage/table/overflow_chain.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
 
 namespace db {
 
@@ -57,29 +63,96 @@ void Tuple::DeserializeFrom(const char *storage, uint32_t size) {
 }
 
 Value Tuple::GetValue(const Column &col) const {
+	return TupleView(*this).GetValue(col);
+}
+
+Value Tuple::GetValue(const Schema &schema, uint32_t column_idx) const {
+	return TupleView(*this).GetValue(schema, column_idx);
+}
+
+auto Tuple::ToString(const Schema &schema) const -> std::string {
+	return TupleView(*this).ToString(schema);
+}
+
+Tuple Tuple::WithOverflowValues(const Schema &schema,
+                                const std::vector<std::pair<uint32_t, page_id_t>> &chains) const {
+	Tuple tuple;
+	tuple.rid_ = rid_;
+	tuple.bpm_ = bpm_;
+	tuple.data_.assign(data_.begin(), data_.begin() + schema.GetTupleInlinePartStorageSize());
+	for (auto column_idx : schema.GetUninlinedColumns()) {
+		const auto &col = schema.GetColumn(column_idx);
+		const auto *value_ptr = data_.data() + *reinterpret_cast<const uint32_t *>(data_.data() + col.GetStorageOffset());
+		uint32_t var_len = *reinterpret_cast<const uint32_t *>(value_ptr);
+		uint32_t offset = tuple.data_.size();
+		*reinterpret_cast<uint32_t *>(tuple.data_.data() + col.GetStorageOffset()) = offset;
+		auto chain = std::ranges::find(chains, column_idx, &std::pair<uint32_t, page_id_t>::first);
+		if (chain == chains.end()) {
+			// kept as it is, which may already be a reference
+			auto stored_size =
+			    (var_len & VARCHAR_OVERFLOW_FLAG) != 0 ? VARCHAR_OVERFLOW_REF_SIZE : sizeof(uint32_t) + var_len;
+			tuple.data_.insert(tuple.data_.end(), value_ptr, value_ptr + stored_size);
+			continue;
+		}
+		assert((var_len & VARCHAR_OVERFLOW_FLAG) == 0 && "value is already overflowed");
+		tuple.data_.resize(offset + VARCHAR_OVERFLOW_REF_SIZE);
+		var_len |= VARCHAR_OVERFLOW_FLAG;
+		std::memcpy(tuple.data_.data() + offset, &var_len, sizeof(uint32_t));
+		std::memcpy(tuple.data_.data() + offset + sizeof(uint32_t), &chain->second, sizeof(page_id_t));
+	}
+	return tuple;
+}
+
+Value TupleView::GetValue(const Column &col) const {
 	const_data_ptr_t data_ptr = GetDataPtr(col);
+	if (IsOverflowed(col)) {
+		if (bpm_ == nullptr) {
+			throw RuntimeException("Overflowed value read without a buffer pool");
+		}
+		auto var_len = *reinterpret_cast<const uint32_t *>(data_ptr) & ~VARCHAR_OVERFLOW_FLAG;
+		auto page_number = *reinterpret_cast<const page_id_t *>(data_ptr + sizeof(uint32_t));
+		return {TypeId::VARCHAR, ReadOverflowChain(*bpm_, {rid_.GetPageId().table_id_, page_number}, var_len)};
+	}
 	return Value::DeserializeFrom(data_ptr, col.GetType());
 }
 
-Value Tuple::GetValue(const Schema &schema, uint32_t column_idx) const {
+bool TupleView::IsOverflowed(const Column &col) const {
+	if (col.IsInlined()) {
+		return false;
+	}
+	return (*reinterpret_cast<const uint32_t *>(GetDataPtr(col)) & VARCHAR_OVERFLOW_FLAG) != 0;
+}
+
+Value TupleView::GetValue(const Schema &schema, uint32_t column_idx) const {
 	const auto &col = schema.GetColumn(column_idx);
 	return GetValue(col);
 }
 
-const_data_ptr_t Tuple::GetDataPtr(const Column &col) const {
+uint32_t TupleView::GetStorageSize() const {
+	if (pax_layout_ != nullptr) {
+		return reinterpret_cast<const PaxPage *>(data_)->GetTupleSize(*pax_layout_, rid_.GetSlotNum());
+	}
+	return size_;
+}
+
+const_data_ptr_t TupleView::GetDataPtr(const Column &col) const {
+	if (pax_layout_ != nullptr) {
+		return reinterpret_cast<const PaxPage *>(data_)->GetValuePtr(*pax_layout_, col.GetSchemaOffset(),
+		                                                              rid_.GetSlotNum());
+	}
 	bool is_inlined = col.IsInlined();
 	if (is_inlined) {
-		assert(col.GetStorageOffset() < data_.size() && "offset out of range");
-		return (data_.data() + col.GetStorageOffset());
+		assert(col.GetStorageOffset() < size_ && "offset out of range");
+		return (data_ + col.GetStorageOffset());
 	}
 
 	// read the relative offset from the tuple data.
-	int32_t offset = *reinterpret_cast<const int32_t *>(data_.data() + col.GetStorageOffset());
+	int32_t offset = *reinterpret_cast<const int32_t *>(data_ + col.GetStorageOffset());
 	// return the beginning address of the real data for the VARCHAR type.
-	return (data_.data() + offset);
+	return (data_ + offset);
 }
 
-auto Tuple::ToString(const Schema &schema) const -> std::string {
+auto TupleView::ToString(const Schema &schema) const -> std::string {
 	std::vector<std::string> values;
 	uint32_t column_count = schema.GetColumnCount();
 
@@ -90,4 +163,20 @@ auto Tuple::ToString(const Schema &schema) const -> std::string {
 
 	return fmt::format("({})", fmt::join(values, ", "));
 }
+
+Tuple TupleView::ToTuple() const {
+	Tuple tuple;
+	CopyTo(tuple);
+	return tuple;
+}
+
+void TupleView::CopyTo(Tuple &tuple) const {
+	if (pax_layout_ != nullptr) {
+		reinterpret_cast<const PaxPage *>(data_)->ReadTuple(*pax_layout_, rid_.GetSlotNum(), tuple.data_);
+	} else {
+		tuple.data_.assign(data_, data_ + size_);
+	}
+	tuple.rid_ = rid_;
+	tuple.bpm_ = bpm_;
+}
 } // namespace db
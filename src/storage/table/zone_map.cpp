@@ -0,0 +1,173 @@
+#include "storage/table/zone_map.hpp"
+
+#include "common/config.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <mutex>
+#include <shared_mutex>
+
+namespace db {
+
+ZoneMap::ZoneMap(BufferPool &bpm, TableMeta &table_meta, PageAllocator &page_allocator)
+    : bpm_(bpm), table_meta_(table_meta), page_allocator_(page_allocator) {
+	for (uint32_t column_idx = 0; column_idx < table_meta_.schema_.GetColumnCount(); column_idx++) {
+		// a zone holds the bounds of as many columns as fit a map page, the columns past them are not tracked
+		if (table_meta_.schema_.GetColumn(column_idx).IsInlined() &&
+		    ZoneMapPage::GetZoneCount(ZoneMapPage::GetZoneSize(columns_.size() + 1)) > 0) {
+			columns_.push_back(column_idx);
+		}
+	}
+	zone_size_ = ZoneMapPage::GetZoneSize(columns_.size());
+	zone_count_ = ZoneMapPage::GetZoneCount(zone_size_);
+	assert(zone_count_ > 0 && "a zone has to fit a map page");
+}
+
+void ZoneMap::Create() {
+	assert(table_meta_.zone_map_page_id_ == INVALID_PAGE_ID);
+	PageId page_id {table_meta_.table_oid_};
+	auto guard = bpm_.NewPageGuarded(page_allocator_, page_id);
+	guard.AsMut<ZoneMapPage>().Init();
+	table_meta_.zone_map_page_id_ = page_id.page_number_;
+}
+
+ZoneBounds ZoneMap::MakeBounds() const {
+	return ZoneBounds(columns_.size(), {std::numeric_limits<int64_t>::max(), std::numeric_limits<int64_t>::min()});
+}
+
+void ZoneMap::Extend(ZoneBounds &bounds, const TupleView &tuple) const {
+	for (size_t i = 0; i < columns_.size(); i++) {
+		auto key = ToZoneKey(tuple.GetValue(table_meta_.schema_, columns_[i]));
+		bounds[i].first = std::min(bounds[i].first, key);
+		bounds[i].second = std::max(bounds[i].second, key);
+	}
+}
+
+void ZoneMap::Track(page_id_t page_number, const ZoneBounds &bounds) {
+	auto guard = FetchZonePage(page_number);
+	auto &zone = guard.AsMut<ZoneMapPage>().GetZone(page_number % zone_count_, zone_size_);
+	zone.next_page_id_ = INVALID_PAGE_ID;
+	zone.is_tracked_ = 1;
+	for (size_t i = 0; i < bounds.size(); i++) {
+		zone.bounds_[2 * i] = bounds[i].first;
+		zone.bounds_[2 * i + 1] = bounds[i].second;
+	}
+}
+
+void ZoneMap::Extend(page_id_t page_number, const TupleView &tuple) {
+	auto bounds = MakeBounds();
+	Extend(bounds, tuple);
+	auto guard = FetchZonePage(page_number);
+	auto &zone = guard.AsMut<ZoneMapPage>().GetZone(page_number % zone_count_, zone_size_);
+	if (zone.is_tracked_ == 0) {
+		return;
+	}
+	for (size_t i = 0; i < bounds.size(); i++) {
+		zone.bounds_[2 * i] = std::min(zone.bounds_[2 * i], bounds[i].first);
+		zone.bounds_[2 * i + 1] = std::max(zone.bounds_[2 * i + 1], bounds[i].second);
+	}
+}
+
+void ZoneMap::SetNextPageId(page_id_t page_number, page_id_t next_page_number) {
+	auto guard = FetchZonePage(page_number);
+	guard.AsMut<ZoneMapPage>().GetZone(page_number % zone_count_, zone_size_).next_page_id_ = next_page_number;
+}
+
+std::optional<page_id_t> ZoneMap::Skip(page_id_t page_number, const std::vector<ZoneRange> &ranges) const {
+	auto map_page_number = GetMapPage(page_number / zone_count_);
+	if (map_page_number == INVALID_PAGE_ID) {
+		// the map does not cover the page
+		return std::nullopt;
+	}
+	auto guard = bpm_.FetchPageRead({table_meta_.table_oid_, map_page_number});
+	const auto &zone = guard.As<ZoneMapPage>().GetZone(page_number % zone_count_, zone_size_);
+	if (zone.is_tracked_ == 0) {
+		return std::nullopt;
+	}
+	for (const auto &range : ranges) {
+		auto column = std::ranges::find(columns_, range.column_idx_);
+		if (column == columns_.end()) {
+			// a varchar column or one past those a zone has room for
+			continue;
+		}
+		auto i = column - columns_.begin();
+		if (zone.bounds_[2 * i] > range.max_ || zone.bounds_[2 * i + 1] < range.min_) {
+			return zone.next_page_id_;
+		}
+	}
+	return std::nullopt;
+}
+
+int64_t ZoneMap::ToZoneKey(const Value &value) {
+	switch (value.GetTypeId()) {
+	case TypeId::BOOLEAN:
+		return value.GetAs<int8_t>();
+	case TypeId::INTEGER:
+		return value.GetAs<int32_t>();
+	case TypeId::TIMESTAMP:
+		// flip the sign bit so that the unsigned timestamps order like signed keys
+		return static_cast<int64_t>(value.GetAs<uint64_t>() ^ (uint64_t {1} << 63));
+	case TypeId::VARCHAR:
+	case TypeId::INVALID:
+		throw RuntimeException("Zone keys only exist for fixed-size values");
+	}
+	std::unreachable();
+}
+
+WritePageGuard ZoneMap::FetchZonePage(page_id_t page_number) {
+	const auto map_index = page_number / zone_count_;
+	auto map_page_number = GetMapPage(map_index);
+	while (map_page_number == INVALID_PAGE_ID) {
+		Grow();
+		map_page_number = GetMapPage(map_index);
+	}
+	return bpm_.FetchPageWrite({table_meta_.table_oid_, map_page_number});
+}
+
+page_id_t ZoneMap::GetMapPage(size_t map_index) const {
+	{
+		std::shared_lock<std::shared_mutex> lock(map_page_latch_);
+		if (map_index < map_page_numbers_.size()) {
+			return map_page_numbers_[map_index];
+		}
+	}
+	std::unique_lock<std::shared_mutex> lock(map_page_latch_);
+	if (map_page_numbers_.empty()) {
+		if (table_meta_.zone_map_page_id_ == INVALID_PAGE_ID) {
+			return INVALID_PAGE_ID;
+		}
+		map_page_numbers_.push_back(table_meta_.zone_map_page_id_);
+	}
+	// pages are only ever appended to the map, the known ones stay valid and the rest is linked after the last
+	while (map_index >= map_page_numbers_.size()) {
+		auto guard = bpm_.FetchPageRead({table_meta_.table_oid_, map_page_numbers_.back()});
+		auto next_page_number = guard.As<ZoneMapPage>().GetNextPageId();
+		if (next_page_number == INVALID_PAGE_ID) {
+			return INVALID_PAGE_ID;
+		}
+		map_page_numbers_.push_back(next_page_number);
+	}
+	return map_page_numbers_[map_index];
+}
+
+void ZoneMap::Grow() {
+	page_id_t page_number;
+	{
+		std::shared_lock<std::shared_mutex> lock(map_page_latch_);
+		assert(!map_page_numbers_.empty() && "the map has a first page");
+		page_number = map_page_numbers_.back();
+	}
+	// not the heap latch, zones are updated while linking heap pages under it
+	std::lock_guard<std::mutex> lock(table_meta_.zone_map_latch_);
+	auto guard = bpm_.FetchPageWrite({table_meta_.table_oid_, page_number});
+	// another thread may have grown the map in the meantime
+	if (guard.As<ZoneMapPage>().GetNextPageId() == INVALID_PAGE_ID) {
+		PageId next_page_id {table_meta_.table_oid_};
+		auto next_guard = bpm_.NewPageGuarded(page_allocator_, next_page_id);
+		next_guard.AsMut<ZoneMapPage>().Init();
+		guard.AsMut<ZoneMapPage>().SetNextPageId(next_page_id.page_number_);
+	}
+}
+
+} // namespace db
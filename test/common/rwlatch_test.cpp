@@ -0,0 +1,95 @@
+#include "common/logger.hpp"
+#include "common/rwlatch.hpp"
+
+#include "gtest/gtest.h"
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+namespace db {
+
+// readers never see a half done update while writers and readers hammer the same latch
+TEST(ReaderWriterLatchTest, ExclusionTest) {
+	const int thread_count = 8;
+	const int ops_per_thread = 20000;
+	ReaderWriterLatch latch;
+	uint64_t a = 0;
+	uint64_t b = 0;
+
+	std::vector<std::thread> threads;
+	threads.reserve(thread_count);
+	for (int t = 0; t < thread_count; t++) {
+		threads.emplace_back([&, t]() {
+			std::mt19937 gen(t);
+			for (int i = 0; i < ops_per_thread; i++) {
+				if (gen() % 4 == 0) {
+					latch.WLock();
+					a++;
+					b++;
+					latch.WUnlock();
+				} else {
+					latch.RLock();
+					ASSERT_EQ(a, b);
+					latch.RUnlock();
+				}
+			}
+		});
+	}
+	for (auto &thread : threads) {
+		thread.join();
+	}
+	ASSERT_EQ(a, b);
+	LOG_INFO("latch of {} bytes instead of {}, waited {} times for {} us", sizeof(ReaderWriterLatch),
+	         sizeof(std::shared_mutex), latch.GetWaitCount(), latch.GetWaitNanos() / 1000);
+}
+
+// an upgrade waits for the other readers to leave, a second concurrent upgrade is refused instead of deadlocking
+TEST(ReaderWriterLatchTest, UpgradeTest) {
+	ReaderWriterLatch latch;
+	latch.RLock();
+	auto version = latch.ReadVersion();
+	ASSERT_TRUE(version.has_value());
+
+	std::atomic<bool> upgraded {false};
+	std::thread upgrader([&]() {
+		latch.RLock();
+		ASSERT_TRUE(latch.Upgrade());
+		upgraded = true;
+		latch.WUnlock();
+	});
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	ASSERT_FALSE(upgraded);
+	ASSERT_FALSE(latch.Upgrade());
+	latch.RUnlock();
+	upgrader.join();
+	ASSERT_TRUE(upgraded);
+	ASSERT_FALSE(latch.ValidateVersion(*version));
+	ASSERT_EQ(latch.GetWaitCount(), 1);
+}
+
+// a reader blocked behind a writer is accounted to the latch
+TEST(ReaderWriterLatchTest, WaitStatsTest) {
+	ReaderWriterLatch latch;
+	latch.RLock();
+	latch.RUnlock();
+	ASSERT_EQ(latch.GetWaitCount(), 0);
+
+	latch.WLock();
+	ASSERT_FALSE(latch.ReadVersion().has_value());
+	std::thread reader([&]() {
+		latch.RLock();
+		latch.RUnlock();
+	});
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	latch.WUnlock();
+	reader.join();
+	ASSERT_EQ(latch.GetWaitCount(), 1);
+	ASSERT_GE(latch.GetWaitNanos(), 10'000'000);
+	latch.ResetStats();
+	ASSERT_EQ(latch.GetWaitCount(), 0);
+	ASSERT_EQ(latch.GetWaitNanos(), 0);
+}
+} // namespace db
@@ -1,5 +1,6 @@
 
 
+#include "common/fs_utils.hpp"
 #include "common/test_utils.hpp"
 #include "concurrency/transaction.hpp"
 #include "index/bplus_tree_index.hpp"
@@ -8,10 +9,22 @@
 #include "storage/table/table_heap.hpp"
 
 #include "gtest/gtest.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <tuple>
 namespace db {
 
 TEST(IndexTest, IndexTest) {
+	DeletePathIfExists(FilePathManager::GetInstance().GetDatabaseRootPath());
 	const size_t buffer_pool_size = 10;
 	auto cm = std::make_unique<Catalog>();
 	auto dm = std::make_unique<DiskManager>(*cm);
@@ -75,6 +88,7 @@ TEST(IndexTest, IndexTest) {
 }
 
 TEST(IndexTest, IndexManyInsertionsTest) {
+	DeletePathIfExists(FilePathManager::GetInstance().GetDatabaseRootPath());
 	const size_t buffer_pool_size = 13;
 	auto cm = std::make_unique<db::Catalog>();
 	auto dm = std::make_unique<DiskManager>(*cm);
@@ -150,4 +164,677 @@ TEST(IndexTest, IndexManyInsertionsTest) {
 		}
 	}
 }
+
+// lookups descend optimistically while a writer keeps splitting pages, every key inserted before is still found and a
+// lookup without concurrent writers never restarts
+TEST(IndexTest, OptimisticLookupTest) {
+	DeletePathIfExists(FilePathManager::GetInstance().GetDatabaseRootPath());
+	const size_t buffer_pool_size = 256;
+	const int32_t key_count = 5000;
+	const int reader_count = 3;
+	auto cm = std::make_unique<Catalog>();
+	auto dm = std::make_unique<DiskManager>(*cm);
+	auto bpm = std::make_unique<BufferPool>(buffer_pool_size, *dm);
+
+	auto schema = Schema({Column("user_id", TypeId::INTEGER)});
+	cm->CreateTable("user", schema);
+	auto &table_meta = cm->GetTableByName("user");
+	auto index_meta = std::make_unique<IndexMeta>("user_id_index", table_meta.table_oid_, schema.GetColumn(0),
+	                                              IndexConstraintType::PRIMARY, IndexType::BPlusTreeIndex);
+	auto btree_index = std::make_unique<BTreeIndex>(*index_meta, table_meta, *bpm);
+
+	auto make_tuple = [&schema](int32_t key) { return Tuple({Value(TypeId::INTEGER, key)}, schema); };
+	auto make_rid = [&table_meta](int32_t key) { return RID({table_meta.table_oid_, key}, key); };
+	std::vector<RID> rids;
+	ASSERT_FALSE(btree_index->ScanKey(make_tuple(0), rids));
+
+	Transaction txn {1, IsolationLevel::READ_UNCOMMITTED};
+	for (int32_t key = 0; key < key_count; key++) {
+		ASSERT_TRUE(btree_index->InsertRecord(txn, make_tuple(key), make_rid(key)));
+	}
+	for (int32_t key = 0; key < key_count; key++) {
+		rids.clear();
+		ASSERT_TRUE(btree_index->ScanKey(make_tuple(key), rids));
+		ASSERT_EQ(rids[0], make_rid(key));
+	}
+	ASSERT_FALSE(btree_index->ScanKey(make_tuple(key_count), rids));
+	ASSERT_EQ(btree_index->GetOptimisticRestartCount(), 0);
+	ASSERT_EQ(btree_index->GetPessimisticLookupCount(), 0);
+
+	std::atomic<bool> done {false};
+	std::atomic<uint64_t> lookups {0};
+	std::vector<std::thread> threads;
+	threads.emplace_back([&]() {
+		Transaction writer_txn {2, IsolationLevel::READ_UNCOMMITTED};
+		for (int32_t key = key_count; key < 2 * key_count; key++) {
+			btree_index->InsertRecord(writer_txn, make_tuple(key), make_rid(key));
+		}
+		done = true;
+	});
+	for (int t = 0; t < reader_count; t++) {
+		threads.emplace_back([&, t]() {
+			std::mt19937 gen(t);
+			std::uniform_int_distribution<int32_t> dist(0, key_count - 1);
+			std::vector<RID> found;
+			while (!done) {
+				auto key = dist(gen);
+				found.clear();
+				ASSERT_TRUE(btree_index->ScanKey(make_tuple(key), found));
+				ASSERT_EQ(found[0], make_rid(key));
+				lookups++;
+			}
+		});
+	}
+	for (auto &thread : threads) {
+		thread.join();
+	}
+	LOG_INFO("{} lookups during inserts, {} optimistic restarts, {} pessimistic lookups", lookups.load(),
+	         btree_index->GetOptimisticRestartCount(), btree_index->GetPessimisticLookupCount());
+}
+
+// optimistic lookups read frames without pinning them, while lookups missing the pool keep giving those frames to
+// other pages. every key is still found
+TEST(IndexTest, OptimisticLookupEvictionTest) {
+	DeletePathIfExists(FilePathManager::GetInstance().GetDatabaseRootPath());
+	const size_t buffer_pool_size = 16;
+	const int32_t key_count = 10000;
+	const int reader_count = 4;
+	const int lookup_count = 2000;
+	auto cm = std::make_unique<Catalog>();
+	auto dm = std::make_unique<DiskManager>(*cm);
+	auto bpm = std::make_unique<BufferPool>(buffer_pool_size, *dm);
+
+	auto schema = Schema({Column("user_id", TypeId::INTEGER)});
+	cm->CreateTable("user", schema);
+	auto &table_meta = cm->GetTableByName("user");
+	IndexMeta index_meta("user_id_index", table_meta.table_oid_, schema.GetColumn(0), IndexConstraintType::PRIMARY,
+	                     IndexType::BPlusTreeIndex);
+	BTreeIndex index(index_meta, table_meta, *bpm);
+	const IndexKeyLayout key_layout({Column("user_id", TypeId::INTEGER)});
+	std::vector<std::pair<IndexKeyType, RID>> entries;
+	for (int32_t key = 0; key < key_count; key++) {
+		entries.emplace_back(*key_layout.Encode({Value(TypeId::INTEGER, key)}),
+		                     RID({table_meta.table_oid_, key}, key));
+	}
+	index.BulkLoad(std::move(entries));
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < reader_count; t++) {
+		threads.emplace_back([&, t]() {
+			std::mt19937 gen(t);
+			std::uniform_int_distribution<int32_t> dist(0, key_count - 1);
+			std::vector<RID> found;
+			for (int i = 0; i < lookup_count; i++) {
+				auto key = dist(gen);
+				found.clear();
+				ASSERT_TRUE(index.ScanKey(Tuple({Value(TypeId::INTEGER, key)}, schema), found));
+				ASSERT_EQ(found[0], RID({table_meta.table_oid_, key}, key));
+			}
+		});
+	}
+	for (auto &thread : threads) {
+		thread.join();
+	}
+	ASSERT_GT(index.GetPessimisticLookupCount(), 0);
+	LOG_INFO("{} optimistic restarts, {} pessimistic lookups", index.GetOptimisticRestartCount(),
+	         index.GetPessimisticLookupCount());
+}
+
+// point lookups from several threads on a tree that fits the pool, descending optimistically and latching their way
+// down, are timed
+TEST(IndexTest, LookupBenchmark) {
+	DeletePathIfExists(FilePathManager::GetInstance().GetDatabaseRootPath());
+	const int32_t key_count = 20000;
+	const int lookup_count = 1000;
+	auto cm = std::make_unique<Catalog>();
+	auto dm = std::make_unique<DiskManager>(*cm);
+	auto bpm = std::make_unique<BufferPool>(1024, *dm);
+	auto schema = Schema({Column("id", TypeId::INTEGER)});
+	cm->CreateTable("user", schema);
+	auto &table_meta = cm->GetTableByName("user");
+	IndexMeta index_meta("id_index", table_meta.table_oid_, schema.GetColumn(0), IndexConstraintType::PRIMARY,
+	                     IndexType::BPlusTreeIndex);
+	BTreeIndex index(index_meta, table_meta, *bpm);
+	const IndexKeyLayout key_layout({Column("id", TypeId::INTEGER)});
+	std::vector<std::pair<IndexKeyType, RID>> entries;
+	for (int32_t key = 0; key < key_count; key++) {
+		entries.emplace_back(*key_layout.Encode({Value(TypeId::INTEGER, key)}), RID({table_meta.table_oid_, key}, key));
+	}
+	index.BulkLoad(std::move(entries));
+	std::vector<Tuple> tuples;
+	for (int32_t key = 0; key < key_count; key++) {
+		tuples.emplace_back(std::vector<Value> {Value(TypeId::INTEGER, key)}, schema);
+	}
+
+	auto time_lookups = [&](int thread_count) {
+		std::atomic<uint64_t> found_count {0};
+		std::vector<std::thread> threads;
+		auto start = std::chrono::steady_clock::now();
+		for (int t = 0; t < thread_count; t++) {
+			threads.emplace_back([&, t]() {
+				std::mt19937 gen(t);
+				std::uniform_int_distribution<int32_t> dist(0, key_count - 1);
+				std::vector<RID> rids;
+				for (int i = 0; i < lookup_count; i++) {
+					rids.clear();
+					index.ScanKey(tuples[dist(gen)], rids);
+					found_count += rids.size();
+				}
+			});
+		}
+		for (auto &thread : threads) {
+			thread.join();
+		}
+		auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		EXPECT_EQ(found_count, static_cast<uint64_t>(thread_count) * lookup_count);
+		return thread_count * lookup_count / elapsed;
+	};
+	for (int thread_count : {1, 2, 4, 8}) {
+		index.SetOptimisticLookups(false);
+		auto latched = time_lookups(thread_count);
+		index.SetOptimisticLookups(true);
+		auto optimistic = time_lookups(thread_count);
+		LOG_INFO("{} threads: {:.0f} latched lookups/s, {:.0f} optimistic lookups/s", thread_count, latched, optimistic);
+	}
+}
+
+// range scans walk the leaf chain in both directions, with open, inclusive and exclusive bounds
+TEST(IndexTest, RangeScanTest) {
+	DeletePathIfExists(FilePathManager::GetInstance().GetDatabaseRootPath());
+	const size_t buffer_pool_size = 64;
+	const int32_t key_count = 3000;
+	auto cm = std::make_unique<Catalog>();
+	auto dm = std::make_unique<DiskManager>(*cm);
+	auto bpm = std::make_unique<BufferPool>(buffer_pool_size, *dm);
+
+	auto schema = Schema({Column("user_id", TypeId::INTEGER)});
+	cm->CreateTable("user", schema);
+	auto &table_meta = cm->GetTableByName("user");
+	auto index_meta = std::make_unique<IndexMeta>("user_id_index", table_meta.table_oid_, schema.GetColumn(0),
+	                                              IndexConstraintType::PRIMARY, IndexType::BPlusTreeIndex);
+	auto btree_index = std::make_unique<BTreeIndex>(*index_meta, table_meta, *bpm);
+
+	auto make_rid = [&table_meta](int32_t key) { return RID({table_meta.table_oid_, key}, key); };
+	auto scan = [&](std::optional<int32_t> low, bool low_inclusive, std::optional<int32_t> high, bool high_inclusive,
+	                bool reverse) {
+		IndexRange range;
+		if (low.has_value()) {
+			range.low_ = {Value(TypeId::INTEGER, *low)};
+		}
+		if (high.has_value()) {
+			range.high_ = {Value(TypeId::INTEGER, *high)};
+		}
+		range.low_inclusive_ = low_inclusive;
+		range.high_inclusive_ = high_inclusive;
+		std::vector<RID> rids;
+		btree_index->ScanRange(range, rids, reverse);
+		return rids;
+	};
+	// the rids of the even keys in [min, max] in the order of the scan
+	auto expect = [&](int32_t min, int32_t max, bool reverse) {
+		std::vector<RID> rids;
+		for (int32_t key = min + (min % 2 != 0 ? 1 : 0); key <= max; key += 2) {
+			rids.push_back(make_rid(key));
+		}
+		if (reverse) {
+			std::ranges::reverse(rids);
+		}
+		return rids;
+	};
+	ASSERT_TRUE(scan(std::nullopt, true, std::nullopt, true, false).empty());
+	ASSERT_TRUE(btree_index->RBegin().IsEnd());
+
+	// only even keys, so that bounds also fall between keys
+	std::vector<int32_t> keys;
+	for (int32_t key = 0; key < 2 * key_count; key += 2) {
+		keys.push_back(key);
+	}
+	std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+	Transaction txn {1, IsolationLevel::READ_UNCOMMITTED};
+	for (auto key : keys) {
+		ASSERT_TRUE(btree_index->InsertRecord(txn, Tuple({Value(TypeId::INTEGER, key)}, schema), make_rid(key)));
+	}
+	const int32_t max_key = 2 * key_count - 2;
+
+	for (bool reverse : {false, true}) {
+		ASSERT_EQ(scan(std::nullopt, true, std::nullopt, true, reverse), expect(0, max_key, reverse));
+		// BETWEEN, across many leaves
+		ASSERT_EQ(scan(100, true, 4000, true, reverse), expect(100, 4000, reverse));
+		ASSERT_EQ(scan(101, true, 3999, true, reverse), expect(101, 3999, reverse));
+		// > and <
+		ASSERT_EQ(scan(100, false, std::nullopt, true, reverse), expect(101, max_key, reverse));
+		ASSERT_EQ(scan(std::nullopt, true, 100, false, reverse), expect(0, 99, reverse));
+		ASSERT_EQ(scan(-50, true, 0, true, reverse), expect(0, 0, reverse));
+		ASSERT_EQ(scan(max_key, true, max_key + 10, true, reverse), expect(max_key, max_key, reverse));
+		ASSERT_TRUE(scan(max_key, false, std::nullopt, true, reverse).empty());
+		ASSERT_TRUE(scan(5, true, 5, true, reverse).empty());
+		ASSERT_TRUE(scan(200, true, 100, true, reverse).empty());
+	}
+
+	// an iterator turns around anywhere, also on the first key of a leaf
+	auto it = btree_index->Begin(btree_index->GetKeyLayout().Encode({Value(TypeId::INTEGER, 1001)}));
+	for (int32_t key = 1002; key < 1802; key += 2) {
+		ASSERT_EQ(it.GetValue(), make_rid(key));
+		++it;
+	}
+	for (int32_t key = 1802; key > 2; key -= 2) {
+		ASSERT_EQ(it.GetValue(), make_rid(key));
+		--it;
+	}
+	ASSERT_EQ(it.GetValue(), make_rid(2));
+	--it;
+	--it;
+	ASSERT_TRUE(it.IsEnd());
+}
+
+// deletes borrow from and merge with siblings until the root collapses back into an empty leaf, while range scans run
+// into no deadlock with them
+TEST(IndexTest, DeleteTest) {
+	DeletePathIfExists(FilePathManager::GetInstance().GetDatabaseRootPath());
+	const size_t buffer_pool_size = 128;
+	// enough for a tree of three levels
+	const int32_t key_count = 27000;
+	auto cm = std::make_unique<Catalog>();
+	auto dm = std::make_unique<DiskManager>(*cm);
+	auto bpm = std::make_unique<BufferPool>(buffer_pool_size, *dm);
+
+	auto schema = Schema({Column("user_id", TypeId::INTEGER)});
+	cm->CreateTable("user", schema);
+	auto &table_meta = cm->GetTableByName("user");
+	auto index_meta = std::make_unique<IndexMeta>("user_id_index", table_meta.table_oid_, schema.GetColumn(0),
+	                                              IndexConstraintType::PRIMARY, IndexType::BPlusTreeIndex);
+	auto btree_index = std::make_unique<BTreeIndex>(*index_meta, table_meta, *bpm);
+
+	auto make_tuple = [&schema](int32_t key) { return Tuple({Value(TypeId::INTEGER, key)}, schema); };
+	auto make_rid = [&table_meta](int32_t key) { return RID({table_meta.table_oid_, key}, key); };
+	auto root_is_leaf = [&]() {
+		auto header_guard = bpm->FetchPageRead({table_meta.table_oid_, index_meta->header_page_id_});
+		auto root_page_id = header_guard.As<BtreeHeaderPage>().GetRootPageId();
+		return bpm->FetchPageRead({table_meta.table_oid_, root_page_id}).As<BtreePage>().IsLeafPage();
+	};
+	auto scan_all = [&]() {
+		std::vector<RID> rids;
+		btree_index->ScanRange({}, rids);
+		return rids;
+	};
+
+	Transaction txn {1, IsolationLevel::READ_UNCOMMITTED};
+	for (int32_t key = 0; key < key_count; key++) {
+		ASSERT_TRUE(btree_index->InsertRecord(txn, make_tuple(key), make_rid(key)));
+	}
+	ASSERT_FALSE(root_is_leaf());
+	ASSERT_FALSE(btree_index->DeleteRecord(txn, make_tuple(key_count)));
+
+	std::vector<int32_t> keys(key_count);
+	std::iota(keys.begin(), keys.end(), 0);
+	std::shuffle(keys.begin(), keys.end(), std::mt19937(7));
+	std::set<int32_t> remaining(keys.begin(), keys.end());
+	for (int32_t i = 0; i < key_count; i++) {
+		ASSERT_TRUE(btree_index->DeleteRecord(txn, make_tuple(keys[i])));
+		remaining.erase(keys[i]);
+		if (i % 5000 == 0 || i + 10 > key_count) {
+			ASSERT_FALSE(btree_index->DeleteRecord(txn, make_tuple(keys[i])));
+			std::vector<RID> expected;
+			for (auto key : remaining) {
+				expected.push_back(make_rid(key));
+			}
+			ASSERT_EQ(scan_all(), expected);
+			for (auto key : {keys[i], keys[(i + 1) % key_count]}) {
+				std::vector<RID> rids;
+				ASSERT_EQ(btree_index->ScanKey(make_tuple(key), rids), remaining.contains(key));
+			}
+		}
+	}
+	ASSERT_TRUE(scan_all().empty());
+	ASSERT_TRUE(root_is_leaf());
+
+	// two deleters of disjoint keys and a scanner going both ways along the leaves
+	for (int32_t key = 0; key < key_count / 8; key++) {
+		ASSERT_TRUE(btree_index->InsertRecord(txn, make_tuple(key), make_rid(key)));
+	}
+	std::atomic<int> deleters_done {0};
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 2; t++) {
+		threads.emplace_back([&, t]() {
+			Transaction deleter_txn {2 + t, IsolationLevel::READ_UNCOMMITTED};
+			for (int32_t key = t; key < key_count / 8; key += 2) {
+				ASSERT_TRUE(btree_index->DeleteRecord(deleter_txn, make_tuple(key)));
+			}
+			deleters_done++;
+		});
+	}
+	threads.emplace_back([&]() {
+		bool reverse = false;
+		while (deleters_done < 2) {
+			std::vector<RID> rids;
+			btree_index->ScanRange({}, rids, reverse);
+			ASSERT_TRUE(std::ranges::is_sorted(rids, [reverse](const RID &a, const RID &b) {
+				return reverse ? a.GetSlotNum() > b.GetSlotNum() : a.GetSlotNum() < b.GetSlotNum();
+			}));
+			reverse = !reverse;
+		}
+	});
+	for (auto &thread : threads) {
+		thread.join();
+	}
+	ASSERT_TRUE(scan_all().empty());
+}
+
+// an index created on a populated table is built bottom up from its sorted keys, with nodes filled to the fill factor
+TEST(IndexTest, BulkLoadTest) {
+	DeletePathIfExists(FilePathManager::GetInstance().GetDatabaseRootPath());
+	const size_t buffer_pool_size = 64;
+	const int32_t row_count = 5000;
+	auto cm = std::make_unique<Catalog>();
+	auto dm = std::make_unique<DiskManager>(*cm);
+	auto bpm = std::make_unique<BufferPool>(buffer_pool_size, *dm);
+
+	auto schema = Schema({Column("user_id", TypeId::INTEGER), Column("user_name", TypeId::VARCHAR, 32)});
+	cm->CreateTable("user", schema);
+	auto &table_meta = cm->GetTableByName("user");
+	auto table_heap = std::make_unique<TableHeap>(*bpm, table_meta);
+	auto make_key_tuple = [](int32_t key) {
+		return Tuple({Value(TypeId::INTEGER, key)}, Schema({Column("user_id", TypeId::INTEGER)}));
+	};
+	auto scan_all = [](BTreeIndex &index) {
+		std::vector<RID> rids;
+		index.ScanRange({}, rids);
+		return rids;
+	};
+
+	std::vector<int32_t> keys(row_count);
+	std::iota(keys.begin(), keys.end(), 0);
+	std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+	std::vector<RID> rids_by_key(row_count);
+	for (auto key : keys) {
+		auto tuple = Tuple({Value(TypeId::INTEGER, key), Value(TypeId::VARCHAR, "user" + std::to_string(key))}, schema);
+		auto rid = table_heap->InsertTuple(TupleMeta {false}, tuple);
+		ASSERT_TRUE(rid.has_value());
+		rids_by_key[key] = *rid;
+	}
+	// deleted tuples stay out of the index
+	const int32_t deleted_key = 1234;
+	table_heap->UpdateTupleMeta(TupleMeta {true}, rids_by_key[deleted_key]);
+
+	auto index_oid =
+	    cm->CreateIndex("user_id_index", "user", {schema.GetColumn(0)}, true, IndexType::BPlusTreeIndex, *bpm);
+	ASSERT_TRUE(index_oid.has_value());
+	BTreeIndex built_index(cm->GetIndex(*index_oid), table_meta, *bpm);
+	auto expected = rids_by_key;
+	expected.erase(expected.begin() + deleted_key);
+	ASSERT_EQ(scan_all(built_index), expected);
+	std::vector<RID> rids;
+	ASSERT_FALSE(built_index.ScanKey(make_key_tuple(deleted_key), rids));
+	ASSERT_TRUE(built_index.ScanKey(make_key_tuple(row_count - 1), rids));
+	ASSERT_EQ(rids, std::vector<RID> {rids_by_key[row_count - 1]});
+
+	// an index on a column with repeated values is not created
+	auto same_name = Tuple({Value(TypeId::INTEGER, row_count), Value(TypeId::VARCHAR, std::string("user0"))}, schema);
+	ASSERT_TRUE(table_heap->InsertTuple(TupleMeta {false}, same_name).has_value());
+	ASSERT_THROW(
+	    cm->CreateIndex("user_name_index", "user", {schema.GetColumn(1)}, false, IndexType::BPlusTreeIndex, *bpm),
+	    RuntimeException);
+	ASSERT_THROW(
+	    cm->CreateIndex("user_name_pk", "user", {schema.GetColumn(1)}, true, IndexType::BPlusTreeIndex, *bpm),
+	    RuntimeException);
+
+	auto make_rid = [&table_meta](int32_t key) { return RID({table_meta.table_oid_, key}, key); };
+	const auto &key_layout = built_index.GetKeyLayout();
+	auto make_entries = [&](int32_t entry_count) {
+		std::vector<std::pair<IndexKeyType, RID>> entries;
+		for (int32_t key = 0; key < 2 * entry_count; key += 2) {
+			entries.emplace_back(*key_layout.Encode({Value(TypeId::INTEGER, key)}), make_rid(key));
+		}
+		std::shuffle(entries.begin(), entries.end(), std::mt19937(7));
+		return entries;
+	};
+
+	// packed leaves take a page for every leaf max size - 1 keys, the one internal page above them is the root
+	IndexMeta packed_meta("packed_index", table_meta.table_oid_, schema.GetColumn(0), IndexConstraintType::PRIMARY,
+	                      IndexType::BPlusTreeIndex);
+	BTreeIndex packed_index(packed_meta, table_meta, *bpm);
+	const int32_t packed_count = 20000;
+	auto pages_before = table_meta.GetLastTableDataPageId();
+	packed_index.BulkLoad(make_entries(packed_count), 1.0);
+	const int32_t leaf_max_size = BtreeLeafPage::GetMaxSizeFor(key_layout.GetKeySize());
+	const int32_t leaf_count = (packed_count + leaf_max_size - 2) / (leaf_max_size - 1);
+	ASSERT_EQ(table_meta.GetLastTableDataPageId() - pages_before, leaf_count + 1);
+	ASSERT_EQ(scan_all(packed_index).size(), packed_count);
+	ASSERT_THROW(packed_index.BulkLoad(make_entries(10)), RuntimeException);
+
+	// half full nodes need a third level, which inserts and deletes keep balanced
+	IndexMeta sparse_meta("sparse_index", table_meta.table_oid_, schema.GetColumn(0), IndexConstraintType::PRIMARY,
+	                      IndexType::BPlusTreeIndex);
+	BTreeIndex sparse_index(sparse_meta, table_meta, *bpm);
+	const int32_t sparse_count = 40000;
+	pages_before = table_meta.GetLastTableDataPageId();
+	auto entries = make_entries(sparse_count);
+	// rows with the same key are refused as a whole, whether the index is unique or not
+	auto duplicated_entries = entries;
+	duplicated_entries.emplace_back(*key_layout.Encode({Value(TypeId::INTEGER, 0)}), make_rid(1));
+	ASSERT_THROW(sparse_index.BulkLoad(duplicated_entries, 0.5), RuntimeException);
+	IndexMeta non_unique_meta("non_unique_index", table_meta.table_oid_, schema.GetColumn(0), IndexConstraintType::NONE,
+	                          IndexType::BPlusTreeIndex);
+	BTreeIndex non_unique_index(non_unique_meta, table_meta, *bpm);
+	ASSERT_THROW(non_unique_index.BulkLoad(std::move(duplicated_entries)), RuntimeException);
+	ASSERT_TRUE(scan_all(non_unique_index).empty());
+	sparse_index.BulkLoad(std::move(entries), 0.5);
+	ASSERT_GT(table_meta.GetLastTableDataPageId() - pages_before, 2 * leaf_count);
+	std::vector<RID> remaining;
+	for (int32_t key = 0; key < 2 * sparse_count; key += 2) {
+		remaining.push_back(make_rid(key));
+	}
+	ASSERT_EQ(scan_all(sparse_index), remaining);
+
+	Transaction txn {1, IsolationLevel::READ_UNCOMMITTED};
+	const int32_t changed_count = 2000;
+	for (int32_t key = 1; key < 2 * changed_count; key += 2) {
+		ASSERT_TRUE(sparse_index.InsertRecord(txn, make_key_tuple(key), make_rid(key)));
+	}
+	for (int32_t key = 2 * sparse_count - 2; key >= 2 * (sparse_count - changed_count); key -= 2) {
+		ASSERT_TRUE(sparse_index.DeleteRecord(txn, make_key_tuple(key)));
+	}
+	remaining.resize(sparse_count - changed_count);
+	for (int32_t key = 1; key < 2 * changed_count; key += 2) {
+		remaining.push_back(make_rid(key));
+	}
+	std::ranges::sort(remaining, [](const RID &a, const RID &b) { return a.GetSlotNum() < b.GetSlotNum(); });
+	ASSERT_EQ(scan_all(sparse_index), remaining);
+}
+
+// keys of several columns sort column by column, and long varchar keys that share a prefix stay apart
+TEST(IndexTest, CompositeKeyTest) {
+	DeletePathIfExists(FilePathManager::GetInstance().GetDatabaseRootPath());
+	const size_t buffer_pool_size = 64;
+	const int32_t orders_per_tenant = 300;
+	auto cm = std::make_unique<Catalog>();
+	auto dm = std::make_unique<DiskManager>(*cm);
+	auto bpm = std::make_unique<BufferPool>(buffer_pool_size, *dm);
+
+	auto schema = Schema({Column("tenant_id", TypeId::INTEGER), Column("order_id", TypeId::INTEGER),
+	                      Column("email", TypeId::VARCHAR, 64)});
+	cm->CreateTable("orders", schema);
+	auto &table_meta = cm->GetTableByName("orders");
+	IndexMeta order_meta("order_index", table_meta.table_oid_, {schema.GetColumn(0), schema.GetColumn(1)},
+	                     IndexConstraintType::PRIMARY, IndexType::BPlusTreeIndex);
+	BTreeIndex order_index(order_meta, table_meta, *bpm);
+	IndexMeta email_meta("email_index", table_meta.table_oid_, schema.GetColumn(2), IndexConstraintType::UNIQUE,
+	                     IndexType::BPlusTreeIndex);
+	BTreeIndex email_index(email_meta, table_meta, *bpm);
+	ASSERT_EQ(order_index.GetKeyLayout().GetKeySize(), 8U);
+	ASSERT_EQ(email_index.GetKeyLayout().GetKeySize(), 66U);
+	// keys are checked for their width before there is an index to build
+	ASSERT_EQ(IndexKeyLayout::CheckKeyWidth(schema.GetColumns()), 74U);
+	ASSERT_THROW(IndexKeyLayout::CheckKeyWidth({Column("long", TypeId::VARCHAR, INDEX_MAX_KEY_SIZE)}), RuntimeException);
+	ASSERT_THROW(IndexKeyLayout::CheckKeyWidth({}), RuntimeException);
+
+	// emails longer than the 8 bytes keys used to be cut to, most with a long prefix in common
+	auto make_email = [](int32_t tenant, int32_t order) {
+		return (order % 3 == 0 ? "o" : "order-confirmation-") + std::to_string(order) + "@tenant" +
+		       std::to_string(tenant) + ".example.com";
+	};
+	auto make_tuple = [&](int32_t tenant, int32_t order, const std::string &email) {
+		return Tuple({Value(TypeId::INTEGER, tenant), Value(TypeId::INTEGER, order), Value(TypeId::VARCHAR, email)},
+		             schema);
+	};
+	auto make_rid = [&table_meta](int32_t tenant, int32_t order) {
+		return RID({table_meta.table_oid_, tenant}, static_cast<uint32_t>(order));
+	};
+	auto scan = [](BTreeIndex &index, const IndexRange &range, bool reverse = false) {
+		std::vector<RID> rids;
+		index.ScanRange(range, rids, reverse);
+		return rids;
+	};
+
+	// negative tenants sort before the others
+	std::vector<std::pair<int32_t, int32_t>> orders;
+	for (int32_t tenant = -2; tenant <= 2; tenant++) {
+		for (int32_t order = 0; order < orders_per_tenant; order++) {
+			orders.emplace_back(tenant, order);
+		}
+	}
+	std::shuffle(orders.begin(), orders.end(), std::mt19937(42));
+	Transaction txn {1, IsolationLevel::READ_UNCOMMITTED};
+	std::vector<std::pair<std::string, RID>> emails;
+	for (auto [tenant, order] : orders) {
+		auto tuple = make_tuple(tenant, order, make_email(tenant, order));
+		ASSERT_TRUE(order_index.InsertRecord(txn, tuple, make_rid(tenant, order)));
+		ASSERT_TRUE(email_index.InsertRecord(txn, tuple, make_rid(tenant, order)));
+		emails.emplace_back(make_email(tenant, order), make_rid(tenant, order));
+	}
+	std::ranges::sort(emails, {}, [](const auto &entry) { return entry.first; });
+
+	// the orders of a tenant, and those past an order of it
+	auto expect_orders = [&](int32_t tenant, int32_t first_order) {
+		std::vector<RID> rids;
+		for (int32_t order = first_order; order < orders_per_tenant; order++) {
+			rids.push_back(make_rid(tenant, order));
+		}
+		return rids;
+	};
+	IndexRange tenant_range {{Value(TypeId::INTEGER, 1)}, {Value(TypeId::INTEGER, 1)}};
+	ASSERT_EQ(scan(order_index, tenant_range), expect_orders(1, 0));
+	auto reversed = expect_orders(1, 0);
+	std::ranges::reverse(reversed);
+	ASSERT_EQ(scan(order_index, tenant_range, true), reversed);
+	tenant_range.low_ = {Value(TypeId::INTEGER, 1), Value(TypeId::INTEGER, 99)};
+	tenant_range.low_inclusive_ = false;
+	ASSERT_EQ(scan(order_index, tenant_range), expect_orders(1, 100));
+	IndexRange negative_range {{}, {Value(TypeId::INTEGER, 0)}, true, false};
+	auto negative = expect_orders(-2, 0);
+	std::ranges::copy(expect_orders(-1, 0), std::back_inserter(negative));
+	ASSERT_EQ(scan(order_index, negative_range), negative);
+	IndexRange past_tenant_range {{Value(TypeId::INTEGER, 2)}, {}, false, true};
+	ASSERT_TRUE(scan(order_index, past_tenant_range).empty());
+
+	std::vector<RID> rids;
+	for (const auto &[email, rid] : emails) {
+		rids.clear();
+		ASSERT_TRUE(email_index.ScanKey(make_tuple(0, 0, email), rids));
+		ASSERT_EQ(rids, std::vector<RID> {rid});
+	}
+	std::vector<RID> expected;
+	for (const auto &[email, rid] : emails) {
+		expected.push_back(rid);
+	}
+	ASSERT_EQ(scan(email_index, {}), expected);
+	// a prefix range, and one up to a value longer than the column
+	const std::string prefix_low = "order-confirmation-1";
+	const std::string prefix_high = "order-confirmation-2";
+	const std::string long_bound = prefix_high + std::string(64, 'z');
+	IndexRange prefix_range {{Value(TypeId::VARCHAR, prefix_low)}, {Value(TypeId::VARCHAR, prefix_high)}, true, false};
+	IndexRange long_range {{}, {Value(TypeId::VARCHAR, long_bound)}};
+	for (const auto &[range, low, high] :
+	     {std::tuple {prefix_range, prefix_low, prefix_high}, std::tuple {long_range, std::string(), long_bound}}) {
+		expected.clear();
+		for (const auto &[email, rid] : emails) {
+			if (email >= low && email < high) {
+				expected.push_back(rid);
+			}
+		}
+		ASSERT_FALSE(expected.empty());
+		ASSERT_EQ(scan(email_index, range), expected);
+	}
+
+	// a value longer than its column has no key
+	ASSERT_FALSE(email_index.GetKeyLayout().Encode({Value(TypeId::VARCHAR, std::string(65, 'x'))}).has_value());
+	ASSERT_TRUE(email_index.DeleteRecord(txn, make_tuple(0, 0, emails.front().first)));
+	ASSERT_EQ(scan(email_index, {}).size(), emails.size() - 1);
+}
+
+// binary searches of a leaf compare keys through a std::function, the comparator of any key size and the one of the
+// key size, and lookups down a tree are timed
+TEST(IndexTest, ComparatorBenchmark) {
+	DeletePathIfExists(FilePathManager::GetInstance().GetDatabaseRootPath());
+	const int search_count = 1000000;
+	const int32_t key_count = 20000;
+	const IndexKeyLayout key_layout({Column("id", TypeId::INTEGER)});
+	auto encode = [&key_layout](int32_t key) { return *key_layout.Encode({Value(TypeId::INTEGER, key)}); };
+
+	// a full leaf of the even keys from 0, probed with keys of a wider range so that some are missing
+	std::vector<data_t> leaf_buffer(PAGE_SIZE);
+	auto &leaf = reinterpret_cast<BtreeLeafPage &>(*leaf_buffer.data());
+	leaf.Init(1, INVALID_PAGE_ID, key_layout.GetKeySize());
+	const auto leaf_key_count = static_cast<int32_t>(leaf.GetMaxSize()) - 1;
+	for (int32_t key = 0; key < leaf_key_count; key++) {
+		leaf.Insert(encode(2 * key), RID({0, key}, key));
+	}
+	std::mt19937 gen(42);
+	std::uniform_int_distribution<int32_t> dist(-10, 2 * leaf_key_count + 10);
+	std::vector<IndexKeyType> probes;
+	std::vector<idx_t> expected;
+	for (int i = 0; i < 1024; i++) {
+		auto key = dist(gen);
+		probes.push_back(encode(key));
+		expected.push_back(std::clamp((key + 1) / 2, 0, leaf_key_count));
+	}
+
+	auto time_searches = [&](const char *name, const auto &comparator) {
+		idx_t checksum = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < search_count; i++) {
+			checksum += leaf.FindKeyIndex(probes[i % probes.size()], comparator);
+		}
+		auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		LOG_INFO("{}: {:.0f} leaf searches/s", name, search_count / elapsed);
+		return checksum;
+	};
+	for (size_t i = 0; i < probes.size(); i++) {
+		ASSERT_EQ(leaf.FindKeyIndex(probes[i], KeyComparator<4> {}), expected[i]);
+		ASSERT_EQ(leaf.FindKeyIndex(probes[i]), expected[i]);
+	}
+	const std::function<int(IndexKeyView, IndexKeyView)> function_comparator = KeyComparator<> {};
+	const auto function_checksum = time_searches("std::function", function_comparator);
+	ASSERT_EQ(time_searches("any key size", KeyComparator<> {}), function_checksum);
+	ASSERT_EQ(time_searches("key size 4", KeyComparator<4> {}), function_checksum);
+
+	auto cm = std::make_unique<Catalog>();
+	auto dm = std::make_unique<DiskManager>(*cm);
+	auto bpm = std::make_unique<BufferPool>(256, *dm);
+	auto schema = Schema({Column("id", TypeId::INTEGER)});
+	cm->CreateTable("user", schema);
+	auto &table_meta = cm->GetTableByName("user");
+	IndexMeta index_meta("id_index", table_meta.table_oid_, schema.GetColumn(0), IndexConstraintType::PRIMARY,
+	                     IndexType::BPlusTreeIndex);
+	BTreeIndex index(index_meta, table_meta, *bpm);
+	std::vector<std::pair<IndexKeyType, RID>> entries;
+	for (int32_t key = 0; key < key_count; key++) {
+		entries.emplace_back(encode(key), RID({table_meta.table_oid_, key}, key));
+	}
+	index.BulkLoad(std::move(entries));
+	std::vector<Tuple> tuples;
+	for (int32_t key = 0; key < key_count; key++) {
+		tuples.emplace_back(std::vector<Value> {Value(TypeId::INTEGER, key)}, schema);
+	}
+	std::shuffle(tuples.begin(), tuples.end(), gen);
+	std::vector<RID> rids;
+	rids.reserve(key_count);
+	auto start = std::chrono::steady_clock::now();
+	for (const auto &tuple : tuples) {
+		index.ScanKey(tuple, rids);
+	}
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	LOG_INFO("{:.0f} index lookups/s", key_count / elapsed);
+	ASSERT_EQ(rids.size(), key_count);
+}
 } // namespace db
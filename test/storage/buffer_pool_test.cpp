@@ -0,0 +1,356 @@
+#include "common/fs_utils.hpp"
+#include "common/test_utils.hpp"
+#include "meta/catalog.hpp"
+#include "storage/buffer/buffer_pool.hpp"
+
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace db {
+
+// measures fetch/unpin throughput of resident pages from 1 to 32 threads, with a single latch and with a sharded pool
+TEST(BufferPoolTest, ShardedContentionBenchmark) {
+	DeletePathIfExists(FilePathManager::GetInstance().GetDatabaseRootPath());
+	const frame_id_t buffer_pool_size = 1024;
+	const page_id_t page_count = 512;
+	const int ops_per_thread = 20000;
+
+	auto cm = std::make_unique<Catalog>();
+	auto dm = std::make_unique<DiskManager>(*cm);
+	cm->CreateTable("contention", Schema({Column("id", TypeId::INTEGER)}));
+	auto &table_meta = cm->GetTableByName("contention");
+
+	for (size_t shard_count : {size_t {1}, size_t {BUFFER_POOL_SHARD_COUNT}}) {
+		auto bpm = std::make_unique<BufferPool>(buffer_pool_size, *dm, ReplacerType::LRU_K, LRUK_REPLACER_K,
+		                                        shard_count);
+		LOG_INFO("buffer pool with {} shards", bpm->GetShardCount());
+		auto allocator = TestPageAllocator(table_meta);
+		std::vector<PageId> page_ids;
+		for (page_id_t i = 0; i < page_count; i++) {
+			PageId page_id {table_meta.table_oid_};
+			bpm->NewPage(allocator, page_id);
+			bpm->UnpinPage(page_id, true);
+			page_ids.push_back(page_id);
+		}
+
+		for (int thread_count = 1; thread_count <= 32; thread_count *= 2) {
+			auto start = std::chrono::steady_clock::now();
+			std::vector<std::thread> threads;
+			threads.reserve(thread_count);
+			for (int t = 0; t < thread_count; t++) {
+				threads.emplace_back([&, t]() {
+					std::mt19937 gen(t);
+					std::uniform_int_distribution<size_t> dist(0, page_ids.size() - 1);
+					for (int i = 0; i < ops_per_thread; i++) {
+						auto page_id = page_ids[dist(gen)];
+						auto &page = bpm->FetchPage(page_id);
+						ASSERT_EQ(page.GetPageId(), page_id);
+						bpm->UnpinPage(page_id, false);
+					}
+				});
+			}
+			for (auto &thread : threads) {
+				thread.join();
+			}
+			auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			LOG_INFO("{} shards, {} threads: {:.0f} fetches/s", bpm->GetShardCount(), thread_count,
+			         thread_count * ops_per_thread / elapsed);
+		}
+
+		// every page stayed resident and every pin was released
+		auto stats = bpm->GetStats();
+		ASSERT_EQ(stats.miss_count_, 0);
+		for (const auto &page_id : page_ids) {
+			ASSERT_FALSE(bpm->UnpinPage(page_id, false));
+		}
+	}
+}
+
+// threads keep dirtying pages of a table twice the size of the pool, so misses constantly write back dirty victims
+// outside the latch while other threads fetch the same pages, once through the page cache and once with direct io
+TEST(BufferPoolTest, ConcurrentEvictionTest) {
+	const frame_id_t buffer_pool_size = 64;
+	const page_id_t page_count = 128;
+	const int thread_count = 8;
+	const int ops_per_thread = 4000;
+
+	for (bool direct_io : {false, true}) {
+		DeletePathIfExists(FilePathManager::GetInstance().GetDatabaseRootPath());
+		auto cm = std::make_unique<Catalog>();
+		auto dm = std::make_unique<DiskManager>(*cm, DiskManagerBackend::IO_URING, direct_io);
+		auto bpm = std::make_unique<BufferPool>(buffer_pool_size, *dm);
+		cm->CreateTable("eviction", Schema({Column("id", TypeId::INTEGER)}));
+		auto &table_meta = cm->GetTableByName("eviction");
+		auto allocator = TestPageAllocator(table_meta);
+
+		std::vector<PageId> page_ids;
+		for (page_id_t i = 0; i < page_count; i++) {
+			PageId page_id {table_meta.table_oid_};
+			auto guard = bpm->NewPageGuarded(allocator, page_id);
+			// frames come out of an aligned arena, so direct io never bounces them
+			ASSERT_EQ(reinterpret_cast<uintptr_t>(guard.GetData()) % PAGE_SIZE, 0);
+			guard.AsMut<uint64_t>() = 0;
+			page_ids.push_back(page_id);
+		}
+
+		std::vector<std::atomic<uint64_t>> expected(page_count);
+		std::vector<std::thread> threads;
+		threads.reserve(thread_count);
+		for (int t = 0; t < thread_count; t++) {
+			threads.emplace_back([&, t]() {
+				std::mt19937 gen(t);
+				std::uniform_int_distribution<size_t> dist(0, page_ids.size() - 1);
+				for (int i = 0; i < ops_per_thread; i++) {
+					auto idx = dist(gen);
+					auto guard = bpm->FetchPageWrite(page_ids[idx]);
+					guard.AsMut<uint64_t>()++;
+					expected[idx]++;
+				}
+			});
+		}
+		for (auto &thread : threads) {
+			thread.join();
+		}
+
+		for (page_id_t i = 0; i < page_count; i++) {
+			auto guard = bpm->FetchPageRead(page_ids[i]);
+			ASSERT_EQ(guard.As<uint64_t>(), expected[i].load());
+		}
+
+		// a second pool over the same files only sees what was flushed
+		bpm->FlushAllPages();
+		auto bpm2 = std::make_unique<BufferPool>(buffer_pool_size, *dm);
+		for (page_id_t i = 0; i < page_count; i++) {
+			auto guard = bpm2->FetchPageRead(page_ids[i]);
+			ASSERT_EQ(guard.As<uint64_t>(), expected[i].load());
+		}
+	}
+}
+
+// the background writer cleans unpinned dirty pages on its own, so evicting them later needs no write on the query path
+TEST(BufferPoolTest, BackgroundWriterTest) {
+	DeletePathIfExists(FilePathManager::GetInstance().GetDatabaseRootPath());
+	const frame_id_t buffer_pool_size = 64;
+
+	auto cm = std::make_unique<Catalog>();
+	auto dm = std::make_unique<DiskManager>(*cm);
+	cm->CreateTable("writer", Schema({Column("id", TypeId::INTEGER)}));
+	auto &table_meta = cm->GetTableByName("writer");
+	auto allocator = TestPageAllocator(table_meta);
+	auto bpm = std::make_unique<BufferPool>(buffer_pool_size, *dm);
+
+	std::vector<PageId> page_ids;
+	for (page_id_t i = 0; i < buffer_pool_size; i++) {
+		PageId page_id {table_meta.table_oid_};
+		auto guard = bpm->NewPageGuarded(allocator, page_id);
+		guard.AsMut<page_id_t>() = i;
+		page_ids.push_back(page_id);
+	}
+	// a pinned dirty page is left alone
+	bpm->FetchPage(page_ids[0]);
+
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+	while (bpm->GetDirtyPageCount() > 1 && std::chrono::steady_clock::now() < deadline) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(BACKGROUND_WRITER_INTERVAL_MS));
+	}
+	ASSERT_EQ(bpm->GetDirtyPageCount(), 1);
+	ASSERT_GE(bpm->GetStats().background_write_count_, buffer_pool_size - 1);
+	bpm->UnpinPage(page_ids[0], false);
+	bpm->FlushPage(page_ids[0]);
+
+	// replacing the whole pool only finds clean victims
+	for (page_id_t i = 0; i < buffer_pool_size; i++) {
+		PageId page_id {table_meta.table_oid_};
+		bpm->NewPageGuarded(allocator, page_id);
+	}
+	ASSERT_EQ(bpm->GetStats().dirty_eviction_count_, 0);
+
+	auto bpm2 = std::make_unique<BufferPool>(buffer_pool_size, *dm, ReplacerType::LRU_K, LRUK_REPLACER_K,
+	                                         BUFFER_POOL_SHARD_COUNT, false);
+	for (page_id_t i = 0; i < buffer_pool_size; i++) {
+		auto guard = bpm2->FetchPageRead(page_ids[i]);
+		ASSERT_EQ(guard.As<page_id_t>(), i);
+	}
+}
+
+// a sequential scan is served from prefetched frames while a strided one never triggers read-ahead
+TEST(BufferPoolTest, ReadAheadTest) {
+	DeletePathIfExists(FilePathManager::GetInstance().GetDatabaseRootPath());
+	const frame_id_t buffer_pool_size = 64;
+	const page_id_t page_count = 256;
+
+	auto cm = std::make_unique<Catalog>();
+	auto dm = std::make_unique<DiskManager>(*cm);
+	cm->CreateTable("read_ahead", Schema({Column("id", TypeId::INTEGER)}));
+	auto &table_meta = cm->GetTableByName("read_ahead");
+	auto allocator = TestPageAllocator(table_meta);
+	{
+		auto bpm = std::make_unique<BufferPool>(buffer_pool_size, *dm);
+		for (page_id_t i = 0; i < page_count; i++) {
+			PageId page_id {table_meta.table_oid_};
+			auto guard = bpm->NewPageGuarded(allocator, page_id);
+			guard.AsMut<page_id_t>() = i;
+		}
+		bpm->FlushAllPages();
+	}
+	ASSERT_EQ(dm->GetPageCount(table_meta.table_oid_), page_count);
+
+	auto scan = [&](BufferPool &bpm, page_id_t stride) {
+		for (page_id_t i = 0; i < page_count; i += stride) {
+			auto guard = bpm.FetchPageRead({table_meta.table_oid_, i});
+			ASSERT_EQ(guard.As<page_id_t>(), i);
+			// some work per page gives the prefetcher a chance to run ahead
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+		}
+	};
+
+	auto bpm = std::make_unique<BufferPool>(buffer_pool_size, *dm);
+	scan(*bpm, 1);
+	auto stats = bpm->GetStats();
+	LOG_INFO("sequential scan: misses: {} prefetched: {} prefetch hits: {} wasted: {}", stats.miss_count_,
+	         stats.prefetch_count_, stats.prefetch_hit_count_, stats.prefetch_wasted_count_);
+	ASSERT_GT(stats.prefetch_hit_count_, 0);
+	ASSERT_LT(stats.miss_count_, page_count);
+	// nothing past the end of the file is read
+	ASSERT_LE(stats.prefetch_count_, page_count);
+	ASSERT_EQ(stats.miss_count_ + stats.prefetch_hit_count_, page_count);
+
+	auto strided_bpm = std::make_unique<BufferPool>(buffer_pool_size, *dm);
+	scan(*strided_bpm, 3);
+	// only the first page looks like the start of a scan
+	ASSERT_LE(strided_bpm->GetStats().prefetch_count_, READ_AHEAD_WINDOW);
+
+	auto disabled_bpm = std::make_unique<BufferPool>(buffer_pool_size, *dm);
+	disabled_bpm->SetReadAheadWindow(0);
+	scan(*disabled_bpm, 1);
+	ASSERT_EQ(disabled_bpm->GetStats().prefetch_count_, 0);
+	ASSERT_EQ(disabled_bpm->GetStats().miss_count_, page_count);
+}
+
+// the pool grows and shrinks while threads keep updating pages, no update is lost and a shrunk pool never holds more
+// pages than it has frames
+TEST(BufferPoolTest, ResizeTest) {
+	DeletePathIfExists(FilePathManager::GetInstance().GetDatabaseRootPath());
+	const frame_id_t initial_pool_size = 128;
+	const frame_id_t max_pool_size = 512;
+	const page_id_t page_count = 384;
+	const int thread_count = 4;
+
+	auto cm = std::make_unique<Catalog>();
+	auto dm = std::make_unique<DiskManager>(*cm);
+	auto bpm = std::make_unique<BufferPool>(initial_pool_size, *dm, ReplacerType::LRU_K, LRUK_REPLACER_K,
+	                                        BUFFER_POOL_SHARD_COUNT, true, max_pool_size);
+	cm->CreateTable("resize", Schema({Column("id", TypeId::INTEGER)}));
+	auto &table_meta = cm->GetTableByName("resize");
+	auto allocator = TestPageAllocator(table_meta);
+	ASSERT_THROW(bpm->Resize(max_pool_size + 1), RuntimeException);
+	ASSERT_THROW(bpm->Resize(0), RuntimeException);
+
+	std::vector<PageId> page_ids;
+	for (page_id_t i = 0; i < page_count; i++) {
+		PageId page_id {table_meta.table_oid_};
+		auto guard = bpm->NewPageGuarded(allocator, page_id);
+		guard.AsMut<uint64_t>() = 0;
+		page_ids.push_back(page_id);
+	}
+
+	std::vector<std::atomic<uint64_t>> expected(page_count);
+	std::atomic<bool> stop {false};
+	std::vector<std::thread> threads;
+	threads.reserve(thread_count);
+	for (int t = 0; t < thread_count; t++) {
+		threads.emplace_back([&, t]() {
+			std::mt19937 gen(t);
+			std::uniform_int_distribution<size_t> dist(0, page_ids.size() - 1);
+			while (!stop) {
+				auto idx = dist(gen);
+				auto guard = bpm->FetchPageWrite(page_ids[idx]);
+				guard.AsMut<uint64_t>()++;
+				expected[idx]++;
+			}
+		});
+	}
+	auto count_resident = [&]() {
+		return std::count_if(page_ids.begin(), page_ids.end(), [&](PageId page_id) { return bpm->IsResident(page_id); });
+	};
+	for (frame_id_t pool_size : {512, 64, 256, 32, 512, 128}) {
+		bpm->Resize(pool_size);
+		ASSERT_EQ(bpm->GetPoolSize(), pool_size);
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		ASSERT_LE(count_resident(), pool_size);
+	}
+	stop = true;
+	for (auto &thread : threads) {
+		thread.join();
+	}
+
+	// every page fits once the pool is grown back, so a second pass misses on none of them
+	bpm->Resize(max_pool_size);
+	for (page_id_t i = 0; i < page_count; i++) {
+		auto guard = bpm->FetchPageRead(page_ids[i]);
+		ASSERT_EQ(guard.As<uint64_t>(), expected[i].load());
+	}
+	auto misses = bpm->GetStats().miss_count_;
+	for (page_id_t i = 0; i < page_count; i++) {
+		bpm->FetchPageRead(page_ids[i]);
+	}
+	ASSERT_EQ(bpm->GetStats().miss_count_, misses);
+}
+
+// a page whose latch readers had to wait for is reported as contended, a page only latched without waiting is not
+TEST(BufferPoolTest, LatchContentionTest) {
+	DeletePathIfExists(FilePathManager::GetInstance().GetDatabaseRootPath());
+	auto cm = std::make_unique<Catalog>();
+	auto dm = std::make_unique<DiskManager>(*cm);
+	auto bpm = std::make_unique<BufferPool>(64, *dm);
+	cm->CreateTable("contention", Schema({Column("id", TypeId::INTEGER)}));
+	auto &table_meta = cm->GetTableByName("contention");
+	auto allocator = TestPageAllocator(table_meta);
+	PageId hot_page_id {table_meta.table_oid_};
+	PageId cold_page_id {table_meta.table_oid_};
+	bpm->NewPageGuarded(allocator, hot_page_id);
+	bpm->NewPageGuarded(allocator, cold_page_id);
+	bpm->FetchPageRead(cold_page_id);
+	ASSERT_TRUE(bpm->GetLatchContention(10).empty());
+
+	{
+		auto guard = bpm->FetchPageWrite(hot_page_id);
+		std::thread reader([&]() { bpm->FetchPageRead(hot_page_id); });
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		guard.Drop();
+		reader.join();
+	}
+	auto contention = bpm->GetLatchContention(10);
+	ASSERT_EQ(contention.size(), 1);
+	ASSERT_EQ(contention[0].page_id_, hot_page_id);
+	ASSERT_EQ(contention[0].wait_count_, 1);
+	ASSERT_GE(contention[0].wait_nanos_, 10'000'000);
+}
+TEST(BufferPoolTest, FetchPageIfResidentTest) {
+	DeletePathIfExists(FilePathManager::GetInstance().GetDatabaseRootPath());
+	auto cm = std::make_unique<Catalog>();
+	auto dm = std::make_unique<DiskManager>(*cm);
+	auto bpm = std::make_unique<BufferPool>(16, *dm);
+	cm->CreateTable("resident", Schema({Column("id", TypeId::INTEGER)}));
+	auto allocator = TestPageAllocator(cm->GetTableByName("resident"));
+
+	PageId page_id {cm->GetTableByName("resident").table_oid_};
+	bpm->NewPage(allocator, page_id);
+	bpm->UnpinPage(page_id, true);
+	auto *page = bpm->FetchPageIfResident(page_id);
+	ASSERT_NE(page, nullptr);
+	ASSERT_EQ(page->GetPageId(), page_id);
+	ASSERT_EQ(bpm->GetPinCount(page_id), 1);
+	bpm->UnpinPage(page_id, false);
+
+	// the page was never written out, a deleted page must not be looked for on disk
+	ASSERT_TRUE(bpm->DeletePage(page_id));
+	ASSERT_EQ(bpm->FetchPageIfResident(page_id), nullptr);
+	ASSERT_FALSE(bpm->IsResident(page_id));
+}
+} // namespace db
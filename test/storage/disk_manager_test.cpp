@@ -0,0 +1,259 @@
+#include "common/fs_utils.hpp"
+#include "meta/catalog.hpp"
+#include "storage/buffer/frame_arena.hpp"
+#include "storage/disk_manager.hpp"
+
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <thread>
+#include <vector>
+
+namespace db {
+
+// writes and reads back a table file with both backends, random page reads from 1 to 8 threads are timed
+TEST(DiskManagerTest, BackendBenchmark) {
+	const page_id_t page_count = 1024;
+	const int reads_per_thread = 8000;
+
+	for (auto backend : {DiskManagerBackend::FSTREAM, DiskManagerBackend::PREAD}) {
+		const char *backend_name = backend == DiskManagerBackend::PREAD ? "pread" : "fstream";
+		DeletePathIfExists(FilePathManager::GetInstance().GetDatabaseRootPath());
+		auto cm = std::make_unique<Catalog>();
+		auto dm = std::make_unique<DiskManager>(*cm, backend);
+		cm->CreateTable("disk", Schema({Column("id", TypeId::INTEGER)}));
+		auto table_oid = cm->GetTableByName("disk").table_oid_;
+
+		std::array<char, PAGE_SIZE> page {};
+		auto start = std::chrono::steady_clock::now();
+		for (page_id_t i = 0; i < page_count; i++) {
+			std::memcpy(page.data(), &i, sizeof(i));
+			dm->WritePage({table_oid, i}, page.data());
+		}
+		auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		LOG_INFO("{}: {:.0f} page writes/s", backend_name, page_count / elapsed);
+		ASSERT_EQ(dm->GetPageCount(table_oid), page_count);
+
+		for (int thread_count = 1; thread_count <= 8; thread_count *= 2) {
+			start = std::chrono::steady_clock::now();
+			std::vector<std::thread> threads;
+			threads.reserve(thread_count);
+			for (int t = 0; t < thread_count; t++) {
+				threads.emplace_back([&, t]() {
+					std::mt19937 gen(t);
+					std::uniform_int_distribution<page_id_t> dist(0, page_count - 1);
+					std::array<char, PAGE_SIZE> data {};
+					for (int i = 0; i < reads_per_thread; i++) {
+						auto page_number = dist(gen);
+						dm->ReadPage({table_oid, page_number}, data.data());
+						page_id_t stored;
+						std::memcpy(&stored, data.data(), sizeof(stored));
+						ASSERT_EQ(stored, page_number);
+					}
+				});
+			}
+			for (auto &thread : threads) {
+				thread.join();
+			}
+			elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			LOG_INFO("{}, {} threads: {:.0f} page reads/s", backend_name, thread_count,
+			         thread_count * reads_per_thread / elapsed);
+		}
+
+		// the first read past the end of the file yields an empty page
+		dm->ReadPage({table_oid, page_count}, page.data());
+		ASSERT_TRUE(std::all_of(page.begin(), page.end(), [](char c) { return c == 0; }));
+		ASSERT_THROW(dm->ReadPage({table_oid, page_count + 2}, page.data()), IOException);
+	}
+}
+
+// batches write and read back the same data with and without io_uring, one batch of random reads is timed against
+// reading the same pages one by one
+TEST(DiskManagerTest, SubmitBatchTest) {
+	const page_id_t page_count = 256;
+	// more requests than the ring has entries, so that a batch waits for some to finish before queueing the rest
+	const size_t batch_size = 2 * IO_URING_QUEUE_DEPTH;
+
+	for (auto backend : {DiskManagerBackend::IO_URING, DiskManagerBackend::PREAD}) {
+		DeletePathIfExists(FilePathManager::GetInstance().GetDatabaseRootPath());
+		auto cm = std::make_unique<Catalog>();
+		auto dm = std::make_unique<DiskManager>(*cm, backend);
+		cm->CreateTable("disk", Schema({Column("id", TypeId::INTEGER)}));
+		auto table_oid = cm->GetTableByName("disk").table_oid_;
+		LOG_INFO("backend {}, io_uring active: {}", static_cast<int>(backend), dm->IsIoUringActive());
+		if (backend == DiskManagerBackend::PREAD) {
+			ASSERT_FALSE(dm->IsIoUringActive());
+		}
+
+		std::vector<std::array<char, PAGE_SIZE>> pages(batch_size);
+		size_t completed = 0;
+		for (page_id_t begin = 0; begin < page_count; begin += batch_size) {
+			std::vector<DiskRequest> requests;
+			for (size_t i = 0; i < batch_size; i++) {
+				page_id_t page_number = begin + static_cast<page_id_t>(i);
+				pages[i].fill(static_cast<char>(page_number));
+				std::memcpy(pages[i].data(), &page_number, sizeof(page_number));
+				requests.push_back({true, {table_oid, page_number}, pages[i].data(), [&completed](bool ok) {
+					                    EXPECT_TRUE(ok);
+					                    completed++;
+				                    }});
+			}
+			dm->SubmitBatch(requests);
+		}
+		ASSERT_EQ(completed, page_count);
+		ASSERT_EQ(dm->GetPageCount(table_oid), page_count);
+
+		std::mt19937 gen(0);
+		std::uniform_int_distribution<page_id_t> dist(0, page_count - 1);
+		std::vector<page_id_t> page_numbers(batch_size);
+		std::generate(page_numbers.begin(), page_numbers.end(), [&]() { return dist(gen); });
+		// the last request reads past the end of the file and fails
+		page_numbers.back() = page_count + 2;
+
+		completed = 0;
+		size_t failed = 0;
+		std::vector<DiskRequest> requests;
+		for (size_t i = 0; i < batch_size; i++) {
+			requests.push_back({false, {table_oid, page_numbers[i]}, pages[i].data(), [&, i](bool ok) {
+				                    completed++;
+				                    failed += ok ? 0 : 1;
+				                    if (!ok) {
+					                    return;
+				                    }
+				                    page_id_t stored;
+				                    std::memcpy(&stored, pages[i].data(), sizeof(stored));
+				                    EXPECT_EQ(stored, page_numbers[i]);
+				                    EXPECT_EQ(pages[i].back(), static_cast<char>(page_numbers[i]));
+			                    }});
+		}
+		auto start = std::chrono::steady_clock::now();
+		dm->SubmitBatch(requests);
+		auto batched = std::chrono::steady_clock::now() - start;
+		ASSERT_EQ(completed, batch_size);
+		ASSERT_EQ(failed, 1);
+
+		start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i + 1 < batch_size; i++) {
+			dm->ReadPage({table_oid, page_numbers[i]}, pages[i].data());
+		}
+		auto serial = std::chrono::steady_clock::now() - start;
+		LOG_INFO("batch of {} reads: {} us, one by one: {} us", batch_size,
+		         std::chrono::duration_cast<std::chrono::microseconds>(batched).count(),
+		         std::chrono::duration_cast<std::chrono::microseconds>(serial).count());
+	}
+}
+
+// batches of several threads run side by side: a callback of one batch waits for a request of another batch to finish,
+// which it never would if the batches took turns
+TEST(DiskManagerTest, ConcurrentBatchTest) {
+	DeletePathIfExists(FilePathManager::GetInstance().GetDatabaseRootPath());
+	auto cm = std::make_unique<Catalog>();
+	auto dm = std::make_unique<DiskManager>(*cm);
+	cm->CreateTable("disk", Schema({Column("id", TypeId::INTEGER)}));
+	auto table_oid = cm->GetTableByName("disk").table_oid_;
+
+	std::array<std::array<char, PAGE_SIZE>, 2> pages {};
+	std::atomic<bool> second_done {false};
+	std::atomic<bool> first_started {false};
+	bool waited = false;
+	std::vector<DiskRequest> first {{true, {table_oid, 0}, pages[0].data(), [&](bool ok) {
+		                                 EXPECT_TRUE(ok);
+		                                 first_started = true;
+		                                 auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+		                                 while (!second_done && std::chrono::steady_clock::now() < deadline) {
+			                                 std::this_thread::yield();
+		                                 }
+		                                 waited = second_done;
+	                                 }}};
+	std::vector<DiskRequest> second {{true, {table_oid, 1}, pages[1].data(), [&](bool ok) {
+		                                  EXPECT_TRUE(ok);
+		                                  second_done = true;
+	                                  }}};
+	std::thread first_thread([&]() { dm->SubmitBatch(first); });
+	while (!first_started) {
+		std::this_thread::yield();
+	}
+	dm->SubmitBatch(second);
+	first_thread.join();
+	ASSERT_TRUE(waited);
+	ASSERT_EQ(dm->GetPageCount(table_oid), 2);
+}
+
+namespace {
+// pages of the file held by the kernel page cache
+size_t CountCachedPages(const std::filesystem::path &path, size_t page_count) {
+	int fd = open(path.c_str(), O_RDONLY);
+	void *map = mmap(nullptr, page_count * PAGE_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+	std::vector<unsigned char> residency(page_count * PAGE_SIZE / getpagesize());
+	mincore(map, page_count * PAGE_SIZE, residency.data());
+	munmap(map, page_count * PAGE_SIZE);
+	close(fd);
+	return std::count_if(residency.begin(), residency.end(), [](unsigned char r) { return (r & 1) != 0; });
+}
+} // namespace
+
+// direct io reads back what it wrote through aligned frames, unaligned buffers and batches, and leaves the page cache
+// alone unlike buffered io
+TEST(DiskManagerTest, DirectIoTest) {
+	const page_id_t page_count = 256;
+	FrameArena frames(page_count);
+	for (auto backend : {DiskManagerBackend::IO_URING, DiskManagerBackend::PREAD}) {
+		for (bool direct_io : {false, true}) {
+			DeletePathIfExists(FilePathManager::GetInstance().GetDatabaseRootPath());
+			auto cm = std::make_unique<Catalog>();
+			auto dm = std::make_unique<DiskManager>(*cm, backend, direct_io);
+			cm->CreateTable("disk", Schema({Column("id", TypeId::INTEGER)}));
+			auto table_oid = cm->GetTableByName("disk").table_oid_;
+
+			// the odd pages are written from an unaligned buffer
+			std::vector<char> unaligned(page_count * PAGE_SIZE + 1);
+			auto page_data = [&](page_id_t i) {
+				return i % 2 == 0 ? frames.GetFrame(i) : unaligned.data() + 1 + static_cast<size_t>(i) * PAGE_SIZE;
+			};
+			std::vector<DiskRequest> requests;
+			for (page_id_t i = 0; i < page_count; i++) {
+				char *data = page_data(i);
+				std::memset(data, static_cast<char>(i), PAGE_SIZE);
+				if (i < page_count / 2) {
+					dm->WritePage({table_oid, i}, data);
+				} else {
+					requests.push_back({true, {table_oid, i}, data, [](bool ok) { ASSERT_TRUE(ok); }});
+				}
+			}
+			dm->SubmitBatch(requests);
+			auto cached = CountCachedPages(
+			    FilePathManager::GetInstance().GetTableDataPath("disk"), page_count);
+			LOG_INFO("backend {}, direct io {}: {} of {} pages in the page cache", static_cast<int>(backend), direct_io,
+			         cached, page_count);
+			if (direct_io) {
+				EXPECT_EQ(cached, 0);
+			}
+
+			requests.clear();
+			for (page_id_t i = 0; i < page_count; i++) {
+				char *data = page_data(i);
+				std::memset(data, -1, PAGE_SIZE);
+				if (i < page_count / 2) {
+					dm->ReadPage({table_oid, i}, data);
+					ASSERT_TRUE(std::all_of(data, data + PAGE_SIZE, [i](char c) { return c == static_cast<char>(i); }));
+				} else {
+					requests.push_back({false, {table_oid, i}, data, [i, data](bool ok) {
+						                    ASSERT_TRUE(ok);
+						                    ASSERT_TRUE(std::all_of(data, data + PAGE_SIZE, [i](char c) {
+							                    return c == static_cast<char>(i);
+						                    }));
+					                    }});
+				}
+			}
+			dm->SubmitBatch(requests);
+		}
+	}
+}
+} // namespace db
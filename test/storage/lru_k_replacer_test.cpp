@@ -0,0 +1,96 @@
+#include "common/fs_utils.hpp"
+#include "common/test_utils.hpp"
+#include "meta/catalog.hpp"
+#include "storage/buffer/buffer_pool.hpp"
+#include "storage/buffer/lru_k_replacer.hpp"
+#include "storage/table/table_meta.hpp"
+
+#include "gtest/gtest.h"
+
+namespace db {
+
+TEST(BufferPoolTest, LRUKReplacerTest) {
+	LRUKReplacer replacer(2);
+	frame_id_t frame_id;
+	ASSERT_FALSE(replacer.Evict(frame_id));
+
+	// frame 1 and 2 are accessed twice, frame 3 and 4 only once
+	for (frame_id_t i : {1, 2, 3, 4, 1, 2}) {
+		replacer.Pin(i);
+	}
+	for (frame_id_t i : {1, 2, 3, 4}) {
+		replacer.Unpin(i);
+	}
+
+	// frames with less than k accesses go first, ordered by their first access
+	ASSERT_TRUE(replacer.Evict(frame_id));
+	ASSERT_EQ(frame_id, 3);
+	ASSERT_TRUE(replacer.Evict(frame_id));
+	ASSERT_EQ(frame_id, 4);
+
+	// touch frame 1 again so frame 2 now has the oldest second most recent access
+	replacer.Pin(1);
+	replacer.Unpin(1);
+	ASSERT_TRUE(replacer.Evict(frame_id));
+	ASSERT_EQ(frame_id, 2);
+
+	// pinned frames are never evicted
+	replacer.Pin(1);
+	ASSERT_FALSE(replacer.Evict(frame_id));
+	replacer.Unpin(1);
+
+	replacer.Remove(1);
+	ASSERT_FALSE(replacer.Evict(frame_id));
+}
+
+// mixed workload of point lookups on a small hot set interleaved with a scan over the whole table, returns the number
+// of misses on the hot set
+static uint64_t RunMixedWorkload(ReplacerType replacer_type) {
+	DeletePathIfExists(FilePathManager::GetInstance().GetDatabaseRootPath());
+	const frame_id_t buffer_pool_size = 16;
+	const page_id_t table_page_count = 256;
+	const page_id_t hot_page_count = 12;
+
+	auto cm = std::make_unique<Catalog>();
+	auto dm = std::make_unique<DiskManager>(*cm);
+	// background io would pin frames at random points and blur the comparison of the policies
+	auto bpm = std::make_unique<BufferPool>(buffer_pool_size, *dm, replacer_type, LRUK_REPLACER_K,
+	                                        BUFFER_POOL_SHARD_COUNT, false);
+	bpm->SetReadAheadWindow(0);
+	cm->CreateTable("mixed", Schema({Column("id", TypeId::INTEGER)}));
+	auto &table_meta = cm->GetTableByName("mixed");
+	auto allocator = TestPageAllocator(table_meta);
+
+	for (page_id_t i = 0; i < table_page_count; i++) {
+		PageId page_id {table_meta.table_oid_};
+		bpm->NewPage(allocator, page_id);
+		bpm->UnpinPage(page_id, true);
+	}
+
+	uint64_t hot_misses = 0;
+	for (page_id_t scan_page = 0; scan_page < table_page_count; scan_page++) {
+		auto before = bpm->GetStats();
+		for (page_id_t hot_page = 0; hot_page < hot_page_count; hot_page++) {
+			bpm->FetchPage({table_meta.table_oid_, hot_page});
+			bpm->UnpinPage({table_meta.table_oid_, hot_page}, false);
+		}
+		// the first rounds only warm up the hot set
+		if (scan_page >= 2) {
+			hot_misses += bpm->GetStats().miss_count_ - before.miss_count_;
+		}
+		bpm->FetchPage({table_meta.table_oid_, scan_page});
+		bpm->UnpinPage({table_meta.table_oid_, scan_page}, false);
+	}
+	auto stats = bpm->GetStats();
+	LOG_INFO("hits: {} misses: {} hot set misses: {}", stats.hit_count_, stats.miss_count_, hot_misses);
+	return hot_misses;
+}
+
+TEST(BufferPoolTest, LRUKHitRateTest) {
+	auto random_hot_misses = RunMixedWorkload(ReplacerType::RANDOM_BOGO);
+	auto lru_k_hot_misses = RunMixedWorkload(ReplacerType::LRU_K);
+	ASSERT_LE(lru_k_hot_misses, random_hot_misses);
+	// the scan never pushes the hot set out
+	ASSERT_EQ(lru_k_hot_misses, 0);
+}
+} // namespace db
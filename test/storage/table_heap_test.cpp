@@ -8,6 +8,10 @@
 #include "storage/table/tuple.hpp"
 
 #include "gtest/gtest.h"
+#include <chrono>
+#include <cstring>
+#include <set>
+#include <thread>
 
 namespace db {
 
@@ -102,4 +106,678 @@ TEST(StorageTest, TableHeapManyInsertionTest) {
 		ASSERT_EQ(tuple.ToString(schema), ans[i]);
 	}
 }
+
+// a bulk scan of a table larger than the pool recycles its ring instead of evicting the pages other queries work on
+TEST(StorageTest, TableHeapBufferRingScanTest) {
+	DeletePathIfExists(db::FilePathManager::GetInstance().GetDatabaseRootPath());
+	const size_t buffer_pool_size = 128;
+	const page_id_t hot_page_count = 32;
+	auto cm = std::make_unique<Catalog>();
+	auto dm = std::make_unique<DiskManager>(*cm);
+	// with k = 1 the replacer is plain lru, which a scan pushes the hot set out of unless it runs in a ring. lru-k
+	// keeps pages used twice away from scans by itself
+	auto bpm = std::make_unique<BufferPool>(buffer_pool_size, *dm, ReplacerType::LRU_K, 1);
+
+	auto schema = Schema({Column("user_id", db::TypeId::INTEGER), Column("user_name", db::TypeId::VARCHAR, 256)});
+	cm->CreateTable("user", schema);
+	auto &table_meta = cm->GetTableByName("user");
+	auto table_heap = std::make_unique<TableHeap>(*bpm, table_meta);
+	for (int i = 0; i < 4000; ++i) {
+		auto tuple = Tuple({Value(db::TypeId::INTEGER, i), Value(db::TypeId::VARCHAR, std::string(200, 'a'))}, schema);
+		ASSERT_TRUE(table_heap->InsertTuple(TupleMeta {false}, tuple).has_value());
+	}
+	ASSERT_GT(table_meta.GetLastTableHeapDataPageId(), static_cast<page_id_t>(buffer_pool_size));
+
+	cm->CreateTable("hot", Schema({Column("id", db::TypeId::INTEGER)}));
+	auto &hot_meta = cm->GetTableByName("hot");
+	auto allocator = TestPageAllocator(hot_meta);
+	// the hot pages are the most recently used when the scans start
+	for (page_id_t i = 0; i < hot_page_count; ++i) {
+		PageId page_id {hot_meta.table_oid_};
+		bpm->NewPageGuarded(allocator, page_id);
+	}
+	bpm->FlushAllPages();
+
+	// returns how many pages of the hot set are out of the pool after the scan
+	auto scan = [&](bool bulk_scan) {
+		size_t tuple_count = 0;
+		for (auto it = table_heap->MakeIterator(bulk_scan); !it.IsEnd(); ++it) {
+			EXPECT_TRUE(it.GetTuple().has_value());
+			tuple_count++;
+		}
+		EXPECT_GT(tuple_count, 0);
+		size_t evicted = 0;
+		for (page_id_t i = 0; i < hot_page_count; ++i) {
+			evicted += bpm->IsResident({hot_meta.table_oid_, i}) ? 0 : 1;
+		}
+		return evicted;
+	};
+	auto ring_evicted = scan(true);
+	auto plain_evicted = scan(false);
+	LOG_INFO("hot pages evicted by a ring scan: {} by a plain scan: {}", ring_evicted, plain_evicted);
+	// only the frames the ring takes before it is full come from the main pool
+	BufferRing ring(*bpm);
+	ASSERT_LE(ring_evicted, ring.GetFramesPerShard() * bpm->GetShardCount());
+	ASSERT_LT(ring_evicted, plain_evicted);
+}
+
+// small tuples fill up the room big ones left on earlier pages before the heap grows, and the map survives a restart
+TEST(StorageTest, TableHeapFreeSpaceMapTest) {
+	DeletePathIfExists(db::FilePathManager::GetInstance().GetDatabaseRootPath());
+	const size_t buffer_pool_size = 16;
+	auto schema = Schema({Column("user_id", db::TypeId::INTEGER), Column("user_name", db::TypeId::VARCHAR, 1024)});
+	auto make_tuple = [&](int i, size_t length) {
+		return Tuple({Value(db::TypeId::INTEGER, i), Value(db::TypeId::VARCHAR, std::string(length, 'a'))}, schema);
+	};
+	size_t tuple_count = 0;
+	page_id_t last_page_id;
+	{
+		auto cm = std::make_unique<Catalog>();
+		auto dm = std::make_unique<DiskManager>(*cm);
+		auto bpm = std::make_unique<BufferPool>(buffer_pool_size, *dm);
+		cm->CreateTable("user", schema);
+		auto &table_meta = cm->GetTableByName("user");
+		auto table_heap = std::make_unique<TableHeap>(*bpm, table_meta);
+		auto &fsm = table_heap->GetFreeSpaceMap();
+
+		for (; tuple_count < 400; tuple_count++) {
+			ASSERT_TRUE(table_heap->InsertTuple(TupleMeta {false}, make_tuple(tuple_count, 900)).has_value());
+		}
+		last_page_id = table_meta.GetLastTableHeapDataPageId();
+		// every full page is left with less room than a big tuple needs
+		size_t leftover = 0;
+		for (page_id_t i = table_meta.GetFirstTableHeapDataPageId(); i < last_page_id; i++) {
+			if (i == table_meta.free_space_map_page_id_) {
+				continue;
+			}
+			auto free_space = fsm.GetFreeSpace(i);
+			ASSERT_LT(free_space, make_tuple(0, 900).GetStorageSize());
+			leftover += free_space;
+		}
+		ASSERT_GT(leftover, 0);
+
+		// tuples that fit into the leftover space go to the earlier pages
+		auto small_tuple = make_tuple(0, 10);
+		std::set<page_id_t> pages;
+		for (size_t used = 0; used + 2 * (small_tuple.GetStorageSize() + FSM_CATEGORY_SIZE) < leftover; tuple_count++) {
+			auto rid = table_heap->InsertTuple(TupleMeta {false}, small_tuple);
+			ASSERT_TRUE(rid.has_value());
+			pages.insert(rid->GetPageId().page_number_);
+			used += small_tuple.GetStorageSize() + FSM_CATEGORY_SIZE;
+		}
+		LOG_INFO("small tuples went to {} pages, the heap ends at page {}", pages.size(), last_page_id);
+		ASSERT_EQ(table_meta.GetLastTableHeapDataPageId(), last_page_id);
+		ASSERT_GT(pages.size(), 1);
+		bpm->FlushAllPages();
+		cm->PersistToDisk();
+	}
+
+	auto cm = std::make_unique<Catalog>();
+	auto dm = std::make_unique<DiskManager>(*cm);
+	auto bpm = std::make_unique<BufferPool>(buffer_pool_size, *dm);
+	auto &table_meta = cm->GetTableByName("user");
+	ASSERT_NE(table_meta.free_space_map_page_id_, INVALID_PAGE_ID);
+	auto table_heap = std::make_unique<TableHeap>(*bpm, table_meta);
+	// the first page is scanned as well, and the map page is not
+	size_t scanned = 0;
+	for (auto it = table_heap->MakeIterator(); !it.IsEnd(); ++it) {
+		ASSERT_TRUE(it.GetTuple().has_value());
+		scanned++;
+	}
+	ASSERT_EQ(scanned, tuple_count);
+	// the earlier pages are full, so another big tuple extends the heap
+	auto rid = table_heap->InsertTuple(TupleMeta {false}, make_tuple(0, 900));
+	ASSERT_TRUE(rid.has_value());
+	ASSERT_GT(rid->GetPageId().page_number_, last_page_id);
+}
+
+// concurrent inserters each end up with pages of their own instead of all waiting for the last one
+TEST(StorageTest, TableHeapConcurrentInsertTest) {
+	DeletePathIfExists(db::FilePathManager::GetInstance().GetDatabaseRootPath());
+	const size_t buffer_pool_size = 64;
+	const int thread_count = 4;
+	const int tuples_per_thread = 2000;
+	auto cm = std::make_unique<Catalog>();
+	auto dm = std::make_unique<DiskManager>(*cm);
+	auto bpm = std::make_unique<BufferPool>(buffer_pool_size, *dm);
+	auto schema = Schema({Column("user_id", db::TypeId::INTEGER), Column("user_name", db::TypeId::VARCHAR, 256)});
+	cm->CreateTable("user", schema);
+	auto &table_meta = cm->GetTableByName("user");
+	auto table_heap = std::make_unique<TableHeap>(*bpm, table_meta);
+
+	std::vector<std::vector<RID>> rids(thread_count);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < thread_count; t++) {
+		threads.emplace_back([&, t]() {
+			for (int i = 0; i < tuples_per_thread; i++) {
+				auto tuple = Tuple({Value(db::TypeId::INTEGER, t * tuples_per_thread + i),
+				                    Value(db::TypeId::VARCHAR, std::string(100, 'a'))},
+				                   schema);
+				auto rid = table_heap->InsertTuple(TupleMeta {false}, tuple);
+				ASSERT_TRUE(rid.has_value());
+				rids[t].push_back(*rid);
+			}
+		});
+	}
+	for (auto &thread : threads) {
+		thread.join();
+	}
+
+	// page number and slot of every tuple
+	std::set<std::pair<page_id_t, uint32_t>> all_rids;
+	size_t shared_pages = 0;
+	for (int t = 0; t < thread_count; t++) {
+		std::set<page_id_t> pages;
+		for (int i = 0; i < tuples_per_thread; i++) {
+			auto &rid = rids[t][i];
+			all_rids.emplace(rid.GetPageId().page_number_, rid.GetSlotNum());
+			pages.insert(rid.GetPageId().page_number_);
+			auto ret = table_heap->GetTuple(rid);
+			ASSERT_TRUE(ret.has_value());
+			ASSERT_EQ(ret->second.GetValue(schema, 0).GetAs<int32_t>(), t * tuples_per_thread + i);
+		}
+		for (int other = 0; other < t; other++) {
+			for (auto &rid : rids[other]) {
+				shared_pages += pages.contains(rid.GetPageId().page_number_) ? 1 : 0;
+			}
+		}
+	}
+	LOG_INFO("tuples on pages another thread inserted into as well: {} of {}", shared_pages,
+	         thread_count * tuples_per_thread);
+	ASSERT_EQ(all_rids.size(), thread_count * tuples_per_thread);
+	ASSERT_EQ(table_meta.tuple_count_, thread_count * tuples_per_thread);
+
+	size_t scanned = 0;
+	for (auto it = table_heap->MakeIterator(); !it.IsEnd(); ++it) {
+		ASSERT_TRUE(all_rids.contains({it.GetRID().GetPageId().page_number_, it.GetRID().GetSlotNum()}));
+		scanned++;
+	}
+	ASSERT_EQ(scanned, all_rids.size());
+}
+
+// bulk inserts fill fresh pages linked behind the heap, small batches fill up existing pages instead, and both are timed
+// against inserting one by one
+TEST(StorageTest, TableHeapBulkInsertTest) {
+	DeletePathIfExists(db::FilePathManager::GetInstance().GetDatabaseRootPath());
+	const size_t buffer_pool_size = 64;
+	const int tuple_count = 50000;
+	auto cm = std::make_unique<Catalog>();
+	auto dm = std::make_unique<DiskManager>(*cm);
+	auto bpm = std::make_unique<BufferPool>(buffer_pool_size, *dm);
+	auto schema = Schema({Column("user_id", db::TypeId::INTEGER), Column("user_name", db::TypeId::VARCHAR, 256)});
+	cm->CreateTable("bulk", schema);
+	cm->CreateTable("single", schema);
+	auto make_tuple = [&](int i) {
+		return Tuple({Value(db::TypeId::INTEGER, i), Value(db::TypeId::VARCHAR, std::string(50 + i % 50, 'a'))}, schema);
+	};
+	std::vector<Tuple> tuples;
+	for (int i = 0; i < tuple_count; i++) {
+		tuples.push_back(make_tuple(i));
+	}
+
+	auto &single_meta = cm->GetTableByName("single");
+	auto single_heap = std::make_unique<TableHeap>(*bpm, single_meta);
+	auto start = std::chrono::steady_clock::now();
+	for (const auto &tuple : tuples) {
+		ASSERT_TRUE(single_heap->InsertTuple(TupleMeta {false}, tuple).has_value());
+	}
+	auto single_elapsed = std::chrono::steady_clock::now() - start;
+
+	auto &bulk_meta = cm->GetTableByName("bulk");
+	auto bulk_heap = std::make_unique<TableHeap>(*bpm, bulk_meta);
+	// a batch smaller than a page goes to the first page like single inserts do
+	auto rids = bulk_heap->BulkInsertTuples(TupleMeta {false}, {tuples[0], tuples[1]});
+	ASSERT_EQ(rids.size(), 2);
+	ASSERT_EQ(rids[1].GetPageId().page_number_, bulk_meta.GetFirstTableHeapDataPageId());
+	start = std::chrono::steady_clock::now();
+	for (size_t begin = 2; begin < tuples.size(); begin += BULK_INSERT_BATCH_SIZE) {
+		auto end = std::min(tuples.size(), begin + BULK_INSERT_BATCH_SIZE);
+		auto batch_rids = bulk_heap->BulkInsertTuples(TupleMeta {false}, {tuples.begin() + begin, tuples.begin() + end});
+		ASSERT_EQ(batch_rids.size(), end - begin);
+		rids.insert(rids.end(), batch_rids.begin(), batch_rids.end());
+	}
+	auto bulk_elapsed = std::chrono::steady_clock::now() - start;
+	LOG_INFO("{} tuples inserted one by one in {} ms, in batches of {} in {} ms", tuple_count,
+	         std::chrono::duration_cast<std::chrono::milliseconds>(single_elapsed).count(), BULK_INSERT_BATCH_SIZE,
+	         std::chrono::duration_cast<std::chrono::milliseconds>(bulk_elapsed).count());
+	ASSERT_EQ(bulk_meta.tuple_count_, tuple_count);
+	ASSERT_EQ(single_meta.tuple_count_, tuple_count);
+
+	for (int i = 0; i < tuple_count; i++) {
+		auto ret = bulk_heap->GetTuple(rids[i]);
+		ASSERT_TRUE(ret.has_value());
+		ASSERT_EQ(ret->second.ToString(schema), tuples[i].ToString(schema));
+	}
+	// the scan sees the tuples in the order they were inserted
+	int scanned = 0;
+	for (auto it = bulk_heap->MakeIterator(); !it.IsEnd(); ++it) {
+		ASSERT_TRUE(it.GetRID() == rids[scanned]);
+		scanned++;
+	}
+	ASSERT_EQ(scanned, tuple_count);
+	// the room left on the last page is used by the next insert
+	auto rid = bulk_heap->InsertTuple(TupleMeta {false}, tuples[0]);
+	ASSERT_TRUE(rid.has_value());
+	ASSERT_EQ(rid->GetPageId().page_number_, bulk_meta.GetLastTableHeapDataPageId());
+}
+
+// a scan over views reads the same tuples as one copying them out, without a page lookup per tuple
+TEST(StorageTest, TableHeapTupleViewScanTest) {
+	DeletePathIfExists(db::FilePathManager::GetInstance().GetDatabaseRootPath());
+	const size_t buffer_pool_size = 64;
+	const int tuple_count = 20000;
+	auto cm = std::make_unique<Catalog>();
+	auto dm = std::make_unique<DiskManager>(*cm);
+	auto bpm = std::make_unique<BufferPool>(buffer_pool_size, *dm);
+	auto schema = Schema({Column("user_id", db::TypeId::INTEGER), Column("user_name", db::TypeId::VARCHAR, 256)});
+	cm->CreateTable("user", schema);
+	auto &table_meta = cm->GetTableByName("user");
+	auto table_heap = std::make_unique<TableHeap>(*bpm, table_meta);
+	std::vector<Tuple> tuples;
+	for (int i = 0; i < tuple_count; i++) {
+		tuples.push_back(
+		    Tuple({Value(db::TypeId::INTEGER, i), Value(db::TypeId::VARCHAR, std::string(i % 64, 'a'))}, schema));
+	}
+	ASSERT_EQ(table_heap->BulkInsertTuples(TupleMeta {false}, tuples).size(), tuple_count);
+
+	auto start = std::chrono::steady_clock::now();
+	int64_t copy_sum = 0;
+	for (auto it = table_heap->MakeIterator(); !it.IsEnd(); ++it) {
+		copy_sum += it.GetTuple()->second.GetValue(schema, 0).GetAs<int32_t>();
+	}
+	auto copy_elapsed = std::chrono::steady_clock::now() - start;
+
+	start = std::chrono::steady_clock::now();
+	int64_t view_sum = 0;
+	int scanned = 0;
+	for (auto it = table_heap->MakeIterator(); !it.IsEnd(); ++it) {
+		auto [meta, view] = *it.GetTupleView();
+		ASSERT_FALSE(meta.is_deleted_);
+		ASSERT_TRUE(view.GetRid() == it.GetRID());
+		ASSERT_EQ(view.GetStorageSize(), tuples[scanned].GetStorageSize());
+		view_sum += view.GetValue(schema, 0).GetAs<int32_t>();
+		scanned++;
+	}
+	auto view_elapsed = std::chrono::steady_clock::now() - start;
+	LOG_INFO("scan of {} tuples copying them out: {} ms, reading them in place: {} ms", tuple_count,
+	         std::chrono::duration_cast<std::chrono::milliseconds>(copy_elapsed).count(),
+	         std::chrono::duration_cast<std::chrono::milliseconds>(view_elapsed).count());
+	ASSERT_EQ(scanned, tuple_count);
+	ASSERT_EQ(view_sum, copy_sum);
+	ASSERT_EQ(view_sum, static_cast<int64_t>(tuple_count) * (tuple_count - 1) / 2);
+}
+
+// a batch scan hands out the tuples not deleted one page at a time, looking up every page only once
+TEST(StorageTest, TableHeapBatchScanTest) {
+	DeletePathIfExists(db::FilePathManager::GetInstance().GetDatabaseRootPath());
+	const size_t buffer_pool_size = 64;
+	const int tuple_count = 5000;
+	auto cm = std::make_unique<Catalog>();
+	auto dm = std::make_unique<DiskManager>(*cm);
+	auto bpm = std::make_unique<BufferPool>(buffer_pool_size, *dm);
+	auto schema = Schema({Column("user_id", db::TypeId::INTEGER), Column("user_name", db::TypeId::VARCHAR, 256)});
+	cm->CreateTable("user", schema);
+	auto &table_meta = cm->GetTableByName("user");
+	auto table_heap = std::make_unique<TableHeap>(*bpm, table_meta);
+	std::vector<Tuple> tuples;
+	for (int i = 0; i < tuple_count; i++) {
+		tuples.push_back(
+		    Tuple({Value(db::TypeId::INTEGER, i), Value(db::TypeId::VARCHAR, std::string(50, 'a'))}, schema));
+	}
+	auto rids = table_heap->BulkInsertTuples(TupleMeta {false}, tuples);
+	for (int i = 0; i < tuple_count; i += 3) {
+		table_heap->UpdateTupleMeta(TupleMeta {true}, rids[i]);
+	}
+
+	auto it = table_heap->MakeIterator();
+	auto before = bpm->GetStats();
+	std::set<page_id_t> pages;
+	int next_id = 1;
+	for (auto batch = it.NextBatch(); !batch.empty(); batch = it.NextBatch()) {
+		auto page_number = batch.front().GetRid().GetPageId().page_number_;
+		ASSERT_TRUE(pages.insert(page_number).second);
+		for (const auto &view : batch) {
+			ASSERT_EQ(view.GetRid().GetPageId().page_number_, page_number);
+			ASSERT_EQ(view.GetValue(schema, 0).GetAs<int32_t>(), next_id);
+			next_id += next_id % 3 == 2 ? 2 : 1;
+		}
+	}
+	auto after = bpm->GetStats();
+	ASSERT_TRUE(it.IsEnd());
+	ASSERT_EQ(next_id, tuple_count);
+	ASSERT_EQ(after.hit_count_ + after.miss_count_ - before.hit_count_ - before.miss_count_, pages.size());
+
+	// the last batch of a scan stays pinned until the iterator is used again, a vacuum must not move its tuples
+	cm->CreateTable("small", schema);
+	auto small_heap = std::make_unique<TableHeap>(*bpm, cm->GetTableByName("small"));
+	auto small_rids =
+	    small_heap->BulkInsertTuples(TupleMeta {false}, std::vector<Tuple>(tuples.begin(), tuples.begin() + 10));
+	for (int i = 0; i < 10; i += 2) {
+		small_heap->UpdateTupleMeta(TupleMeta {true}, small_rids[i]);
+	}
+	auto small_it = small_heap->MakeIterator();
+	auto batch = small_it.NextBatch();
+	ASSERT_TRUE(small_it.IsEnd());
+	auto stats = small_heap->Vacuum();
+	ASSERT_EQ(stats.pages_compacted_, 0);
+	ASSERT_EQ(stats.pages_skipped_, 1);
+	ASSERT_EQ(batch.size(), 5);
+	for (int i = 0; i < 5; i++) {
+		ASSERT_EQ(batch[i].GetValue(schema, 0).GetAs<int32_t>(), 2 * i + 1);
+	}
+	ASSERT_TRUE(small_it.NextBatch().empty());
+	ASSERT_EQ(small_heap->Vacuum().pages_compacted_, 1);
+}
+
+// a vacuum compacts the pages with deleted tuples without moving the rest to other slots, and inserts fill the space
+TEST(StorageTest, TableHeapVacuumTest) {
+	DeletePathIfExists(db::FilePathManager::GetInstance().GetDatabaseRootPath());
+	const size_t buffer_pool_size = 64;
+	const int tuple_count = 5000;
+	auto cm = std::make_unique<Catalog>();
+	auto dm = std::make_unique<DiskManager>(*cm);
+	// no background writer, whose pins would make the vacuum skip pages
+	auto bpm = std::make_unique<BufferPool>(buffer_pool_size, *dm, ReplacerType::LRU_K, LRUK_REPLACER_K,
+	                                        BUFFER_POOL_SHARD_COUNT, false);
+	auto schema = Schema({Column("user_id", db::TypeId::INTEGER), Column("user_name", db::TypeId::VARCHAR, 256)});
+	cm->CreateTable("user", schema);
+	auto &table_meta = cm->GetTableByName("user");
+	auto table_heap = std::make_unique<TableHeap>(*bpm, table_meta);
+	std::vector<Tuple> tuples;
+	for (int i = 0; i < tuple_count; i++) {
+		tuples.push_back(
+		    Tuple({Value(db::TypeId::INTEGER, i), Value(db::TypeId::VARCHAR, std::string(50, 'a'))}, schema));
+	}
+	auto rids = table_heap->BulkInsertTuples(TupleMeta {false}, tuples);
+	// tuples deleted and restored again do not count as deleted
+	for (const auto &rid : rids) {
+		table_heap->UpdateTupleMeta(TupleMeta {true}, rid);
+		table_heap->UpdateTupleMeta(TupleMeta {false}, rid);
+	}
+	ASSERT_EQ(table_heap->Vacuum().pages_compacted_, 0);
+	uint64_t deleted_bytes = 0;
+	for (int i = 0; i < tuple_count; i += 2) {
+		table_heap->UpdateTupleMeta(TupleMeta {true}, rids[i]);
+		deleted_bytes += tuples[i].GetStorageSize();
+	}
+	auto last_page_id = table_meta.GetLastTableHeapDataPageId();
+
+	VacuumStats stats;
+	{
+		// the page a scan is on is left alone
+		auto it = table_heap->MakeIterator();
+		auto batch = it.NextBatch();
+		ASSERT_FALSE(batch.empty());
+		stats = table_heap->Vacuum();
+		ASSERT_EQ(stats.pages_skipped_, 1);
+		ASSERT_EQ(batch.front().GetValue(schema, 0).GetAs<int32_t>(), 1);
+	}
+	auto second_stats = table_heap->Vacuum();
+	ASSERT_EQ(second_stats.pages_compacted_, 1);
+	ASSERT_EQ(second_stats.pages_skipped_, 0);
+	ASSERT_EQ(stats.bytes_reclaimed_ + second_stats.bytes_reclaimed_, deleted_bytes);
+	ASSERT_EQ(table_heap->Vacuum().pages_compacted_, 0);
+
+	for (int i = 0; i < tuple_count; i++) {
+		auto [meta, tuple] = *table_heap->GetTuple(rids[i]);
+		ASSERT_EQ(meta.is_deleted_, i % 2 == 0);
+		if (i % 2 == 1) {
+			ASSERT_EQ(tuple.GetValue(schema, 0).GetAs<int32_t>(), i);
+		}
+	}
+	ASSERT_THROW(table_heap->UpdateTupleMeta(TupleMeta {false}, rids[0]), Exception);
+
+	// the reclaimed space takes the new tuples instead of new pages
+	for (int i = 0; i < tuple_count / 4; i++) {
+		ASSERT_TRUE(table_heap->InsertTuple(TupleMeta {false}, tuples[i]).has_value());
+	}
+	ASSERT_EQ(table_meta.GetLastTableHeapDataPageId(), last_page_id);
+	for (int i = 1; i < tuple_count; i += 2) {
+		ASSERT_EQ(table_heap->GetTuple(rids[i])->second.GetValue(schema, 0).GetAs<int32_t>(), i);
+	}
+}
+
+// wide values go to overflow pages, which a scan only reads for the columns it reads
+TEST(StorageTest, TableHeapOverflowTest) {
+	DeletePathIfExists(db::FilePathManager::GetInstance().GetDatabaseRootPath());
+	const size_t buffer_pool_size = 64;
+	const int tuple_count = 100;
+	auto cm = std::make_unique<Catalog>();
+	auto dm = std::make_unique<DiskManager>(*cm);
+	auto bpm = std::make_unique<BufferPool>(buffer_pool_size, *dm);
+	auto schema = Schema({Column("user_id", db::TypeId::INTEGER), Column("bio", db::TypeId::VARCHAR, 20000),
+	                      Column("user_name", db::TypeId::VARCHAR, 64)});
+	cm->CreateTable("user", schema);
+	auto &table_meta = cm->GetTableByName("user");
+	auto table_heap = std::make_unique<TableHeap>(*bpm, table_meta);
+	auto bio = [](int i) { return std::string(2000 + i * 100, static_cast<char>('a' + i % 26)); };
+	std::vector<Tuple> tuples;
+	std::vector<RID> rids;
+	for (int i = 0; i < tuple_count; i++) {
+		tuples.push_back(Tuple({Value(db::TypeId::INTEGER, i), Value(db::TypeId::VARCHAR, bio(i)),
+		                        Value(db::TypeId::VARCHAR, std::to_string(i))},
+		                       schema));
+		ASSERT_GT(tuples.back().GetStorageSize(), TUPLE_OVERFLOW_THRESHOLD);
+		if (i < tuple_count / 2) {
+			rids.push_back(*table_heap->InsertTuple(TupleMeta {false}, tuples.back()));
+		}
+	}
+	auto bulk_rids = table_heap->BulkInsertTuples(
+	    TupleMeta {false}, std::vector<Tuple>(tuples.begin() + tuple_count / 2, tuples.end()));
+	rids.insert(rids.end(), bulk_rids.begin(), bulk_rids.end());
+
+	for (int i = 0; i < tuple_count; i++) {
+		auto [meta, tuple] = *table_heap->GetTuple(rids[i]);
+		ASSERT_LE(tuple.GetStorageSize(), TUPLE_OVERFLOW_THRESHOLD);
+		ASSERT_TRUE(TupleView(tuple).IsOverflowed(schema.GetColumn(1)));
+		ASSERT_EQ(tuple.GetValue(schema, 1).GetAs<std::string>(), bio(i));
+		ASSERT_EQ(tuple.GetValue(schema, 2).GetAs<std::string>(), std::to_string(i));
+	}
+
+	// the narrow columns are read without touching the overflow pages
+	std::set<page_id_t> pages;
+	BufferPoolStats before;
+	{
+		auto it = table_heap->MakeIterator();
+		before = bpm->GetStats();
+		int i = 0;
+		for (auto batch = it.NextBatch(); !batch.empty(); batch = it.NextBatch()) {
+			pages.insert(batch.front().GetRid().GetPageId().page_number_);
+			for (const auto &view : batch) {
+				ASSERT_EQ(view.GetValue(schema, 0).GetAs<int32_t>(), i);
+				ASSERT_EQ(view.GetValue(schema, 2).GetAs<std::string>(), std::to_string(i));
+				i++;
+			}
+		}
+		ASSERT_EQ(i, tuple_count);
+	}
+	auto after = bpm->GetStats();
+	ASSERT_EQ(after.hit_count_ + after.miss_count_ - before.hit_count_ - before.miss_count_, pages.size());
+
+	auto it = table_heap->MakeIterator();
+	for (int i = 0; !it.IsEnd(); ++it, i++) {
+		ASSERT_EQ(it.GetTuple()->second.GetValue(schema, 1).GetAs<std::string>(), bio(i));
+	}
+}
+
+// a scan with a range skips the pages whose zone rules it out, without reading them
+TEST(StorageTest, TableHeapZoneMapTest) {
+	DeletePathIfExists(db::FilePathManager::GetInstance().GetDatabaseRootPath());
+	const size_t buffer_pool_size = 64;
+	const int tuple_count = 20000;
+	auto cm = std::make_unique<Catalog>();
+	auto dm = std::make_unique<DiskManager>(*cm);
+	auto bpm = std::make_unique<BufferPool>(buffer_pool_size, *dm);
+	auto schema = Schema({Column("ts", db::TypeId::INTEGER), Column("payload", db::TypeId::VARCHAR, 256)});
+	cm->CreateTable("metrics", schema);
+	auto &table_meta = cm->GetTableByName("metrics");
+	auto table_heap = std::make_unique<TableHeap>(*bpm, table_meta);
+	// half of the series goes through single inserts, the other half through bulk inserts
+	std::vector<Tuple> tuples;
+	for (int i = 0; i < tuple_count; i++) {
+		tuples.push_back(
+		    Tuple({Value(db::TypeId::INTEGER, i), Value(db::TypeId::VARCHAR, std::string(50, 'a'))}, schema));
+		if (i < tuple_count / 2) {
+			ASSERT_TRUE(table_heap->InsertTuple(TupleMeta {false}, tuples.back()).has_value());
+		}
+	}
+	auto rids = table_heap->BulkInsertTuples(TupleMeta {false},
+	                                         std::vector<Tuple>(tuples.begin() + tuple_count / 2, tuples.end()));
+
+	auto scan = [&](std::vector<ZoneRange> ranges, int min, int max) {
+		auto it = table_heap->MakeIterator(false, std::move(ranges));
+		std::set<page_id_t> pages;
+		int matches = 0;
+		for (auto batch = it.NextBatch(); !batch.empty(); batch = it.NextBatch()) {
+			pages.insert(batch.front().GetRid().GetPageId().page_number_);
+			for (const auto &view : batch) {
+				auto ts = view.GetValue(schema, 0).GetAs<int32_t>();
+				matches += ts >= min && ts <= max ? 1 : 0;
+			}
+		}
+		EXPECT_EQ(matches, max - min + 1);
+		return std::make_pair(pages.size(), it.GetSkippedPageCount());
+	};
+	auto [all_pages, no_skipped] = scan({}, 0, tuple_count - 1);
+	ASSERT_EQ(no_skipped, 0);
+	// ranges in the single and in the bulk inserted part, and one across both
+	for (auto [min, max] : {std::pair {1000, 1099}, std::pair {15000, 15009}, std::pair {9990, 10010}}) {
+		auto [read_pages, skipped_pages] = scan({ZoneRange {0, min, max}}, min, max);
+		ASSERT_LE(read_pages, 3);
+		ASSERT_EQ(read_pages + skipped_pages, all_pages);
+	}
+	// a conjunction only reads the pages all of its ranges allow
+	auto [read_pages, skipped_pages] = scan({ZoneRange {0, 100, 5000}, ZoneRange {0, 4990, 20000}}, 4990, 5000);
+	ASSERT_LE(read_pages, 2);
+	// the zones of the heap pages span several map pages, looking a zone up does not walk their chain
+	auto before = bpm->GetStats();
+	auto range_pages = scan({ZoneRange {0, 15000, 15009}}, 15000, 15009).first;
+	auto after = bpm->GetStats();
+	// a map page per page of the heap, the heap pages read and a few to set up the scan, walking the chain for every
+	// zone would take one more for each heap page past the first map page
+	ASSERT_LE(after.hit_count_ + after.miss_count_ - before.hit_count_ - before.miss_count_,
+	          all_pages + range_pages + 4);
+	// zones are only widened, the page of a deleted tuple is still read
+	table_heap->UpdateTupleMeta(TupleMeta {true}, rids.back());
+	ASSERT_EQ(scan({ZoneRange {0, tuple_count - 1, tuple_count - 1}}, 0, -1).first, 1);
+
+	// a zone only has room for the bounds of the first columns of a wide schema, ranges on the others skip nothing
+	std::vector<Column> wide_columns;
+	std::vector<Value> wide_values;
+	for (int i = 0; i < 300; i++) {
+		wide_columns.emplace_back("c" + std::to_string(i), db::TypeId::INTEGER);
+		wide_values.emplace_back(db::TypeId::INTEGER, i);
+	}
+	auto wide_schema = Schema(wide_columns);
+	cm->CreateTable("wide", wide_schema);
+	auto wide_heap = std::make_unique<TableHeap>(*bpm, cm->GetTableByName("wide"));
+	for (int i = 0; i < 10; i++) {
+		ASSERT_TRUE(wide_heap->InsertTuple(TupleMeta {false}, Tuple(wide_values, wide_schema)).has_value());
+	}
+	for (uint32_t column_idx : {0U, 299U}) {
+		auto it = wide_heap->MakeIterator(false, {ZoneRange {column_idx, -10, -1}});
+		size_t scanned = 0;
+		for (auto batch = it.NextBatch(); !batch.empty(); batch = it.NextBatch()) {
+			scanned += batch.size();
+		}
+		ASSERT_EQ(scanned, column_idx == 0 ? 0 : 10);
+	}
+}
+
+TEST(StorageTest, TableHeapPaxTest) {
+	DeletePathIfExists(db::FilePathManager::GetInstance().GetDatabaseRootPath());
+	const size_t buffer_pool_size = 64;
+	const int tuple_count = 5000;
+	auto cm = std::make_unique<Catalog>();
+	auto dm = std::make_unique<DiskManager>(*cm);
+	auto bpm = std::make_unique<BufferPool>(buffer_pool_size, *dm);
+	auto schema = Schema({Column("id", db::TypeId::INTEGER), Column("name", db::TypeId::VARCHAR, 4096),
+	                      Column("active", db::TypeId::BOOLEAN), Column("amount", db::TypeId::INTEGER),
+	                      Column("created", db::TypeId::TIMESTAMP)});
+	cm->CreateTable("orders", schema, PageLayout::Pax);
+	auto &table_meta = cm->GetTableByName("orders");
+	// a schema whose tuples would not fit a page is refused instead of getting a layout without room for any
+	std::vector<Column> wide_columns;
+	for (int i = 0; i < 600; i++) {
+		wide_columns.emplace_back("c" + std::to_string(i), db::TypeId::INTEGER);
+	}
+	ASSERT_THROW(cm->CreateTable("wide", Schema(wide_columns), PageLayout::Pax), RuntimeException);
+	ASSERT_TRUE(cm->CreateTable("wide", Schema(wide_columns), PageLayout::Row).has_value());
+	auto table_heap = std::make_unique<TableHeap>(*bpm, table_meta);
+	ASSERT_NE(table_heap->GetPaxLayout(), nullptr);
+	// every 100th name is long enough to go to overflow pages
+	auto make_name = [](int i) { return std::string(i % 100 == 0 ? 1500 : i % 20, 'a' + i % 26); };
+	std::vector<Tuple> tuples;
+	std::vector<RID> rids;
+	for (int i = 0; i < tuple_count; i++) {
+		tuples.push_back(Tuple({Value(db::TypeId::INTEGER, i), Value(db::TypeId::VARCHAR, make_name(i)),
+		                        Value(db::TypeId::BOOLEAN, static_cast<int8_t>(i % 2)),
+		                        Value(db::TypeId::INTEGER, i * 3), Value(db::TypeId::TIMESTAMP, uint64_t(i) << 32)},
+		                       schema));
+		if (i < tuple_count / 2) {
+			auto rid = table_heap->InsertTuple(TupleMeta {false}, tuples.back());
+			ASSERT_TRUE(rid.has_value());
+			rids.push_back(*rid);
+		}
+	}
+	auto bulk_rids = table_heap->BulkInsertTuples(TupleMeta {false},
+	                                              std::vector<Tuple>(tuples.begin() + tuple_count / 2, tuples.end()));
+	rids.insert(rids.end(), bulk_rids.begin(), bulk_rids.end());
+
+	// tuples read back serialize as they were inserted, apart from the overflowed names
+	for (int i = 0; i < tuple_count; i += 7) {
+		auto [meta, tuple] = *table_heap->GetTuple(rids[i]);
+		ASSERT_FALSE(meta.is_deleted_);
+		ASSERT_EQ(tuple.GetValue(schema, 1).GetAs<std::string>(), make_name(i));
+		if (i % 100 != 0) {
+			ASSERT_EQ(tuple.GetStorageSize(), tuples[i].GetStorageSize());
+			ASSERT_EQ(std::memcmp(tuple.GetData(), tuples[i].GetData(), tuple.GetStorageSize()), 0);
+		}
+	}
+	for (int i = 0; i < tuple_count; i += 3) {
+		table_heap->UpdateTupleMeta(TupleMeta {true}, rids[i]);
+	}
+
+	// a scan of the views reads the values in place
+	auto it = table_heap->MakeIterator();
+	int scanned = 0;
+	for (auto batch = it.NextBatch(); !batch.empty(); batch = it.NextBatch()) {
+		for (const auto &view : batch) {
+			auto id = view.GetValue(schema, 0).GetAs<int32_t>();
+			ASSERT_NE(id % 3, 0);
+			ASSERT_EQ(view.GetValue(schema, 3).GetAs<int32_t>(), id * 3);
+			ASSERT_EQ(view.GetValue(schema, 4).GetAs<uint64_t>(), uint64_t(id) << 32);
+			ASSERT_EQ(view.IsOverflowed(schema.GetColumn(1)), id % 100 == 0);
+			ASSERT_EQ(view.ToTuple().GetValue(schema, 1).GetAs<std::string>(), make_name(id));
+			scanned++;
+		}
+	}
+	ASSERT_EQ(scanned, tuple_count - (tuple_count + 2) / 3);
+
+	// a column batch holds the values of a page as dense arrays
+	auto column_it = table_heap->MakeIterator();
+	int64_t amount_sum = 0;
+	int64_t expected_sum = 0;
+	int pages = 0;
+	for (auto *batch = &column_it.NextColumnBatch({0, 3, 2}); batch->Size() > 0;
+	     batch = &column_it.NextColumnBatch({0, 3, 2})) {
+		auto ids = batch->GetColumn<int32_t>(0);
+		auto amounts = batch->GetColumn<int32_t>(1);
+		auto actives = batch->GetColumn<int8_t>(2);
+		for (size_t i = 0; i < batch->Size(); i++) {
+			ASSERT_EQ(batch->metas_[i].is_deleted_, ids[i] % 3 == 0);
+			ASSERT_EQ(actives[i], ids[i] % 2);
+			ASSERT_EQ(RID(batch->page_id_, batch->begin_slot_ + i), rids[ids[i]]);
+			amount_sum += batch->metas_[i].is_deleted_ ? 0 : amounts[i];
+		}
+		pages++;
+	}
+	for (int i = 0; i < tuple_count; i++) {
+		expected_sum += i % 3 == 0 ? 0 : i * 3;
+	}
+	ASSERT_EQ(amount_sum, expected_sum);
+	ASSERT_GE(pages, tuple_count / table_heap->GetPaxLayout()->GetCapacity());
+	// slots of a PAX page are not compacted
+	ASSERT_EQ(table_heap->Vacuum(0).pages_compacted_, 0);
+}
 } // namespace db
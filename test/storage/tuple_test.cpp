@@ -29,3 +29,31 @@ TEST(StorageTest, TupleTest2) {
 
 	EXPECT_THROW(db::Tuple({v1, v2}, schema), std::runtime_error);
 }
+
+TEST(StorageTest, TupleViewTest) {
+	auto schema =
+	    db::Schema({db::Column("user_id", db::TypeId::INTEGER), db::Column("user_name", db::TypeId::VARCHAR, 40)});
+	auto make_tuple = [&](int32_t id, const std::string &name) {
+		return db::Tuple({db::Value(db::TypeId::INTEGER, id), db::Value(db::TypeId::VARCHAR, name)}, schema);
+	};
+	auto tuple = make_tuple(7, "gavin");
+	tuple.SetRid(db::RID({0, 3}, 5));
+
+	// a view of bytes somewhere else reads the same columns
+	std::vector<char> storage(tuple.GetStorageSize());
+	tuple.SerializeTo(storage.data());
+	db::TupleView view(db::const_data_ptr_cast(storage.data()), storage.size(), tuple.GetRid());
+	ASSERT_EQ(view.GetValue(schema, 0).GetAs<int32_t>(), 7);
+	ASSERT_EQ(view.ToString(schema), "(7, gavin)");
+	ASSERT_EQ(db::TupleView(tuple).ToString(schema), tuple.ToString(schema));
+
+	auto copy = view.ToTuple();
+	ASSERT_EQ(copy.ToString(schema), "(7, gavin)");
+	ASSERT_TRUE(copy.GetRid() == tuple.GetRid());
+	// copying a view into a tuple with a large enough buffer does not reallocate it
+	auto short_tuple = make_tuple(8, "g");
+	const auto *buffer = copy.GetData();
+	db::TupleView(short_tuple).CopyTo(copy);
+	ASSERT_EQ(copy.GetData(), buffer);
+	ASSERT_EQ(copy.ToString(schema), "(8, g)");
+}